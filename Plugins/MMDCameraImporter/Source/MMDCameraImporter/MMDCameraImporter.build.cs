@@ -1,5 +1,6 @@
 ﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class MMDCameraImporter : ModuleRules
@@ -11,6 +12,8 @@ public class MMDCameraImporter : ModuleRules
         PublicIncludePaths.AddRange(
             new string[]
             {
+                // engine independent VMD core, header only
+                Path.Combine(ModuleDirectory, "..", "ThirdParty", "VmdCore", "include"),
                 // ... add public include paths required here ...
             }
         );
@@ -52,6 +55,10 @@ public class MMDCameraImporter : ModuleRules
                 "DesktopPlatform",
                 "CinematicCamera",
                 "MovieSceneTracks",
+                "LevelSequence",
+                "AssetTools",
+                "AssetRegistry",
+                "Json",
                 // ... add private dependencies that you statically link with here ...	
             }
         );
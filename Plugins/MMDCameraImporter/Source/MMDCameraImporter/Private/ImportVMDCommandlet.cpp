@@ -0,0 +1,234 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ImportVMDCommandlet.h"
+
+#include "FileHelpers.h"
+#include "LevelSequence.h"
+#include "MMDCameraImporter.h"
+#include "MMDUserImportVMDSettings.h"
+#include "VMDImportCache.h"
+#include "VMDImporter.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "Sections/MovieSceneSubSection.h"
+
+namespace
+{
+	struct FCommandletFileResult
+	{
+		FString FilePath;
+		bool bIsSuccess = false;
+		FString Error;
+
+		FVmdComputedCamera ComputedCamera;
+		uint32 LastFrameNumber = 0;
+		double ParseSeconds = 0.0;
+		double ComputeSeconds = 0.0;
+	};
+}
+
+UImportVmdCommandlet::UImportVmdCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Import VMD camera motion into a level sequence");
+	HelpUsage = TEXT("-run=ImportVmd -Path=<file or directory> -Sequence=<level sequence object path> [-<Setting>=<Value> ...] [-CreateShotPerFile] [-NoSave]");
+}
+
+int32 UImportVmdCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FString* Path = ParamVals.Find(TEXT("Path"));
+	const FString* SequencePath = ParamVals.Find(TEXT("Sequence"));
+	if (Path == nullptr || SequencePath == nullptr)
+	{
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("Usage: %s"), *HelpUsage);
+		return 1;
+	}
+
+	TArray<FString> FilePaths;
+	bool bIsDirectory = false;
+	if (!CollectFiles(*Path, FilePaths, bIsDirectory))
+	{
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("No VMD file found at %s"), **Path);
+		return 1;
+	}
+
+	ULevelSequence* Sequence = LoadObject<ULevelSequence>(nullptr, **SequencePath);
+	if (Sequence == nullptr || Sequence->GetMovieScene() == nullptr)
+	{
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("Can't load level sequence(%s)"), **SequencePath);
+		return 1;
+	}
+
+	UMmdUserImportVmdSettings* ImportVmdSettings = NewObject<UMmdUserImportVmdSettings>(GetTransientPackage());
+	ApplySettingsOverrides(ParamVals, Switches, ImportVmdSettings);
+
+	const FVmdCameraImportParams ImportParams = FVmdCameraImportParams::Make(Sequence->GetMovieScene(), ImportVmdSettings);
+
+	// a directory would overwrite the same sequence over and over, so every file gets its own shot
+	const bool bCreateShotPerFile = bIsDirectory || ImportVmdSettings->bCreateShotPerFile;
+
+	TArray<FCommandletFileResult> FileResults;
+	FileResults.SetNum(FilePaths.Num());
+
+	ParallelFor(FilePaths.Num(), [&FilePaths, &FileResults, &ImportParams](const int32 Index)
+	{
+		FCommandletFileResult& FileResult = FileResults[Index];
+		FileResult.FilePath = FilePaths[Index];
+
+		const double ParseStartTime = FPlatformTime::Seconds();
+
+		FVmdImporter VmdImporter;
+		VmdImporter.SetFilePath(FileResult.FilePath);
+		VmdImporter.SetReadMode(EVmdReadMode::MemoryMapped);
+
+		if (!VmdImporter.IsValidVmdFile())
+		{
+			FileResult.Error = TEXT("Invalid VMD file");
+			return;
+		}
+
+		const FVmdParseResult ParseResult = VmdImporter.ParseVmdFile(EVmdSections::Camera);
+		FileResult.ParseSeconds = FPlatformTime::Seconds() - ParseStartTime;
+
+		if (!ParseResult.bIsSuccess)
+		{
+			FileResult.Error = TEXT("Failed to read VMD file");
+			return;
+		}
+
+		if (ParseResult.CameraKeyFrames.Num() == 0)
+		{
+			FileResult.Error = TEXT("This VMD file is not camera motion");
+			return;
+		}
+
+		const double ComputeStartTime = FPlatformTime::Seconds();
+		FileResult.ComputedCamera = FVmdImportCache::ComputeVmdCamera(ParseResult.CameraKeyFrames, ImportParams);
+		FileResult.LastFrameNumber = ParseResult.CameraKeyFrames.Last().FrameNumber;
+		FileResult.ComputeSeconds = FPlatformTime::Seconds() - ComputeStartTime;
+		FileResult.bIsSuccess = true;
+	});
+
+	TArray<UPackage*> PackagesToSave;
+	PackagesToSave.Add(Sequence->GetOutermost());
+
+	int32 FailedCount = 0;
+	for (FCommandletFileResult& FileResult : FileResults)
+	{
+		if (!FileResult.bIsSuccess)
+		{
+			FailedCount += 1;
+			UE_LOG(LogMMDCameraImporter, Warning, TEXT("%s: %s"), *FileResult.FilePath, *FileResult.Error);
+			continue;
+		}
+
+		const double CommitStartTime = FPlatformTime::Seconds();
+
+		UMovieSceneSequence* TargetSequence = Sequence;
+		if (bCreateShotPerFile)
+		{
+			const UMovieSceneSubSection* ShotSection = FVmdImporter::CreateShotSequence(FileResult.FilePath, FileResult.LastFrameNumber, Sequence);
+			if (ShotSection == nullptr)
+			{
+				FailedCount += 1;
+				UE_LOG(LogMMDCameraImporter, Warning, TEXT("%s: Failed to create shot"), *FileResult.FilePath);
+				continue;
+			}
+
+			TargetSequence = ShotSection->GetSequence();
+			PackagesToSave.Add(TargetSequence->GetOutermost());
+		}
+
+		FVmdImporter::ImportComputedVmdCameraAsSpawnables(FileResult.ComputedCamera, TargetSequence, ImportParams);
+
+		UE_LOG(
+			LogMMDCameraImporter,
+			Display,
+			TEXT("%s: parse %.2f ms, compute %.2f ms, commit %.2f ms, %d of %d keys"),
+			*FileResult.FilePath,
+			FileResult.ParseSeconds * 1000.0,
+			FileResult.ComputeSeconds * 1000.0,
+			(FPlatformTime::Seconds() - CommitStartTime) * 1000.0,
+			FileResult.ComputedCamera.KeyReduction.KeysAfter,
+			FileResult.ComputedCamera.KeyReduction.KeysBefore);
+	}
+
+	if (!Switches.Contains(TEXT("NoSave")) && FailedCount != FileResults.Num())
+	{
+		if (!UEditorLoadingAndSavingUtils::SavePackages(PackagesToSave, false))
+		{
+			UE_LOG(LogMMDCameraImporter, Error, TEXT("Failed to save %s"), **SequencePath);
+			return 1;
+		}
+	}
+
+	UE_LOG(LogMMDCameraImporter, Display, TEXT("Imported %d of %d VMD files"), FileResults.Num() - FailedCount, FileResults.Num());
+
+	return FailedCount == 0 ? 0 : 1;
+}
+
+void UImportVmdCommandlet::ApplySettingsOverrides(const TMap<FString, FString>& ParamVals, const TArray<FString>& Switches, UMmdUserImportVmdSettings* ImportVmdSettings)
+{
+	for (TFieldIterator<FProperty> It(UMmdUserImportVmdSettings::StaticClass()); It; ++It)
+	{
+		FProperty* Property = *It;
+		const FString PropertyName = Property->GetName();
+
+		const FString* Value = ParamVals.Find(PropertyName);
+
+		// bool settings can be given as a switch, -bAddMotionBlurKey or -AddMotionBlurKey
+		const bool bIsBoolSwitch = Property->IsA<FBoolProperty>() &&
+			(Switches.Contains(PropertyName) || Switches.Contains(PropertyName.RightChop(1)));
+
+		if (Value == nullptr && !bIsBoolSwitch)
+		{
+			continue;
+		}
+
+		const FString Text = Value != nullptr ? *Value : TEXT("True");
+		void* PropertyValue = Property->ContainerPtrToValuePtr<void>(ImportVmdSettings);
+
+#if ENGINE_MAJOR_VERSION < 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION == 0)
+		const TCHAR* Result = Property->ImportText(*Text, PropertyValue, PPF_None, ImportVmdSettings);
+#else
+		const TCHAR* Result = Property->ImportText_Direct(*Text, PropertyValue, ImportVmdSettings, PPF_None);
+#endif
+		if (Result == nullptr)
+		{
+			UE_LOG(LogMMDCameraImporter, Warning, TEXT("Invalid value for %s: %s"), *PropertyName, *Text);
+			continue;
+		}
+
+		UE_LOG(LogMMDCameraImporter, Display, TEXT("%s = %s"), *PropertyName, *Text);
+	}
+}
+
+bool UImportVmdCommandlet::CollectFiles(const FString& InPath, TArray<FString>& OutFilePaths, bool& bOutIsDirectory)
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	bOutIsDirectory = FileManager.DirectoryExists(*InPath);
+	if (bOutIsDirectory)
+	{
+		FileManager.FindFilesRecursive(OutFilePaths, *InPath, TEXT("*.vmd"), true, false);
+
+		// stable shot order regardless of the file system
+		OutFilePaths.Sort();
+	}
+	else if (FileManager.FileExists(*InPath))
+	{
+		OutFilePaths.Add(InPath);
+	}
+
+	return OutFilePaths.Num() != 0;
+}
@@ -11,6 +11,7 @@
 #include "MovieSceneToolHelpers.h"
 #include "ToolMenus.h"
 #include "VMDImporter.h"
+#include "VMDImportTask.h"
 #include "DesktopPlatformModule.h"
 #include "IDesktopPlatform.h"
 #include "Runtime/Launch/Resources/Version.h"
@@ -23,7 +24,7 @@ DEFINE_LOG_CATEGORY(LogMMDCameraImporter);
 class SMovieSceneImportVmdSettings final : public SCompoundWidget, public FGCObject
 {
 	SLATE_BEGIN_ARGS(SMovieSceneImportVmdSettings) { }
-		SLATE_ARGUMENT(FString, ImportFilename)
+		SLATE_ARGUMENT(TArray<FString>, ImportFilenames)
 		SLATE_ARGUMENT(UMovieSceneSequence*, Sequence)
 		SLATE_ARGUMENT(ISequencer*, Sequencer)
 	SLATE_END_ARGS()
@@ -65,7 +66,7 @@ class SMovieSceneImportVmdSettings final : public SCompoundWidget, public FGCObj
 
 			];
 
-		ImportFilename = InArgs._ImportFilename;
+		ImportFilenames = InArgs._ImportFilenames;
 		Sequence = InArgs._Sequence;
 		Sequencer = InArgs._Sequencer;
 
@@ -88,15 +89,29 @@ private:
 	FReply OnImportVmdClicked()
 	{
 		const UMmdUserImportVmdSettings* ImportVmdSettings = GetMutableDefault<UMmdUserImportVmdSettings>();
-		FEditorDirectories::Get().SetLastDirectory(ELastDirectory::GENERIC_IMPORT, FPaths::GetPath(ImportFilename)); // Save path as default for next time.
+		FEditorDirectories::Get().SetLastDirectory(ELastDirectory::GENERIC_IMPORT, FPaths::GetPath(ImportFilenames[0])); // Save path as default for next time.
 
 		if (!Sequence || !Sequence->GetMovieScene() || Sequence->GetMovieScene()->IsReadOnly())
 		{
 			return FReply::Unhandled();
 		}
 
+		// batches always run in the background, so every file is parsed concurrently
+		if (ImportVmdSettings->bImportInBackground || 1 < ImportFilenames.Num() || ImportVmdSettings->bCreateShotPerFile)
+		{
+			FVmdImportTask::Launch(ImportFilenames, Sequence, *Sequencer, ImportVmdSettings);
+
+			if (const TSharedPtr<SWindow> Window = FSlateApplication::Get().FindWidgetWindow(AsShared()); Window.IsValid())
+			{
+				Window->RequestDestroyWindow();
+			}
+
+			return FReply::Handled();
+		}
+
 		FVmdImporter VmdImporter;
-		VmdImporter.SetFilePath(ImportFilename);
+		VmdImporter.SetFilePath(ImportFilenames[0]);
+		VmdImporter.SetReadMode(EVmdReadMode::MemoryMapped);
 
 		if (!VmdImporter.IsValidVmdFile())
 		{
@@ -105,7 +120,7 @@ private:
 
 		const FScopedTransaction Transaction(LOCTEXT("ImportVMDTransaction", "Import VMD"));
 		
-		const FVmdParseResult ParseResult = VmdImporter.ParseVmdFile();
+		const FVmdParseResult ParseResult = VmdImporter.ParseVmdFile(EVmdSections::Camera);
 
 		if (!ParseResult.bIsSuccess)
 		{
@@ -129,7 +144,7 @@ private:
 	}
 
 	TSharedPtr<IDetailsView> DetailView;
-	FString ImportFilename;
+	TArray<FString> ImportFilenames;
 	// ReSharper disable once CppUninitializedNonStaticDataMember
 	UMovieSceneSequence* Sequence;
 	// ReSharper disable once CppUninitializedNonStaticDataMember
@@ -258,7 +273,7 @@ bool FMmdCameraImporterModule::ImportVmdWithDialog(UMovieSceneSequence* InSequen
 			FEditorDirectories::Get().GetLastDirectory(ELastDirectory::GENERIC_IMPORT),
 			TEXT(""),
 			*ExtensionStr,
-			EFileDialogFlags::None,
+			EFileDialogFlags::Multiple,
 			OpenFileNames
 		);
 	}
@@ -284,7 +299,7 @@ bool FMmdCameraImporterModule::ImportVmdWithDialog(UMovieSceneSequence* InSequen
 		.SupportsMinimize(false);
 
 	const TSharedRef<SMovieSceneImportVmdSettings> DialogWidget = SNew(SMovieSceneImportVmdSettings)
-		.ImportFilename(OpenFileNames[0])
+		.ImportFilenames(OpenFileNames)
 		.Sequence(InSequence)
 		.Sequencer(&InSequencer);
 	Window->SetContent(DialogWidget);
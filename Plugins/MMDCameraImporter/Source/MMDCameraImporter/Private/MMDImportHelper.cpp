@@ -2,40 +2,107 @@
 
 #include "MMDImportHelper.h"
 
-#include "ShiftJisConvertTable.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "VmdCore/VmdShiftJis.h"
 
 FString FMmdImportHelper::ShiftJisToFString(const uint8* InBuffer, const int32 InSize)
 {
-	FString Output;
-	Output.Reserve(3 * InSize); //ShiftJis won't give 4byte UTF8, so max. 3 byte per input char are needed
-	
-	PTRINT IndexInput = 0;
+	if (InSize <= 0)
+	{
+		return FString();
+	}
+
+	// decode on the stack for typical name lengths, so the string is allocated once at its final size
+	TArray<TCHAR, TInlineAllocator<64>> Buffer;
+	Buffer.SetNumUninitialized(InSize);
+
+	const int32 Length = VmdCore::DecodeShiftJis(InBuffer, InSize, Buffer.GetData());
+	return Length != 0 ? FString(Length, Buffer.GetData()) : FString();
+}
+
+void FMmdImportHelper::ShiftJisToStringPool(const uint8* InBuffer, const int32 InCount, const int32 InStride, const int32 InFieldSize, FMmdStringPool& OutPool)
+{
+	OutPool.Chars.Reset();
+	OutPool.Offsets.Reset();
+
+	// a name never decodes to more code units than its field size
+	OutPool.Chars.SetNumUninitialized(InCount * InFieldSize);
+	OutPool.Offsets.SetNumUninitialized(InCount + 1);
+
+	int32 Offset = 0;
+	for (int32 i = 0; i < InCount; ++i)
+	{
+		const uint8* Field = InBuffer + static_cast<int64>(i) * InStride;
+
+		OutPool.Offsets[i] = Offset;
+		Offset += VmdCore::DecodeShiftJis(Field, VmdCore::GetFixedStringLength(Field, InFieldSize), OutPool.Chars.GetData() + Offset);
+	}
+	OutPool.Offsets[InCount] = Offset;
+
+	// keeps the allocation, the pool is usually short lived
+#if ENGINE_MAJOR_VERSION < 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION < 5)
+	OutPool.Chars.SetNumUninitialized(Offset, false);
+#else
+	OutPool.Chars.SetNumUninitialized(Offset, EAllowShrinking::No);
+#endif
+}
+
+void FMmdImportHelper::RadixSortIndices(const TArray<uint32>& Keys, TArray<int32>& OutPermutation)
+{
+	constexpr int32 DigitBits = 8;
+	constexpr int32 DigitCount = sizeof(uint32) * 8 / DigitBits;
+	constexpr int32 BucketCount = 1 << DigitBits;
+
+	const int32 Num = Keys.Num();
 
-	while (IndexInput < InSize)
+	OutPermutation.SetNumUninitialized(Num);
+	for (int32 i = 0; i < Num; ++i)
 	{
-		const uint8 ArraySection = InBuffer[IndexInput] >> 4;
+		OutPermutation[i] = i;
+	}
 
-		PTRINT ArrayOffset;
-		if (ArraySection == 0x8) ArrayOffset = 0x100; //these are two-byte shiftjis
-		else if (ArraySection == 0x9) ArrayOffset = 0x1100;
-		else if (ArraySection == 0xE) ArrayOffset = 0x2100;
-		else ArrayOffset = 0; //this is one byte shiftjis
+	if (Num == 0)
+	{
+		return;
+	}
 
-		//determining real array offset
-		if (ArrayOffset)
+	// histograms of every digit are built in a single pass
+	uint32 Histograms[DigitCount][BucketCount] = {};
+	for (const uint32 Key : Keys)
+	{
+		for (int32 Digit = 0; Digit < DigitCount; ++Digit)
 		{
-			ArrayOffset += (InBuffer[IndexInput] & 0xf) << 8;
-			IndexInput += 1;
-			if (IndexInput >= InSize) break;
+			Histograms[Digit][(Key >> (Digit * DigitBits)) & (BucketCount - 1)] += 1;
 		}
-		ArrayOffset += InBuffer[IndexInput];
-		IndexInput += 1;
-		ArrayOffset <<= 1;
-		
-		const uint16 UnicodeValue = (GShiftJisConvertTable[ArrayOffset] << 8) | GShiftJisConvertTable[ArrayOffset + 1];
-		Output.AppendChar(UnicodeValue);
 	}
 
-	Output.Shrink();
-	return Output;
+	TArray<int32> Scratch;
+	Scratch.SetNumUninitialized(Num);
+
+	for (int32 Digit = 0; Digit < DigitCount; ++Digit)
+	{
+		uint32* Histogram = Histograms[Digit];
+		const int32 Shift = Digit * DigitBits;
+
+		// frame numbers rarely use the upper bytes, a digit shared by every key doesn't reorder anything
+		if (Histogram[(Keys[0] >> Shift) & (BucketCount - 1)] == static_cast<uint32>(Num))
+		{
+			continue;
+		}
+
+		uint32 Offset = 0;
+		for (int32 Bucket = 0; Bucket < BucketCount; ++Bucket)
+		{
+			const uint32 Count = Histogram[Bucket];
+			Histogram[Bucket] = Offset;
+			Offset += Count;
+		}
+
+		for (const int32 Index : OutPermutation)
+		{
+			Scratch[Histogram[(Keys[Index] >> Shift) & (BucketCount - 1)]++] = Index;
+		}
+
+		Swap(OutPermutation, Scratch);
+	}
 }
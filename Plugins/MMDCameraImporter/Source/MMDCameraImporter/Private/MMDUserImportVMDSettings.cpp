@@ -15,6 +15,19 @@ UMmdUserImportVmdSettings::UMmdUserImportVmdSettings(const FObjectInitializer& I
 	ImportUniformScale = 10.0f;
 	CameraCutImportType = ECameraCutImportType::OneFrameInterval;
 	CameraCount = 2;
+	CurveImportType = ECurveImportType::WeightedTangent;
 	bAddMotionBlurKey = false;
 	MotionBlurAmount = 0.5f;
+	CameraCutPositionTolerance = 0.0f;
+	CameraCutAngleTolerance = 0.0f;
+	CameraCutViewAngleTolerance = 0.0f;
+	CameraCutMaxFrameGap = 1;
+	KeyReductionType = EKeyReductionType::Lossless;
+	PositionTolerance = 0.1f;
+	AngleTolerance = 0.1f;
+	FocalLengthTolerance = 0.1f;
+	bImportInBackground = false;
+	bCreateShotPerFile = false;
+	bReimportExisting = false;
+	bUseImportCache = true;
 }
@@ -0,0 +1,712 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MMDCameraImporter.h"
+#include "MMDImportHelper.h"
+#include "VMDImportCache.h"
+#include "VMDImporter.h"
+#include "VMDSyntheticWriter.h"
+#include "HAL/IConsoleManager.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tasks/Task.h"
+#include "VmdCore/VmdCameraCurves.h"
+#include "VmdCore/VmdShiftJis.h"
+
+namespace
+{
+	struct FVmdBenchmarkResult
+	{
+		FString Name;
+		int32 Iterations = 0;
+		int64 Bytes = 0;
+		int64 Keys = 0;
+		double MinSeconds = 0.0;
+		double MedianSeconds = 0.0;
+		// growth of the process memory while the case runs once, -1 if the case doesn't measure it
+		int64 PeakUsedBytes = -1;
+
+		double GetMegabytesPerSecond() const
+		{
+			return MedianSeconds > 0.0 ? Bytes / (1024.0 * 1024.0) / MedianSeconds : 0.0;
+		}
+
+		double GetKeysPerSecond() const
+		{
+			return MedianSeconds > 0.0 ? Keys / MedianSeconds : 0.0;
+		}
+	};
+
+	template<typename FuncType>
+	FVmdBenchmarkResult RunBenchmark(const TCHAR* Name, const int32 Iterations, const int64 Bytes, const int64 Keys, FuncType&& Func)
+	{
+		// warm up file cache and allocator
+		Func();
+
+		TArray<double> Samples;
+		Samples.Reserve(Iterations);
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Func();
+			Samples.Add(FPlatformTime::Seconds() - StartTime);
+		}
+		Samples.Sort();
+
+		FVmdBenchmarkResult Result;
+		Result.Name = Name;
+		Result.Iterations = Iterations;
+		Result.Bytes = Bytes;
+		Result.Keys = Keys;
+		Result.MinSeconds = Samples[0];
+		Result.MedianSeconds = Samples[Samples.Num() / 2];
+
+		UE_LOG(
+			LogMMDCameraImporter,
+			Display,
+			TEXT("%-28s median %9.3f ms, min %9.3f ms, %9.1f MB/s, %12.0f keys/s"),
+			Name,
+			Result.MedianSeconds * 1000.0,
+			Result.MinSeconds * 1000.0,
+			Result.GetMegabytesPerSecond(),
+			Result.GetKeysPerSecond());
+
+		return Result;
+	}
+
+	// heap allocations and bytes held by the keys of a channel, each non-empty array is one allocation
+	template<typename MovieSceneChannel>
+	void AccumulateChannelAllocations(const TVmdComputedChannel<MovieSceneChannel>& ComputedChannel, int32& InOutAllocationCount, SIZE_T& InOutAllocatedSize)
+	{
+		InOutAllocationCount += ComputedChannel.CameraKeys.Max() != 0 ? 1 : 0;
+		InOutAllocatedSize += ComputedChannel.CameraKeys.GetAllocatedSize();
+		for (const auto& Keys : ComputedChannel.CameraKeys)
+		{
+			InOutAllocationCount += Keys.Max() != 0 ? 1 : 0;
+			InOutAllocatedSize += Keys.GetAllocatedSize();
+		}
+	}
+
+	/** Heap allocations the computed camera holds, the scratch arrays of ComputeVmdCamera come from FMemStack and are not part of it */
+	void GetComputedCameraAllocations(const FVmdComputedCamera& ComputedCamera, int32& OutAllocationCount, SIZE_T& OutAllocatedSize)
+	{
+		OutAllocationCount = ComputedCamera.CameraCuts.Max() != 0 ? 1 : 0;
+		OutAllocatedSize = ComputedCamera.CameraCuts.GetAllocatedSize();
+		AccumulateChannelAllocations(ComputedCamera.FocalLength, OutAllocationCount, OutAllocatedSize);
+		AccumulateChannelAllocations(ComputedCamera.MotionBlur, OutAllocationCount, OutAllocatedSize);
+		AccumulateChannelAllocations(ComputedCamera.Distance, OutAllocationCount, OutAllocatedSize);
+		AccumulateChannelAllocations(ComputedCamera.LocationX, OutAllocationCount, OutAllocatedSize);
+		AccumulateChannelAllocations(ComputedCamera.LocationY, OutAllocationCount, OutAllocatedSize);
+		AccumulateChannelAllocations(ComputedCamera.LocationZ, OutAllocationCount, OutAllocatedSize);
+		AccumulateChannelAllocations(ComputedCamera.RotationX, OutAllocationCount, OutAllocatedSize);
+		AccumulateChannelAllocations(ComputedCamera.RotationY, OutAllocationCount, OutAllocatedSize);
+		AccumulateChannelAllocations(ComputedCamera.RotationZ, OutAllocationCount, OutAllocatedSize);
+	}
+
+	/**
+	 * The part of ComputeCameraSingleChannel that goes through the channel accessors,
+	 * the mapped value of every key and the value comparisons of the camera cut branch
+	 */
+	template<typename GetValueFuncType, typename MapFuncType>
+	double AccumulateChannel(const TArray<FVmdObject::FCameraKeyFrame>& KeyFrames, GetValueFuncType&& GetValue, MapFuncType&& Map)
+	{
+		double Sum = 0.0;
+		for (int32 i = 1; i < KeyFrames.Num() - 1; ++i)
+		{
+			Sum += Map(GetValue(KeyFrames[i]));
+
+			if (GetValue(KeyFrames[i + 1]) != GetValue(KeyFrames[i]) && GetValue(KeyFrames[i]) != GetValue(KeyFrames[i - 1]))
+			{
+				Sum += 1.0;
+			}
+		}
+		return Sum;
+	}
+
+	template<typename ChannelDescriptor>
+	double AccumulateDescriptorChannel(const TArray<FVmdObject::FCameraKeyFrame>& KeyFrames, const FVmdCameraImportParams& Params)
+	{
+		using T = typename ChannelDescriptor::MovieSceneChannel::CurveValueType;
+
+		return AccumulateChannel(
+			KeyFrames,
+			[](const FVmdObject::FCameraKeyFrame& KeyFrame)
+			{
+				return ChannelDescriptor::GetValue(KeyFrame);
+			},
+			[&Params](const T Value)
+			{
+				return FVmdImporter::MapCameraValue<ChannelDescriptor::Mapping>(Value, Params);
+			});
+	}
+
+	double AccumulateFunctionChannel(
+		const TArray<FVmdObject::FCameraKeyFrame>& KeyFrames,
+		const TFunction<double(const FVmdObject::FCameraKeyFrame&)>& GetValueFunc,
+		const TFunction<double(const double)>& MapFunc
+	)
+	{
+		return AccumulateChannel(KeyFrames, GetValueFunc, MapFunc);
+	}
+
+	// the synthetic camera repeated until it has Count keys, tiles are two frames apart so they don't add camera cuts
+	TArray<FVmdObject::FCameraKeyFrame> TileCameraKeyFrames(const TArray<FVmdObject::FCameraKeyFrame>& KeyFrames, const int32 Count)
+	{
+		TArray<FVmdObject::FCameraKeyFrame> Result;
+		Result.Reserve(Count);
+
+		const uint32 TileFrames = KeyFrames.Last().FrameNumber + 2;
+		for (uint32 TileFrameOffset = 0; Result.Num() < Count; TileFrameOffset += TileFrames)
+		{
+			for (int32 i = 0; i < KeyFrames.Num() && Result.Num() < Count; ++i)
+			{
+				FVmdObject::FCameraKeyFrame& KeyFrame = Result.Add_GetRef(KeyFrames[i]);
+				KeyFrame.FrameNumber += TileFrameOffset;
+			}
+		}
+
+		return Result;
+	}
+
+	// fill a fresh channel per camera and return the total key count, either through AddKey per key like before or in bulk
+	template<typename MovieSceneChannel>
+	int32 PopulateComputedChannel(const TVmdComputedChannel<MovieSceneChannel>& ComputedChannel, const bool bBulk)
+	{
+		using FMovieSceneValue = typename MovieSceneChannel::ChannelValueType;
+
+		int32 KeyCount = 0;
+		for (const TArray<TPair<FFrameNumber, FMovieSceneValue>>& Keys : ComputedChannel.CameraKeys)
+		{
+			MovieSceneChannel Channel;
+			if (bBulk)
+			{
+				FVmdImporter::PopulateChannel(Channel, Keys);
+			}
+			else
+			{
+				TMovieSceneChannelData<FMovieSceneValue> ChannelData = Channel.GetData();
+				for (const TPair<FFrameNumber, FMovieSceneValue>& Key : Keys)
+				{
+					ChannelData.AddKey(Key.Key, Key.Value);
+				}
+			}
+			KeyCount += Channel.GetNumKeys();
+		}
+		return KeyCount;
+	}
+
+	int32 PopulateComputedCamera(const FVmdComputedCamera& ComputedCamera, const bool bBulk)
+	{
+		return PopulateComputedChannel(ComputedCamera.FocalLength, bBulk) +
+			PopulateComputedChannel(ComputedCamera.MotionBlur, bBulk) +
+			PopulateComputedChannel(ComputedCamera.Distance, bBulk) +
+			PopulateComputedChannel(ComputedCamera.LocationX, bBulk) +
+			PopulateComputedChannel(ComputedCamera.LocationY, bBulk) +
+			PopulateComputedChannel(ComputedCamera.LocationZ, bBulk) +
+			PopulateComputedChannel(ComputedCamera.RotationX, bBulk) +
+			PopulateComputedChannel(ComputedCamera.RotationY, bBulk) +
+			PopulateComputedChannel(ComputedCamera.RotationZ, bBulk);
+	}
+
+	FString WriteBenchmarkJson(const FVmdSyntheticSettings& Settings, const int64 FileSize, const TArray<FVmdBenchmarkResult>& Results)
+	{
+		FString Output;
+		const TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Output);
+
+		const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("MMDCameraImporter"));
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("plugin_version"), Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString());
+		Writer->WriteValue(TEXT("engine_version"), FEngineVersion::Current().ToString());
+		Writer->WriteValue(TEXT("platform"), FString(FPlatformProperties::IniPlatformName()));
+		Writer->WriteValue(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+
+		Writer->WriteObjectStart(TEXT("input"));
+		Writer->WriteValue(TEXT("seed"), static_cast<int64>(Settings.Seed));
+		Writer->WriteValue(TEXT("file_size"), FileSize);
+		Writer->WriteValue(TEXT("bone_keys"), Settings.BoneKeyFrameCount);
+		Writer->WriteValue(TEXT("morph_keys"), Settings.MorphKeyFrameCount);
+		Writer->WriteValue(TEXT("camera_keys"), Settings.CameraKeyFrameCount);
+		Writer->WriteValue(TEXT("light_keys"), Settings.LightKeyFrameCount);
+		Writer->WriteValue(TEXT("self_shadow_keys"), Settings.SelfShadowKeyFrameCount);
+		Writer->WriteValue(TEXT("property_keys"), Settings.PropertyKeyFrameCount);
+		Writer->WriteValue(TEXT("ik_states_per_property_key"), Settings.IkStatesPerPropertyKeyFrame);
+		Writer->WriteValue(TEXT("camera_cut_density"), Settings.CameraCutDensity);
+		Writer->WriteValue(TEXT("shuffled"), Settings.bShuffleKeyFrames);
+		Writer->WriteObjectEnd();
+
+		Writer->WriteArrayStart(TEXT("results"));
+		for (const FVmdBenchmarkResult& Result : Results)
+		{
+			Writer->WriteObjectStart();
+			Writer->WriteValue(TEXT("name"), Result.Name);
+			Writer->WriteValue(TEXT("iterations"), Result.Iterations);
+			Writer->WriteValue(TEXT("bytes"), Result.Bytes);
+			Writer->WriteValue(TEXT("keys"), Result.Keys);
+			Writer->WriteValue(TEXT("median_ms"), Result.MedianSeconds * 1000.0);
+			Writer->WriteValue(TEXT("min_ms"), Result.MinSeconds * 1000.0);
+			Writer->WriteValue(TEXT("mb_per_s"), Result.GetMegabytesPerSecond());
+			Writer->WriteValue(TEXT("keys_per_s"), Result.GetKeysPerSecond());
+			if (Result.PeakUsedBytes >= 0)
+			{
+				Writer->WriteValue(TEXT("peak_used_bytes"), Result.PeakUsedBytes);
+			}
+			Writer->WriteObjectEnd();
+		}
+		Writer->WriteArrayEnd();
+
+		Writer->WriteObjectEnd();
+		Writer->Close();
+
+		return Output;
+	}
+
+	/**
+	 * MMD.BenchmarkVmd [CameraKeys=N] [BoneKeys=N] [MorphKeys=N] [PropertyKeys=N] [IkStates=N] [CutDensity=F] [Seed=N] [Shuffle] [Iterations=N] [Output=Path]
+	 *
+	 * Run unattended with -ExecCmds="MMD.BenchmarkVmd, Quit"
+	 */
+	void RunVmdBenchmark(const TArray<FString>& Args)
+	{
+		const FString CommandLine = FString::Join(Args, TEXT(" "));
+
+		FVmdSyntheticSettings Settings;
+		FParse::Value(*CommandLine, TEXT("CameraKeys="), Settings.CameraKeyFrameCount);
+		FParse::Value(*CommandLine, TEXT("BoneKeys="), Settings.BoneKeyFrameCount);
+		FParse::Value(*CommandLine, TEXT("MorphKeys="), Settings.MorphKeyFrameCount);
+		FParse::Value(*CommandLine, TEXT("PropertyKeys="), Settings.PropertyKeyFrameCount);
+		FParse::Value(*CommandLine, TEXT("IkStates="), Settings.IkStatesPerPropertyKeyFrame);
+		FParse::Value(*CommandLine, TEXT("CutDensity="), Settings.CameraCutDensity);
+		FParse::Value(*CommandLine, TEXT("Seed="), Settings.Seed);
+		Settings.bShuffleKeyFrames = FParse::Param(*CommandLine, TEXT("Shuffle"));
+
+		int32 Iterations = 10;
+		FParse::Value(*CommandLine, TEXT("Iterations="), Iterations);
+		Iterations = FMath::Max(1, Iterations);
+
+		FString OutputPath = FPaths::ProjectSavedDir() / TEXT("MMDCameraImporter") / TEXT("Benchmark") / FDateTime::Now().ToString() + TEXT(".json");
+		FParse::Value(*CommandLine, TEXT("Output="), OutputPath);
+
+		const FString VmdPath = FPaths::ProjectIntermediateDir() / TEXT("MMDCameraImporter") / TEXT("Benchmark.vmd");
+		if (!FVmdSyntheticWriter::WriteToFile(Settings, VmdPath))
+		{
+			UE_LOG(LogMMDCameraImporter, Error, TEXT("Can't write benchmark file(%s)"), *VmdPath);
+			return;
+		}
+
+		const int64 FileSize = IFileManager::Get().FileSize(*VmdPath);
+		const int64 TotalKeys =
+			static_cast<int64>(Settings.BoneKeyFrameCount) +
+			Settings.MorphKeyFrameCount +
+			Settings.CameraKeyFrameCount +
+			Settings.LightKeyFrameCount +
+			Settings.SelfShadowKeyFrameCount +
+			Settings.PropertyKeyFrameCount;
+
+		TArray<FVmdBenchmarkResult> Results;
+
+		// runs on a worker so slow task dialogs stay disabled and don't end up in the timings
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [&]
+		{
+			for (const EVmdReadMode ReadMode : { EVmdReadMode::Archive, EVmdReadMode::MemoryMapped })
+			{
+				const TCHAR* ReadModeName = ReadMode == EVmdReadMode::Archive ? TEXT("Archive") : TEXT("MemoryMapped");
+
+				Results.Add(RunBenchmark(*FString::Printf(TEXT("IsValidVmdFile.%s"), ReadModeName), Iterations, FileSize, TotalKeys, [&VmdPath, ReadMode]
+				{
+					FVmdImporter VmdImporter;
+					VmdImporter.SetFilePath(VmdPath);
+					VmdImporter.SetReadMode(ReadMode);
+					VmdImporter.IsValidVmdFile();
+				}));
+
+				const auto Parse = [&VmdPath, ReadMode](const EVmdSections Sections)
+				{
+					FVmdImporter VmdImporter;
+					VmdImporter.SetFilePath(VmdPath);
+					VmdImporter.SetReadMode(ReadMode);
+					return VmdImporter.IsValidVmdFile() ? VmdImporter.ParseVmdFile(Sections) : FVmdParseResult();
+				};
+
+				// camera only is what the importer asks for, the other sections are skipped without being copied
+				for (const EVmdSections Sections : { EVmdSections::All, EVmdSections::Camera })
+				{
+					const TCHAR* SectionsName = Sections == EVmdSections::Camera ? TEXT(".CameraOnly") : TEXT("");
+
+					// measured before the timed runs, the peak only moves when a parse goes past the previous one
+					int64 PeakUsedBytes = 0;
+					{
+						const FPlatformMemoryStats StatsBefore = FPlatformMemory::GetStats();
+						const FVmdParseResult ParseResult = Parse(Sections);
+						const FPlatformMemoryStats StatsAfter = FPlatformMemory::GetStats();
+
+						PeakUsedBytes = FMath::Max3<int64>(
+							0,
+							static_cast<int64>(StatsAfter.PeakUsedPhysical) - static_cast<int64>(StatsBefore.PeakUsedPhysical),
+							static_cast<int64>(StatsAfter.UsedPhysical) - static_cast<int64>(StatsBefore.UsedPhysical));
+					}
+
+					FVmdBenchmarkResult Result = RunBenchmark(*FString::Printf(TEXT("ParseVmdFile.%s%s"), ReadModeName, SectionsName), Iterations, FileSize, TotalKeys, [&Parse, Sections]
+					{
+						Parse(Sections);
+					});
+
+					Result.PeakUsedBytes = PeakUsedBytes;
+					UE_LOG(LogMMDCameraImporter, Display, TEXT("%-28s %lld bytes peak memory"), *Result.Name, Result.PeakUsedBytes);
+
+					Results.Add(MoveTemp(Result));
+				}
+			}
+
+			FVmdImporter VmdImporter;
+			VmdImporter.SetFilePath(VmdPath);
+			VmdImporter.SetReadMode(EVmdReadMode::MemoryMapped);
+			if (!VmdImporter.IsValidVmdFile())
+			{
+				return;
+			}
+			const FVmdParseResult ParseResult = VmdImporter.ParseVmdFile(EVmdSections::Bone | EVmdSections::Camera);
+
+			const TArray<FVmdObject::FBoneKeyFrame>& BoneKeyFrames = ParseResult.BoneKeyFrames;
+			if (BoneKeyFrames.Num() != 0)
+			{
+				const int64 NameBytes = BoneKeyFrames.Num() * sizeof(FVmdObject::FBoneKeyFrame::BoneName);
+
+				Results.Add(RunBenchmark(TEXT("ShiftJisToFString.BoneNames"), Iterations, NameBytes, BoneKeyFrames.Num(), [&BoneKeyFrames]
+				{
+					for (const FVmdObject::FBoneKeyFrame& KeyFrame : BoneKeyFrames)
+					{
+						FMmdImportHelper::ShiftJisToFString(KeyFrame.BoneName, VmdCore::GetFixedStringLength(KeyFrame.BoneName, sizeof KeyFrame.BoneName));
+					}
+				}));
+
+				Results.Add(RunBenchmark(TEXT("ShiftJisToStringPool.BoneNames"), Iterations, NameBytes, BoneKeyFrames.Num(), [&BoneKeyFrames]
+				{
+					FMmdStringPool Pool;
+					FMmdImportHelper::DecodeNames(BoneKeyFrames, &FVmdObject::FBoneKeyFrame::BoneName, Pool);
+				}));
+
+				Results.Add(RunBenchmark(TEXT("FVmdNameTable.BoneNames"), Iterations, NameBytes, BoneKeyFrames.Num(), [&BoneKeyFrames]
+				{
+					FVmdNameTable NameTable;
+					TArray<uint16> NameIds;
+					NameTable.InternAll(BoneKeyFrames, &FVmdObject::FBoneKeyFrame::BoneName, NameIds);
+				}));
+			}
+
+			const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames = ParseResult.CameraKeyFrames;
+			if (CameraKeyFrames.Num() == 0)
+			{
+				return;
+			}
+
+			const int64 CameraBytes = CameraKeyFrames.Num() * sizeof(FVmdObject::FCameraKeyFrame);
+
+			FVmdCameraImportParams Params;
+			Params.SampleRate = FFrameRate(30, 1);
+			Params.FrameRate = FFrameRate(24000, 1);
+			Params.ImportUniformScale = 10.0f;
+			Params.CameraCutImportType = ECameraCutImportType::OneFrameInterval;
+			Params.CameraCount = 2;
+			Params.CurveImportType = ECurveImportType::WeightedTangent;
+			Params.bAddMotionBlurKey = true;
+			Params.MotionBlurAmount = 0.5f;
+			Params.SensorWidth = 24.0f;
+			Params.SensorHeight = 13.5f;
+			Params.KeyReductionType = EKeyReductionType::Lossless;
+			Params.PositionTolerance = 0.1f;
+			Params.AngleTolerance = 0.1f;
+			Params.FocalLengthTolerance = 0.1f;
+			Params.CameraCutPositionTolerance = 0.0f;
+			Params.CameraCutAngleTolerance = 0.0f;
+			Params.CameraCutViewAngleTolerance = 0.0f;
+			Params.CameraCutMaxFrameGap = 1;
+			Params.bParallelChannels = true;
+			Params.bReimportExisting = false;
+			Params.bUseImportCache = false;
+
+			Results.Add(RunBenchmark(TEXT("ComputeCameraCuts"), Iterations, CameraBytes, CameraKeyFrames.Num(), [&CameraKeyFrames, &Params]
+			{
+				FMemMark Mark(FMemStack::Get());
+				TVmdScratchArray<float> ChannelValues;
+				ChannelValues.SetNumUninitialized(VmdCore::GCameraChannelCount * CameraKeyFrames.Num());
+				VmdCore::TransposeCameraKeyFrames(CameraKeyFrames.GetData(), CameraKeyFrames.Num(), ChannelValues.GetData());
+
+				TVmdScratchArray<int32> CutIndices;
+				FVmdImporter::DetectCameraCuts(CameraKeyFrames, ChannelValues.GetData(), Params, CutIndices);
+				FVmdImporter::ComputeCameraCutRanges(CameraKeyFrames, CutIndices);
+			}));
+
+			Results.Add(RunBenchmark(TEXT("ComputeVmdCamera"), Iterations, CameraBytes, CameraKeyFrames.Num(), [&CameraKeyFrames, &Params]
+			{
+				FVmdImporter::ComputeVmdCamera(CameraKeyFrames, Params);
+			}));
+
+			FVmdCameraImportParams ToleranceParams = Params;
+			ToleranceParams.KeyReductionType = EKeyReductionType::Tolerance;
+
+			Results.Add(RunBenchmark(TEXT("ComputeVmdCamera.Tolerance"), Iterations, CameraBytes, CameraKeyFrames.Num(), [&CameraKeyFrames, &ToleranceParams]
+			{
+				FVmdImporter::ComputeVmdCamera(CameraKeyFrames, ToleranceParams);
+			}));
+
+			FVmdCameraImportParams SerialParams = Params;
+			SerialParams.bParallelChannels = false;
+
+			Results.Add(RunBenchmark(TEXT("ComputeVmdCamera.Serial"), Iterations, CameraBytes, CameraKeyFrames.Num(), [&CameraKeyFrames, &SerialParams]
+			{
+				FVmdImporter::ComputeVmdCamera(CameraKeyFrames, SerialParams);
+			}));
+
+			// heap allocations left in the result of one import, the scratch arrays come from the thread's FMemStack
+			for (const ECurveImportType CurveImportType : { ECurveImportType::WeightedTangent, ECurveImportType::BakeLinear })
+			{
+				for (const EKeyReductionType KeyReductionType : { EKeyReductionType::Lossless, EKeyReductionType::Tolerance })
+				{
+					FVmdCameraImportParams AllocationParams = SerialParams;
+					AllocationParams.KeyReductionType = KeyReductionType;
+					AllocationParams.CurveImportType = CurveImportType;
+
+					const FVmdComputedCamera ComputedCamera = FVmdImporter::ComputeVmdCamera(CameraKeyFrames, AllocationParams);
+
+					int32 AllocationCount = 0;
+					SIZE_T AllocatedSize = 0;
+					GetComputedCameraAllocations(ComputedCamera, AllocationCount, AllocatedSize);
+
+					UE_LOG(
+						LogMMDCameraImporter,
+						Display,
+						TEXT("ComputeVmdCamera allocations(KeyReductionType %d, CurveImportType %d): %d arrays, %llu bytes for %d output keys"),
+						static_cast<int32>(KeyReductionType),
+						static_cast<int32>(CurveImportType),
+						AllocationCount,
+						static_cast<uint64>(AllocatedSize),
+						ComputedCamera.KeyReduction.KeysAfter);
+				}
+			}
+
+			// channel accessors through TFunction like before the descriptors, against the compile time descriptors
+			const TArray<FVmdObject::FCameraKeyFrame> LongCameraKeyFrames = TileCameraKeyFrames(CameraKeyFrames, 100000);
+			const int64 LongCameraBytes = LongCameraKeyFrames.Num() * sizeof(FVmdObject::FCameraKeyFrame);
+			double AccessorSum = 0.0;
+
+			Results.Add(RunBenchmark(TEXT("ChannelAccess.TFunction.100k"), Iterations, LongCameraBytes, LongCameraKeyFrames.Num(), [&LongCameraKeyFrames, &Params, &AccessorSum]
+			{
+				const float UniformScale = Params.ImportUniformScale;
+				const auto Scale = [UniformScale](const double Value) { return Value * UniformScale; };
+				const auto Degrees = [](const double Value) { return FMath::RadiansToDegrees(Value); };
+
+				AccessorSum += AccumulateFunctionChannel(LongCameraKeyFrames, [](const FVmdObject::FCameraKeyFrame& KeyFrame) { return KeyFrame.ViewAngle; },
+					[&Params](const double Value) { return FVmdImporter::MapCameraValue<EVmdCameraUnitMapping::FocalLength>(static_cast<float>(Value), Params); });
+				AccessorSum += AccumulateFunctionChannel(LongCameraKeyFrames, [](const FVmdObject::FCameraKeyFrame& KeyFrame) { return KeyFrame.Distance; }, Scale);
+				AccessorSum += AccumulateFunctionChannel(LongCameraKeyFrames, [](const FVmdObject::FCameraKeyFrame& KeyFrame) { return KeyFrame.Position[2]; }, Scale);
+				AccessorSum += AccumulateFunctionChannel(LongCameraKeyFrames, [](const FVmdObject::FCameraKeyFrame& KeyFrame) { return KeyFrame.Position[0]; }, Scale);
+				AccessorSum += AccumulateFunctionChannel(LongCameraKeyFrames, [](const FVmdObject::FCameraKeyFrame& KeyFrame) { return KeyFrame.Position[1]; }, Scale);
+				AccessorSum += AccumulateFunctionChannel(LongCameraKeyFrames, [](const FVmdObject::FCameraKeyFrame& KeyFrame) { return KeyFrame.Rotation[2]; }, Degrees);
+				AccessorSum += AccumulateFunctionChannel(LongCameraKeyFrames, [](const FVmdObject::FCameraKeyFrame& KeyFrame) { return KeyFrame.Rotation[0]; }, Degrees);
+				AccessorSum += AccumulateFunctionChannel(LongCameraKeyFrames, [](const FVmdObject::FCameraKeyFrame& KeyFrame) { return KeyFrame.Rotation[1]; },
+					[](const double Value) { return -FMath::RadiansToDegrees(Value); });
+			}));
+
+			Results.Add(RunBenchmark(TEXT("ChannelAccess.Descriptor.100k"), Iterations, LongCameraBytes, LongCameraKeyFrames.Num(), [&LongCameraKeyFrames, &Params, &AccessorSum]
+			{
+				AccessorSum += AccumulateDescriptorChannel<FVmdFocalLengthChannel>(LongCameraKeyFrames, Params);
+				AccessorSum += AccumulateDescriptorChannel<FVmdDistanceChannel>(LongCameraKeyFrames, Params);
+				AccessorSum += AccumulateDescriptorChannel<FVmdLocationXChannel>(LongCameraKeyFrames, Params);
+				AccessorSum += AccumulateDescriptorChannel<FVmdLocationYChannel>(LongCameraKeyFrames, Params);
+				AccessorSum += AccumulateDescriptorChannel<FVmdLocationZChannel>(LongCameraKeyFrames, Params);
+				AccessorSum += AccumulateDescriptorChannel<FVmdRotationXChannel>(LongCameraKeyFrames, Params);
+				AccessorSum += AccumulateDescriptorChannel<FVmdRotationYChannel>(LongCameraKeyFrames, Params);
+				AccessorSum += AccumulateDescriptorChannel<FVmdRotationZChannel>(LongCameraKeyFrames, Params);
+			}));
+
+			Results.Add(RunBenchmark(TEXT("ComputeVmdCamera.100k"), Iterations, LongCameraBytes, LongCameraKeyFrames.Num(), [&LongCameraKeyFrames, &Params]
+			{
+				FVmdImporter::ComputeVmdCamera(LongCameraKeyFrames, Params);
+			}));
+
+			// channel population of a long camera split across four cameras, per key AddKey against one Set per channel
+			{
+				const TArray<FVmdObject::FCameraKeyFrame> PopulateCameraKeyFrames = TileCameraKeyFrames(CameraKeyFrames, 60000);
+				const int64 PopulateCameraBytes = PopulateCameraKeyFrames.Num() * sizeof(FVmdObject::FCameraKeyFrame);
+
+				FVmdCameraImportParams PopulateParams = Params;
+				PopulateParams.CameraCount = 4;
+				const FVmdComputedCamera PopulateCamera = FVmdImporter::ComputeVmdCamera(PopulateCameraKeyFrames, PopulateParams);
+
+				Results.Add(RunBenchmark(TEXT("PopulateChannels.AddKey.60k"), Iterations, PopulateCameraBytes, PopulateCameraKeyFrames.Num(), [&PopulateCamera, &AccessorSum]
+				{
+					AccessorSum += PopulateComputedCamera(PopulateCamera, false);
+				}));
+
+				Results.Add(RunBenchmark(TEXT("PopulateChannels.Bulk.60k"), Iterations, PopulateCameraBytes, PopulateCameraKeyFrames.Num(), [&PopulateCamera, &AccessorSum]
+				{
+					AccessorSum += PopulateComputedCamera(PopulateCamera, true);
+				}));
+
+				// import cache entries in memory, a cache hit costs a file read and ImportCache.Load instead of ComputeVmdCamera
+				TArray<uint8> CacheBytes;
+				{
+					FMemoryWriter Writer(CacheBytes);
+					FVmdImportCache::Serialize(Writer, const_cast<FVmdComputedCamera&>(PopulateCamera));
+				}
+
+				Results.Add(RunBenchmark(TEXT("ImportCache.Store.60k"), Iterations, CacheBytes.Num(), PopulateCameraKeyFrames.Num(), [&PopulateCamera, &AccessorSum]
+				{
+					TArray<uint8> Bytes;
+					FMemoryWriter Writer(Bytes);
+					FVmdImportCache::Serialize(Writer, const_cast<FVmdComputedCamera&>(PopulateCamera));
+					AccessorSum += Bytes.Num();
+				}));
+
+				FVmdComputedCamera CachedCamera;
+				Results.Add(RunBenchmark(TEXT("ImportCache.Load.60k"), Iterations, CacheBytes.Num(), PopulateCameraKeyFrames.Num(), [&CacheBytes, &CachedCamera]
+				{
+					FMemoryReader Reader(CacheBytes);
+					CachedCamera = FVmdComputedCamera();
+					FVmdImportCache::Serialize(Reader, CachedCamera);
+				}));
+			}
+
+			// the synthetic file only has linear curves, which the solver skips
+			TArray<FVmdObject::FCameraKeyFrame> EasedCameraKeyFrames = CameraKeyFrames;
+			{
+				FRandomStream Random(static_cast<int32>(Settings.Seed));
+				for (FVmdObject::FCameraKeyFrame& KeyFrame : EasedCameraKeyFrames)
+				{
+					for (int8& Value : KeyFrame.Interpolation)
+					{
+						Value = static_cast<int8>(Random.RandRange(0, 127));
+					}
+				}
+			}
+
+			{
+				constexpr int32 SampleCount = 1 << 20;
+				TArray<float> X1, Y1, X2, Y2, Times, Values;
+				for (TArray<float>* Samples : { &X1, &Y1, &X2, &Y2, &Times, &Values })
+				{
+					Samples->SetNumUninitialized(SampleCount);
+				}
+
+				FRandomStream Random(static_cast<int32>(Settings.Seed));
+				for (int32 i = 0; i < SampleCount; ++i)
+				{
+					X1[i] = VmdCore::DecodeInterpolationFactor(static_cast<int8>(Random.RandRange(0, 127)));
+					Y1[i] = VmdCore::DecodeInterpolationFactor(static_cast<int8>(Random.RandRange(0, 127)));
+					X2[i] = VmdCore::DecodeInterpolationFactor(static_cast<int8>(Random.RandRange(0, 127)));
+					Y2[i] = VmdCore::DecodeInterpolationFactor(static_cast<int8>(Random.RandRange(0, 127)));
+					Times[i] = Random.FRand();
+				}
+
+				const int64 SampleBytes = 5 * SampleCount * sizeof(float);
+
+				Results.Add(RunBenchmark(TEXT("InterpolationCurve.Scalar"), Iterations, SampleBytes, SampleCount, [&]
+				{
+					for (int32 i = 0; i < SampleCount; ++i)
+					{
+						Values[i] = static_cast<float>(VmdCore::EvaluateInterpolationCurve(X1[i], Y1[i], X2[i], Y2[i], Times[i]));
+					}
+				}));
+
+				Results.Add(RunBenchmark(TEXT("InterpolationCurve.Batch"), Iterations, SampleBytes, SampleCount, [&]
+				{
+					VmdCore::EvaluateInterpolationCurves(X1.GetData(), Y1.GetData(), X2.GetData(), Y2.GetData(), Times.GetData(), SampleCount, Values.GetData());
+				}));
+
+				AccessorSum += Values[SampleCount / 2];
+			}
+
+			{
+				const int32 FrameCount = static_cast<int32>(EasedCameraKeyFrames.Last().FrameNumber) + 1;
+
+				TArray<float> ScratchValues;
+				TArray<int32> ScratchSegments;
+				TArray<float> FrameValues;
+				ScratchValues.SetNumUninitialized(VmdCore::GetCameraCurveScratchSize(FrameCount));
+				ScratchSegments.SetNumUninitialized(FrameCount);
+				FrameValues.SetNumUninitialized(VmdCore::GCameraChannelCount * FrameCount);
+
+				Results.Add(RunBenchmark(TEXT("EvaluateCameraCurves"), Iterations, CameraBytes, FrameCount, [&]
+				{
+					VmdCore::EvaluateCameraCurves(
+						EasedCameraKeyFrames.GetData(),
+						EasedCameraKeyFrames.Num(),
+						0.0,
+						1.0,
+						FrameCount,
+						ScratchValues.GetData(),
+						ScratchSegments.GetData(),
+						FrameValues.GetData());
+				}));
+
+				AccessorSum += FrameValues[FrameCount / 2];
+			}
+
+			// import cost of the baked modes and the runtime cost of evaluating each curve type over the whole camera
+			{
+				const int32 FrameCount = static_cast<int32>(EasedCameraKeyFrames.Last().FrameNumber) + 1;
+				const int32 FrameRatio = static_cast<int32>(Params.FrameRate.AsDecimal() / 30.f);
+
+				for (const ECurveImportType CurveImportType : { ECurveImportType::WeightedTangent, ECurveImportType::BakeLinear, ECurveImportType::BakeAuto })
+				{
+					const TCHAR* CurveImportTypeName =
+						CurveImportType == ECurveImportType::WeightedTangent ? TEXT("WeightedTangent") :
+						CurveImportType == ECurveImportType::BakeLinear ? TEXT("BakeLinear") :
+						TEXT("BakeAuto");
+
+					FVmdCameraImportParams CurveParams = Params;
+					CurveParams.CameraCount = 1;
+					CurveParams.CurveImportType = CurveImportType;
+
+					if (CurveImportType != ECurveImportType::WeightedTangent)
+					{
+						Results.Add(RunBenchmark(*FString::Printf(TEXT("ComputeVmdCamera.%s"), CurveImportTypeName), Iterations, CameraBytes, EasedCameraKeyFrames.Num(), [&EasedCameraKeyFrames, &CurveParams]
+						{
+							FVmdImporter::ComputeVmdCamera(EasedCameraKeyFrames, CurveParams);
+						}));
+					}
+
+					const FVmdComputedCamera ComputedCamera = FVmdImporter::ComputeVmdCamera(EasedCameraKeyFrames, CurveParams);
+
+					FMovieSceneDoubleChannel Channel;
+					FVmdImporter::PopulateChannel(Channel, ComputedCamera.LocationX.CameraKeys[0]);
+					if (ComputedCamera.LocationX.bAutoSetTangents)
+					{
+						Channel.AutoSetTangents();
+					}
+
+					Results.Add(RunBenchmark(*FString::Printf(TEXT("ChannelEvaluate.%s"), CurveImportTypeName), Iterations, 0, FrameCount, [&Channel, &AccessorSum, FrameCount, FrameRatio]
+					{
+						for (int32 Frame = 0; Frame < FrameCount; ++Frame)
+						{
+							double Value = 0.0;
+							Channel.Evaluate(FFrameTime(Frame * FrameRatio), Value);
+							AccessorSum += Value;
+						}
+					}));
+				}
+			}
+
+			// keeps the accessor and evaluator loops from being optimized away
+			UE_LOG(LogMMDCameraImporter, Verbose, TEXT("Benchmark checksum %f"), AccessorSum);
+		}).Wait();
+
+		if (!FFileHelper::SaveStringToFile(WriteBenchmarkJson(Settings, FileSize, Results), *OutputPath))
+		{
+			UE_LOG(LogMMDCameraImporter, Error, TEXT("Can't write benchmark result(%s)"), *OutputPath);
+			return;
+		}
+
+		UE_LOG(LogMMDCameraImporter, Display, TEXT("Benchmark result written to %s"), *OutputPath);
+	}
+
+	FAutoConsoleCommand VmdBenchmarkCommand(
+		TEXT("MMD.BenchmarkVmd"),
+		TEXT("Benchmark VMD validation, parsing, name decoding, camera cut detection, channel computation and curve evaluation on a synthetic file, results are written as json"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunVmdBenchmark));
+}
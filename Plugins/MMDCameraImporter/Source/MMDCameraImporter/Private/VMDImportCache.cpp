@@ -0,0 +1,334 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VMDImportCache.h"
+
+#include "MMDCameraImporter.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#include <atomic>
+
+namespace
+{
+	constexpr uint32 GVmdImportCacheMagic = 0x43444D56; // "VMDC"
+
+	// bump whenever ComputeVmdCamera produces different keys for the same input, old entries are ignored
+	constexpr int32 GVmdImportCacheVersion = 3;
+
+	// entries not stored or used for this long are deleted by FVmdImportCache::Evict
+	const FTimespan GVmdImportCacheMaxAge = FTimespan::FromDays(30.0);
+
+	// the least recently used entries are deleted past this total size
+	constexpr int64 GVmdImportCacheMaxSize = 512 * 1024 * 1024;
+
+	/**
+	 * Same layout as Ar << TArray, but a loaded count is checked against the bytes left in the archive before anything is allocated
+	 *
+	 * MinElementSize is the smallest serialized size of an element. A corrupt count sets the archive error.
+	 */
+	template<typename ElementType, typename SerializeElementFuncType>
+	void SerializeArray(FArchive& Ar, TArray<ElementType>& Array, const int64 MinElementSize, SerializeElementFuncType&& SerializeElement)
+	{
+		int32 Count = Array.Num();
+		Ar << Count;
+
+		if (Ar.IsLoading())
+		{
+			if (Ar.IsError() || Count < 0 || Ar.TotalSize() - Ar.Tell() < Count * MinElementSize)
+			{
+				Ar.SetError();
+				return;
+			}
+			Array.Reset();
+			Array.SetNum(Count);
+		}
+
+		for (ElementType& Element : Array)
+		{
+			SerializeElement(Ar, Element);
+			if (Ar.IsError())
+			{
+				return;
+			}
+		}
+	}
+
+	template<typename MovieSceneChannel>
+	void SerializeChannel(FArchive& Ar, TVmdComputedChannel<MovieSceneChannel>& ComputedChannel)
+	{
+		using FKey = TPair<FFrameNumber, typename MovieSceneChannel::ChannelValueType>;
+
+		// a key holds at least its frame number and value
+		constexpr int64 MinKeySize = sizeof(int32) + sizeof(typename MovieSceneChannel::CurveValueType);
+
+		Ar << ComputedChannel.DefaultValue;
+		Ar << ComputedChannel.bAutoSetTangents;
+
+		SerializeArray(Ar, ComputedChannel.CameraKeys, sizeof(int32), [](FArchive& InAr, TArray<FKey>& Keys)
+		{
+			SerializeArray(InAr, Keys, MinKeySize, [](FArchive& InKeyAr, FKey& Key)
+			{
+				InKeyAr << Key;
+			});
+		});
+	}
+}
+
+FString FVmdImportCache::MakeKey(const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames, const FVmdCameraImportParams& Params)
+{
+	FSHA1 Sha;
+
+	const auto Update = [&Sha](const auto& Value)
+	{
+		Sha.Update(reinterpret_cast<const uint8*>(&Value), sizeof(Value));
+	};
+
+	Update(GVmdImportCacheVersion);
+
+	Sha.Update(reinterpret_cast<const uint8*>(CameraKeyFrames.GetData()), CameraKeyFrames.Num() * sizeof(FVmdObject::FCameraKeyFrame));
+	Update(CameraKeyFrames.Num());
+
+	// bParallelChannels gives identical results and bReimportExisting only changes how the keys are written, neither is part of the key
+	Update(Params.SampleRate.Numerator);
+	Update(Params.SampleRate.Denominator);
+	Update(Params.FrameRate.Numerator);
+	Update(Params.FrameRate.Denominator);
+	Update(Params.ImportUniformScale);
+	Update(Params.CameraCutImportType);
+	Update(Params.CameraCount);
+	Update(Params.CurveImportType);
+	Update(Params.bAddMotionBlurKey);
+	Update(Params.MotionBlurAmount);
+	Update(Params.SensorWidth);
+	Update(Params.SensorHeight);
+	Update(Params.KeyReductionType);
+	Update(Params.PositionTolerance);
+	Update(Params.AngleTolerance);
+	Update(Params.FocalLengthTolerance);
+	Update(Params.CameraCutPositionTolerance);
+	Update(Params.CameraCutAngleTolerance);
+	Update(Params.CameraCutViewAngleTolerance);
+	Update(Params.CameraCutMaxFrameGap);
+
+	Sha.Final();
+
+	uint8 Hash[FSHA1::DigestSize];
+	Sha.GetHash(Hash);
+	return BytesToHex(Hash, FSHA1::DigestSize);
+}
+
+bool FVmdImportCache::Load(const FString& Key, FVmdComputedCamera& OutComputedCamera)
+{
+	const FString EntryPath = GetEntryPath(Key);
+
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *EntryPath, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+
+	// the version is part of the key, so a mismatch under the same name is as corrupt as a failed read
+	FVmdComputedCamera ComputedCamera;
+	if (!Reader.IsError() && Magic == GVmdImportCacheMagic && Version == GVmdImportCacheVersion)
+	{
+		Serialize(Reader, ComputedCamera);
+	}
+	else
+	{
+		Reader.SetError();
+	}
+
+	if (Reader.IsError() || !Reader.AtEnd())
+	{
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("Deleting corrupt import cache entry %s"), *EntryPath);
+		IFileManager::Get().Delete(*EntryPath, false, false, true);
+		return false;
+	}
+
+	// a hit counts as a use for Evict
+	IFileManager::Get().SetTimeStamp(*EntryPath, FDateTime::UtcNow());
+
+	OutComputedCamera = MoveTemp(ComputedCamera);
+	return true;
+}
+
+void FVmdImportCache::Store(const FString& Key, const FVmdComputedCamera& InComputedCamera)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = GVmdImportCacheMagic;
+	int32 Version = GVmdImportCacheVersion;
+	Writer << Magic;
+	Writer << Version;
+	Serialize(Writer, const_cast<FVmdComputedCamera&>(InComputedCamera));
+
+	// written under a unique name and moved into place, concurrent imports of the same file may store the same entry
+	const FString EntryPath = GetEntryPath(Key);
+	const FString TempPath = FString::Printf(TEXT("%s.%s.tmp"), *EntryPath, *FGuid::NewGuid().ToString());
+
+	if (!FFileHelper::SaveArrayToFile(Bytes, *TempPath) || !IFileManager::Get().Move(*EntryPath, *TempPath, true, true))
+	{
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("Failed to write import cache entry %s"), *EntryPath);
+	}
+
+	// once per session, by the first import that stores anything
+	static std::atomic<bool> bHasEvicted(false);
+	if (!bHasEvicted.exchange(true))
+	{
+		Evict();
+	}
+}
+
+void FVmdImportCache::Evict()
+{
+	struct FEntry
+	{
+		FString Path;
+		FDateTime Time;
+		int64 Size;
+	};
+
+	TArray<FEntry> Entries;
+	TArray<FString> ExpiredPaths;
+	int64 TotalSize = 0;
+	int32 DeletedCount = 0;
+
+	const FDateTime OldestTime = FDateTime::UtcNow() - GVmdImportCacheMaxAge;
+
+	// files are deleted after the walk, not while the directory is being iterated
+	IFileManager::Get().IterateDirectoryStatRecursively(*GetCacheDirectory(), [&](const TCHAR* Path, const FFileStatData& StatData)
+	{
+		if (StatData.bIsDirectory)
+		{
+			return true;
+		}
+
+		// expired entries, and temp files left behind by imports that didn't finish
+		if (StatData.ModificationTime < OldestTime)
+		{
+			ExpiredPaths.Add(Path);
+		}
+		else if (FPaths::GetExtension(Path) == TEXT("vmdcache"))
+		{
+			Entries.Add({ Path, StatData.ModificationTime, StatData.FileSize });
+			TotalSize += StatData.FileSize;
+		}
+		return true;
+	});
+
+	for (const FString& ExpiredPath : ExpiredPaths)
+	{
+		DeletedCount += IFileManager::Get().Delete(*ExpiredPath, false, false, true) ? 1 : 0;
+	}
+
+	if (GVmdImportCacheMaxSize < TotalSize)
+	{
+		Entries.Sort([](const FEntry& A, const FEntry& B)
+		{
+			return A.Time < B.Time;
+		});
+
+		for (const FEntry& Entry : Entries)
+		{
+			if (TotalSize <= GVmdImportCacheMaxSize)
+			{
+				break;
+			}
+
+			if (IFileManager::Get().Delete(*Entry.Path, false, false, true))
+			{
+				TotalSize -= Entry.Size;
+				DeletedCount += 1;
+			}
+		}
+	}
+
+	if (DeletedCount != 0)
+	{
+		UE_LOG(LogMMDCameraImporter, Log, TEXT("Evicted %d import cache files, %lld bytes left"), DeletedCount, TotalSize);
+	}
+}
+
+FVmdComputedCamera FVmdImportCache::ComputeVmdCamera(
+	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+	const FVmdCameraImportParams& Params,
+	bool* bOutCacheHit
+)
+{
+	if (bOutCacheHit != nullptr)
+	{
+		*bOutCacheHit = false;
+	}
+
+	if (!Params.bUseImportCache)
+	{
+		return FVmdImporter::ComputeVmdCamera(CameraKeyFrames, Params);
+	}
+
+	const FString Key = MakeKey(CameraKeyFrames, Params);
+
+	FVmdComputedCamera ComputedCamera;
+	if (Load(Key, ComputedCamera))
+	{
+		UE_LOG(LogMMDCameraImporter, Log, TEXT("Using cached camera keys %s"), *Key);
+
+		if (bOutCacheHit != nullptr)
+		{
+			*bOutCacheHit = true;
+		}
+		return ComputedCamera;
+	}
+
+	ComputedCamera = FVmdImporter::ComputeVmdCamera(CameraKeyFrames, Params);
+	Store(Key, ComputedCamera);
+	return ComputedCamera;
+}
+
+void FVmdImportCache::Serialize(FArchive& Ar, FVmdComputedCamera& ComputedCamera)
+{
+	// a range is two bounds of at least a uint32 each
+	SerializeArray(Ar, ComputedCamera.CameraCuts, 2 * sizeof(uint32), [](FArchive& InAr, TRange<uint32>& CameraCut)
+	{
+		InAr << CameraCut;
+	});
+
+	Ar << ComputedCamera.KeyReduction.KeysBefore;
+	Ar << ComputedCamera.KeyReduction.KeysAfter;
+	Ar << ComputedCamera.KeyReduction.MaxPositionError;
+	Ar << ComputedCamera.KeyReduction.MaxAngleError;
+	Ar << ComputedCamera.KeyReduction.MaxFocalLengthError;
+
+	SerializeChannel(Ar, ComputedCamera.FocalLength);
+	SerializeChannel(Ar, ComputedCamera.MotionBlur);
+	SerializeChannel(Ar, ComputedCamera.Distance);
+	SerializeChannel(Ar, ComputedCamera.LocationX);
+	SerializeChannel(Ar, ComputedCamera.LocationY);
+	SerializeChannel(Ar, ComputedCamera.LocationZ);
+	SerializeChannel(Ar, ComputedCamera.RotationX);
+	SerializeChannel(Ar, ComputedCamera.RotationY);
+	SerializeChannel(Ar, ComputedCamera.RotationZ);
+}
+
+FString FVmdImportCache::GetCacheDirectory()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MMDCameraImporter"), TEXT("Cache"));
+}
+
+FString FVmdImportCache::GetEntryPath(const FString& Key)
+{
+	// two character fan out like the file system DDC
+	return FPaths::Combine(GetCacheDirectory(), Key.Left(2), Key + TEXT(".vmdcache"));
+}
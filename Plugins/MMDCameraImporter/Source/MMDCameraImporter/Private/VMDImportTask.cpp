@@ -0,0 +1,382 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VMDImportTask.h"
+
+#include "ISequencer.h"
+#include "MMDCameraImporter.h"
+#include "MMDUserImportVMDSettings.h"
+#include "VMDImportCache.h"
+#include "MovieSceneSequence.h"
+#include "ScopedTransaction.h"
+#include "Async/Async.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Sections/MovieSceneSubSection.h"
+#include "Tasks/Task.h"
+#include "Widgets/Notifications/SNotificationList.h"
+
+#define LOCTEXT_NAMESPACE "FMmdCameraImporterModule"
+
+TSharedRef<FVmdImportTask> FVmdImportTask::Launch(
+	const TArray<FString>& InFilePaths,
+	UMovieSceneSequence* InSequence,
+	ISequencer& InSequencer,
+	const UMmdUserImportVmdSettings* ImportVmdSettings
+)
+{
+	check(IsInGameThread());
+
+	const FVmdCameraImportParams Params = FVmdCameraImportParams::Make(InSequence->GetMovieScene(), ImportVmdSettings);
+
+	TSharedRef<FVmdImportTask> ImportTask = MakeShareable(new FVmdImportTask(
+		InFilePaths,
+		InSequence,
+		InSequencer,
+		Params,
+		ImportVmdSettings->bCreateShotPerFile));
+	ImportTask->Start();
+
+	return ImportTask;
+}
+
+FVmdImportTask::FVmdImportTask(
+	const TArray<FString>& InFilePaths,
+	UMovieSceneSequence* InSequence,
+	ISequencer& InSequencer,
+	const FVmdCameraImportParams& InParams,
+	const bool bInCreateShotPerFile
+)
+	: WeakSequence(InSequence)
+	, WeakSequencer(InSequencer.AsShared())
+	, Params(InParams)
+	// several files would overwrite the same sequence over and over, so every file gets its own shot
+	, bCreateShotPerFile(bInCreateShotPerFile || 1 < InFilePaths.Num())
+	, bCancelRequested(false)
+	, ProcessedFileCount(0)
+{
+	FileResults.SetNum(InFilePaths.Num());
+	for (int32 i = 0; i < InFilePaths.Num(); ++i)
+	{
+		FileResults[i].FilePath = InFilePaths[i];
+	}
+}
+
+void FVmdImportTask::Cancel()
+{
+	bCancelRequested = true;
+	SetStageText(LOCTEXT("VMDImportCancelling", "Cancelling VMD import..."));
+}
+
+void FVmdImportTask::Start()
+{
+	FNotificationInfo Info(FText::Format(LOCTEXT("VMDImportParsing", "Reading {0}"), GetFileLabel()));
+	Info.bFireAndForget = false;
+	Info.bUseThrobber = true;
+	Info.ExpireDuration = 5.0f;
+	Info.ButtonDetails.Add(FNotificationButtonInfo(
+		LOCTEXT("VMDImportCancel", "Cancel"),
+		LOCTEXT("VMDImportCancelTooltip", "Cancel the VMD import"),
+		FSimpleDelegate::CreateSP(this, &FVmdImportTask::Cancel),
+		SNotificationItem::CS_Pending));
+
+	Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (Notification.IsValid())
+	{
+		Notification->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+
+	const TSharedRef<FVmdImportTask> This = AsShared();
+
+	TArray<UE::Tasks::FTask> FileTasks;
+	FileTasks.Reserve(FileResults.Num());
+	for (int32 i = 0; i < FileResults.Num(); ++i)
+	{
+		FileTasks.Add(UE::Tasks::Launch(
+			UE_SOURCE_LOCATION,
+			[This, i]
+			{
+				This->ProcessFile(i);
+			}));
+	}
+
+	UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[This]
+		{
+			if (This->IsCancelled())
+			{
+				This->ReportSummary();
+				This->Finish(false, LOCTEXT("VMDImportCancelled", "VMD import cancelled"));
+				return;
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [This]
+			{
+				This->CommitAll();
+			});
+		},
+		UE::Tasks::Prerequisites(FileTasks));
+}
+
+void FVmdImportTask::ProcessFile(const int32 Index)
+{
+	FFileResult& FileResult = FileResults[Index];
+
+	if (IsCancelled())
+	{
+		FileResult.ErrorText = LOCTEXT("VMDImportCancelled", "VMD import cancelled");
+		return;
+	}
+
+	const double ParseStartTime = FPlatformTime::Seconds();
+
+	FVmdImporter VmdImporter;
+	VmdImporter.SetFilePath(FileResult.FilePath);
+	VmdImporter.SetReadMode(EVmdReadMode::MemoryMapped);
+
+	if (!VmdImporter.IsValidVmdFile())
+	{
+		FileResult.ErrorText = LOCTEXT("VMDImportInvalidFile", "Invalid VMD file");
+		return;
+	}
+
+	const FVmdParseResult ParseResult = VmdImporter.ParseVmdFile(EVmdSections::Camera);
+	FileResult.ParseSeconds = FPlatformTime::Seconds() - ParseStartTime;
+
+	if (!ParseResult.bIsSuccess)
+	{
+		FileResult.ErrorText = LOCTEXT("VMDImportParseFailed", "Failed to read VMD file");
+		return;
+	}
+
+	if (ParseResult.CameraKeyFrames.Num() == 0)
+	{
+		FileResult.ErrorText = LOCTEXT("NoCameraMotionError", "This VMD file is not camera motion");
+		return;
+	}
+
+	if (IsCancelled())
+	{
+		FileResult.ErrorText = LOCTEXT("VMDImportCancelled", "VMD import cancelled");
+		return;
+	}
+
+	const double ComputeStartTime = FPlatformTime::Seconds();
+
+	FileResult.ComputedCamera = MakeShared<FVmdComputedCamera>(FVmdImportCache::ComputeVmdCamera(ParseResult.CameraKeyFrames, Params));
+	FileResult.FirstKeyFrame = ParseResult.CameraKeyFrames[0];
+	FileResult.LastFrameNumber = ParseResult.CameraKeyFrames.Last().FrameNumber;
+	FileResult.KeyReduction = FileResult.ComputedCamera->KeyReduction;
+	FileResult.ComputeSeconds = FPlatformTime::Seconds() - ComputeStartTime;
+	FileResult.bIsSuccess = true;
+
+	const int32 ProcessedCount = ++ProcessedFileCount;
+	if (1 < FileResults.Num())
+	{
+		SetStageText(FText::Format(
+			LOCTEXT("VMDImportComputingBatch", "Computing camera keys ({0}/{1})"),
+			FText::AsNumber(ProcessedCount),
+			FText::AsNumber(FileResults.Num())));
+	}
+	else
+	{
+		SetStageText(LOCTEXT("VMDImportComputing", "Computing camera keys"));
+	}
+}
+
+void FVmdImportTask::CommitAll()
+{
+	check(IsInGameThread());
+
+	if (IsCancelled())
+	{
+		ReportSummary();
+		Finish(false, LOCTEXT("VMDImportCancelled", "VMD import cancelled"));
+		return;
+	}
+
+	UMovieSceneSequence* Sequence = WeakSequence.Get();
+	const TSharedPtr<ISequencer> Sequencer = WeakSequencer.Pin();
+
+	if (!Sequence || !Sequence->GetMovieScene() || Sequence->GetMovieScene()->IsReadOnly() || !Sequencer.IsValid())
+	{
+		Finish(false, LOCTEXT("VMDImportSequenceLost", "Sequence is no longer available"));
+		return;
+	}
+
+	int32 ImportedCount = 0;
+	{
+		const FScopedTransaction Transaction(LOCTEXT("ImportVMDTransaction", "Import VMD"));
+
+		for (FFileResult& FileResult : FileResults)
+		{
+			if (FileResult.bIsSuccess && CommitFile(FileResult, Sequence, *Sequencer))
+			{
+				ImportedCount += 1;
+			}
+
+			// results are no longer needed once they are in the sequence
+			FileResult.ComputedCamera.Reset();
+		}
+	}
+
+	Sequencer->NotifyMovieSceneDataChanged(EMovieSceneDataChangeType::MovieSceneStructureItemAdded);
+
+	ReportSummary();
+
+	if (FileResults.Num() == 1)
+	{
+		const FVmdKeyReductionStats& KeyReduction = FileResults[0].KeyReduction;
+
+		FText SucceededText = FText::Format(LOCTEXT("VMDImportSucceeded", "Imported {0}"), GetFileLabel());
+		if (Params.KeyReductionType == EKeyReductionType::Tolerance)
+		{
+			SucceededText = FText::Format(
+				LOCTEXT("VMDImportSucceededReduced", "Imported {0}, {1} of {2} keys kept"),
+				GetFileLabel(),
+				FText::AsNumber(KeyReduction.KeysAfter),
+				FText::AsNumber(KeyReduction.KeysBefore));
+		}
+
+		Finish(
+			ImportedCount == 1,
+			ImportedCount == 1
+				? SucceededText
+				: FileResults[0].ErrorText);
+	}
+	else
+	{
+		Finish(
+			ImportedCount == FileResults.Num(),
+			FText::Format(
+				LOCTEXT("VMDImportBatchSummary", "Imported {0} of {1} VMD files"),
+				FText::AsNumber(ImportedCount),
+				FText::AsNumber(FileResults.Num())));
+	}
+}
+
+bool FVmdImportTask::CommitFile(FFileResult& InFileResult, UMovieSceneSequence* InSequence, ISequencer& InSequencer) const
+{
+	const double CommitStartTime = FPlatformTime::Seconds();
+
+	if (!bCreateShotPerFile)
+	{
+		FVmdImporter::ImportComputedVmdCamera(
+			*InFileResult.ComputedCamera,
+			InFileResult.FirstKeyFrame,
+			InSequence,
+			InSequencer,
+			Params);
+
+		InFileResult.CommitSeconds = FPlatformTime::Seconds() - CommitStartTime;
+		return true;
+	}
+
+	UMovieSceneSubSection* ShotSection = FVmdImporter::CreateShotSequence(InFileResult.FilePath, InFileResult.LastFrameNumber, InSequence);
+	if (ShotSection == nullptr)
+	{
+		InFileResult.bIsSuccess = false;
+		InFileResult.ErrorText = LOCTEXT("VMDImportShotFailed", "Failed to create shot");
+		return false;
+	}
+
+	// actors are added to the focused sequence, so the shot has to be focused while importing
+	const FMovieSceneSequenceID PreviousTemplateID = InSequencer.GetFocusedTemplateID();
+	InSequencer.FocusSequenceInstance(*ShotSection);
+
+	FVmdImporter::ImportComputedVmdCamera(
+		*InFileResult.ComputedCamera,
+		InFileResult.FirstKeyFrame,
+		ShotSection->GetSequence(),
+		InSequencer,
+		Params);
+
+	InSequencer.PopToSequenceInstance(PreviousTemplateID);
+
+	InFileResult.CommitSeconds = FPlatformTime::Seconds() - CommitStartTime;
+	return true;
+}
+
+void FVmdImportTask::ReportSummary() const
+{
+	if (FileResults.Num() == 1 && FileResults[0].bIsSuccess)
+	{
+		return;
+	}
+
+	int32 FailedCount = 0;
+	for (const FFileResult& FileResult : FileResults)
+	{
+		if (!FileResult.bIsSuccess)
+		{
+			FailedCount += 1;
+		}
+	}
+
+	UE_LOG(LogMMDCameraImporter, Log, TEXT("VMD import summary: %d files, %d failed"), FileResults.Num(), FailedCount);
+
+	for (const FFileResult& FileResult : FileResults)
+	{
+		if (FileResult.bIsSuccess)
+		{
+			UE_LOG(
+				LogMMDCameraImporter,
+				Log,
+				TEXT("  %s: parse %.2f ms, compute %.2f ms, commit %.2f ms, %d of %d keys"),
+				*FileResult.FilePath,
+				FileResult.ParseSeconds * 1000.0,
+				FileResult.ComputeSeconds * 1000.0,
+				FileResult.CommitSeconds * 1000.0,
+				FileResult.KeyReduction.KeysAfter,
+				FileResult.KeyReduction.KeysBefore);
+		}
+		else
+		{
+			UE_LOG(LogMMDCameraImporter, Warning, TEXT("  %s: %s"), *FileResult.FilePath, *FileResult.ErrorText.ToString());
+		}
+	}
+}
+
+FText FVmdImportTask::GetFileLabel() const
+{
+	if (FileResults.Num() == 1)
+	{
+		return FText::FromString(FPaths::GetCleanFilename(FileResults[0].FilePath));
+	}
+
+	return FText::Format(LOCTEXT("VMDImportFileCount", "{0} VMD files"), FText::AsNumber(FileResults.Num()));
+}
+
+void FVmdImportTask::SetStageText(const FText& InText) const
+{
+	AsyncTask(ENamedThreads::GameThread, [WeakNotification = TWeakPtr<SNotificationItem>(Notification), InText]
+	{
+		if (const TSharedPtr<SNotificationItem> PinnedNotification = WeakNotification.Pin())
+		{
+			PinnedNotification->SetText(InText);
+		}
+	});
+}
+
+void FVmdImportTask::Finish(const bool bIsSuccess, const FText& InText) const
+{
+	if (bIsSuccess)
+	{
+		UE_LOG(LogMMDCameraImporter, Log, TEXT("%s"), *InText.ToString());
+	}
+	else
+	{
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("%s"), *InText.ToString());
+	}
+
+	AsyncTask(ENamedThreads::GameThread, [WeakNotification = TWeakPtr<SNotificationItem>(Notification), bIsSuccess, InText]
+	{
+		if (const TSharedPtr<SNotificationItem> PinnedNotification = WeakNotification.Pin())
+		{
+			PinnedNotification->SetText(InText);
+			PinnedNotification->SetCompletionState(bIsSuccess ? SNotificationItem::CS_Success : SNotificationItem::CS_Fail);
+			PinnedNotification->ExpireAndFadeout();
+		}
+	});
+}
+
+#undef LOCTEXT_NAMESPACE
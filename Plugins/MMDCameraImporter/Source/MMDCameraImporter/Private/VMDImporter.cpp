@@ -2,179 +2,260 @@
 
 #include "VMDImporter.h"
 
+#include "AssetToolsModule.h"
 #include "CineCameraActor.h"
 #include "CineCameraComponent.h"
 #include "ISequencerModule.h"
 #include "LevelEditorViewport.h"
+#include "LevelSequence.h"
 #include "MMDCameraImporter.h"
 #include "MMDImportHelper.h"
 #include "MovieSceneToolHelpers.h"
+#include "VMDImportCache.h"
+#include "VMDMappedFile.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
 #include "Framework/Notifications/NotificationManager.h"
 #include "Misc/ScopedSlowTask.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "Sections/MovieSceneCameraCutSection.h"
 #include "Sections/MovieSceneFloatSection.h"
+#include "Sections/MovieSceneSubSection.h"
+#include "Tracks/MovieScene3DAttachTrack.h"
 #include "Tracks/MovieScene3DTransformTrack.h"
+#include "Tracks/MovieSceneCinematicShotTrack.h"
 #include "Tracks/MovieSceneFloatTrack.h"
 #include "Widgets/Notifications/SNotificationList.h"
+#include "VmdCore/VmdCameraCurves.h"
 
 #define LOCTEXT_NAMESPACE "FMmdCameraImporterModule"
 
-void FVmdImporter::SetFilePath(const FString& InFilePath)
-{
-	FilePath = InFilePath;
-}
-
-bool FVmdImporter::IsValidVmdFile()
+namespace
 {
-	if (!FileReader.IsValid())
+	template<typename T>
+	void ReadSection(FArchive& Reader, const FVmdSectionDirectory::FSection& Section, TArray<T>& OutKeyFrames)
 	{
-		FileReader = TUniquePtr<FArchive>(OpenFile(FilePath));
+		Reader.Seek(Section.Offset);
+		OutKeyFrames.SetNum(Section.Count);
+		Reader.Serialize(OutKeyFrames.GetData(), sizeof(T) * Section.Count);
+	}
 
-		if (!FileReader.IsValid())
+	/**
+	 * Call Func with the descriptor of a camera channel and the member of FVmdComputedCamera it is computed into,
+	 * channels are indexed in the order they are declared in FVmdComputedCamera, motion blur is not one of them
+	 */
+	template<typename FuncType>
+	void VisitCameraChannel(const int32 ChannelIndex, FuncType&& Func)
+	{
+		switch (ChannelIndex)
 		{
-			UE_LOG(LogMMDCameraImporter, Error, TEXT("Can't open file(%s)"), *FilePath);
-			return false;
+		case 0: Func(FVmdFocalLengthChannel(), &FVmdComputedCamera::FocalLength); break;
+		case 1: Func(FVmdDistanceChannel(), &FVmdComputedCamera::Distance); break;
+		case 2: Func(FVmdLocationXChannel(), &FVmdComputedCamera::LocationX); break;
+		case 3: Func(FVmdLocationYChannel(), &FVmdComputedCamera::LocationY); break;
+		case 4: Func(FVmdLocationZChannel(), &FVmdComputedCamera::LocationZ); break;
+		case 5: Func(FVmdRotationXChannel(), &FVmdComputedCamera::RotationX); break;
+		case 6: Func(FVmdRotationYChannel(), &FVmdComputedCamera::RotationY); break;
+		case 7: Func(FVmdRotationZChannel(), &FVmdComputedCamera::RotationZ); break;
+		default: checkNoEntry();
 		}
 	}
-	
-	const int64 FileSize = FileReader->TotalSize();
+}
+
+bool FVmdSectionDirectory::Scan(const int64 InFileSize, const FReadFunc Read, FVmdSectionDirectory& OutDirectory)
+{
+	OutDirectory = FVmdSectionDirectory();
 
-	if (FileSize < sizeof(FVmdObject::FHeader))
+	switch (VmdCore::ScanSections(InFileSize, Read, OutDirectory, OutDirectory.IkRuns))
 	{
+	case VmdCore::EScanResult::Success:
+		break;
+	case VmdCore::EScanResult::FileTooSmall:
 		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(FileSize < sizeof(FVmdObject::FHeader))"));
 		return false;
-	}
-
-	FileReader->Seek(0);
-	uint8 Magic[30];
-	FileReader->Serialize(Magic, sizeof Magic);
-	if (FMmdImportHelper::ShiftJisToFString(Magic, sizeof Magic).StartsWith("Vocaloid Motion Data 0002", ESearchCase::CaseSensitive) == false)
-	{
+	case VmdCore::EScanResult::InvalidMagic:
 		UE_LOG(LogMMDCameraImporter, Error, TEXT("File is not vmd format"));
 		return false;
+	case VmdCore::EScanResult::BoneKeyFramesTruncated:
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read bone keyframes)"));
+		return false;
+	case VmdCore::EScanResult::MorphKeyFramesTruncated:
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read morph keyframes)"));
+		return false;
+	case VmdCore::EScanResult::CameraKeyFramesTruncated:
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read camera keyframes)"));
+		return false;
+	case VmdCore::EScanResult::LightKeyFramesTruncated:
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read light keyframes)"));
+		return false;
+	case VmdCore::EScanResult::SelfShadowKeyFramesTruncated:
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read self shadow keyframes)"));
+		return false;
+	case VmdCore::EScanResult::IkStateCountTruncated:
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read number of IK state keyframes)"));
+		return false;
+	case VmdCore::EScanResult::PropertyKeyFramesTruncated:
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(FileSize < Offset)"));
+		return false;
 	}
-	
-	int64 Offset = sizeof(FVmdObject::FHeader);
 
-	if (FileSize < Offset + static_cast<int64>(sizeof(uint32)))
+	if (!OutDirectory.CameraKeyFrames.bIsPresent)
 	{
-		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read number of bone keyframes)"));
-		return false;
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("File does not contain camera/self shadow/property keyframes"));
 	}
-	FileReader->Seek(Offset);
-	uint32 BoneKeyFrameCount = 0;
-	FileReader->Serialize(&BoneKeyFrameCount, sizeof(uint32));
-	Offset += sizeof(uint32) + (sizeof(FVmdObject::FBoneKeyFrame) * BoneKeyFrameCount);
-
-	if (FileSize < Offset + static_cast<int64>(sizeof(uint32)))
+	else if (!OutDirectory.SelfShadowKeyFrames.bIsPresent)
 	{
-		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read number of morph keyframes)"));
-		return false;
+		UE_LOG(LogMMDCameraImporter, Log, TEXT("File does not contain self shadow/property keyframes"));
 	}
-	FileReader->Seek(Offset);
-	uint32 MorphKeyFrameCount = 0;
-	FileReader->Serialize(&MorphKeyFrameCount, sizeof(uint32));
-	Offset += sizeof(uint32) + (sizeof(FVmdObject::FMorphKeyFrame) * MorphKeyFrameCount);
-
-	if (FileSize < Offset + static_cast<int64>(sizeof(uint32)))
+	else if (!OutDirectory.PropertyKeyFrames.bIsPresent)
 	{
-		UE_LOG(LogMMDCameraImporter, Warning, TEXT("File does not contain camera/self shadow/property keyframes"));
-		return true;
+		UE_LOG(LogMMDCameraImporter, Log, TEXT("File does not contain property keyframes"));
 	}
-	FileReader->Seek(Offset);
-	uint32 CameraKeyFrameCount = 0;
-	FileReader->Serialize(&CameraKeyFrameCount, sizeof(uint32));
-	Offset += sizeof(uint32) + (sizeof(FVmdObject::FCameraKeyFrame) * CameraKeyFrameCount);
-
-	if (FileSize < Offset + static_cast<int64>(sizeof(uint32)))
+	else if (InFileSize != OutDirectory.EndOffset)
 	{
-		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read number of light keyframes)"));
-		return false;
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("File seems to be corrupt or additional data exists"));
 	}
-	FileReader->Seek(Offset);
-	uint32 LightKeyFrameCount = 0;
-	FileReader->Serialize(&LightKeyFrameCount, sizeof(uint32));
-	Offset += sizeof(uint32) + (sizeof(FVmdObject::FLightKeyFrame) * LightKeyFrameCount);
 
-	if (FileSize < Offset + static_cast<int64>(sizeof(uint32)))
+	return true;
+}
+
+void FVmdImporter::SetFilePath(const FString& InFilePath)
+{
+	FilePath = InFilePath;
+
+	MappedFile.Reset();
+	MapResult = EVmdMapResult::NotAttempted;
+}
+
+void FVmdImporter::SetReadMode(const EVmdReadMode InReadMode)
+{
+	ReadMode = InReadMode;
+}
+
+bool FVmdImporter::IsValidVmdFile()
+{
+	if (GetSectionDirectory() != nullptr)
 	{
-		UE_LOG(LogMMDCameraImporter, Log, TEXT("File does not contain self shadow/property keyframes"));
 		return true;
 	}
-	FileReader->Seek(Offset);
-	uint32 SelfShadowKeyFrameCount = 0;
-	FileReader->Serialize(&SelfShadowKeyFrameCount, sizeof(uint32));
-	Offset += sizeof(uint32) + (sizeof(FVmdObject::FSelfShadowKeyFrame) * SelfShadowKeyFrameCount);
 
-	if (FileSize < Offset + static_cast<int64>(sizeof(uint32)))
+	// only a file the platform can't map is scanned again through the archive, a failed scan stays failed
+	if (ReadMode == EVmdReadMode::MemoryMapped)
 	{
-		UE_LOG(LogMMDCameraImporter, Log, TEXT("File does not contain property keyframes"));
-		return true;
+		MapVmdFile();
+		if (MapResult != EVmdMapResult::MapFailed)
+		{
+			return MapResult == EVmdMapResult::Success;
+		}
 	}
-	FileReader->Seek(Offset);
-	uint32 PropertyKeyFrameCount = 0;
-	FileReader->Serialize(&PropertyKeyFrameCount, sizeof(uint32));
-	Offset += sizeof(uint32);
 
-	for (PTRINT i = 0; i < PropertyKeyFrameCount; ++i)
+	return ScanArchive();
+}
+
+const FVmdSectionDirectory* FVmdImporter::GetSectionDirectory() const
+{
+	if (MappedFile.IsValid())
 	{
-		Offset += sizeof(FVmdObject::FPropertyKeyFrame);
+		return &MappedFile->GetSectionDirectory();
+	}
 
-		if (FileSize < Offset + static_cast<int64>(sizeof(uint32)))
+	return SectionDirectory.IsSet() ? &SectionDirectory.GetValue() : nullptr;
+}
+
+SIZE_T FVmdParseResult::GetAllocatedSize() const
+{
+	return BoneKeyFrames.GetAllocatedSize() +
+		MorphKeyFrames.GetAllocatedSize() +
+		CameraKeyFrames.GetAllocatedSize() +
+		LightKeyFrames.GetAllocatedSize() +
+		SelfShadowKeyFrames.GetAllocatedSize() +
+		PropertyKeyFrames.GetAllocatedSize() +
+		IkStateOffsets.GetAllocatedSize() +
+		IkStates.GetAllocatedSize() +
+		BoneNames.GetAllocatedSize() +
+		BoneNameIds.GetAllocatedSize() +
+		MorphNames.GetAllocatedSize() +
+		MorphNameIds.GetAllocatedSize() +
+		IkNames.GetAllocatedSize() +
+		IkNameIds.GetAllocatedSize();
+}
+
+void FVmdImporter::InternNames(FVmdParseResult& InOutVmdParseResult)
+{
+	InOutVmdParseResult.BoneNames.Reset();
+	InOutVmdParseResult.BoneNames.InternAll(InOutVmdParseResult.BoneKeyFrames, &FVmdObject::FBoneKeyFrame::BoneName, InOutVmdParseResult.BoneNameIds);
+
+	InOutVmdParseResult.MorphNames.Reset();
+	InOutVmdParseResult.MorphNames.InternAll(InOutVmdParseResult.MorphKeyFrames, &FVmdObject::FMorphKeyFrame::MorphName, InOutVmdParseResult.MorphNameIds);
+
+	InOutVmdParseResult.IkNames.Reset();
+	InOutVmdParseResult.IkNames.InternAll(InOutVmdParseResult.IkStates, &FVmdObject::FPropertyKeyFrame::FIkState::IkName, InOutVmdParseResult.IkNameIds);
+}
+
+FVmdParseResult FVmdImporter::ParseVmdFile(const EVmdSections Sections)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	FVmdParseResult VmdParseResult;
+	bool bIsParsed = false;
+
+	if (ReadMode == EVmdReadMode::MemoryMapped)
+	{
+		if (const TSharedPtr<const FVmdMappedFile> Mapped = MapVmdFile(); Mapped.IsValid())
 		{
-			UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Failed to read number of IK state keyframes)"));
-			return false;
+			VmdParseResult = ParseMappedVmdFile(*Mapped, Sections);
+			bIsParsed = true;
+		}
+		else if (MapResult == EVmdMapResult::InvalidFile)
+		{
+			VmdParseResult.bIsSuccess = false;
+			return VmdParseResult;
+		}
+		else
+		{
+			UE_LOG(LogMMDCameraImporter, Warning, TEXT("Failed to map file(%s), fall back to archive read"), *FilePath);
 		}
-		FileReader->Seek(Offset);
-		uint32 IkStateCount = 0;
-		FileReader->Serialize(&IkStateCount, sizeof(uint32));
-		Offset += sizeof(uint32) + (sizeof(FVmdObject::FPropertyKeyFrame::FIkState) * IkStateCount);
 	}
 
-	if (FileSize < Offset)
+	if (!bIsParsed)
 	{
-		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(FileSize < Offset)"));
-		return false;
+		VmdParseResult = ParseArchiveVmdFile(Sections);
 	}
 
-	if (FileSize != Offset)
+	if (VmdParseResult.bIsSuccess)
 	{
-		UE_LOG(LogMMDCameraImporter, Warning, TEXT("File seems to be corrupt or additional data exists"));
+		InternNames(VmdParseResult);
+
+		UE_LOG(LogMMDCameraImporter, Verbose, TEXT("Parsed %s in %.2f ms, %llu bytes of key frames allocated"),
+			*FilePath,
+			(FPlatformTime::Seconds() - StartTime) * 1000.0,
+			static_cast<uint64>(VmdParseResult.GetAllocatedSize()));
 	}
-	
-	return true;
+
+	return VmdParseResult;
 }
 
-FVmdParseResult FVmdImporter::ParseVmdFile()
+FVmdParseResult FVmdImporter::ParseArchiveVmdFile(const EVmdSections Sections)
 {
-	if (!FileReader.IsValid())
-	{
-		FileReader = TUniquePtr<FArchive>(OpenFile(FilePath));
-
-		if (!FileReader.IsValid())
-		{
-			UE_LOG(LogMMDCameraImporter, Error, TEXT("Can't open file(%s)"), *FilePath);
-
-			FVmdParseResult FailedResult;
-			FailedResult.bIsSuccess = false;
+	FVmdParseResult VmdParseResult;
+	VmdParseResult.bIsSuccess = false;
 
-			return FailedResult;
-		}
+	// reuse the directory from IsValidVmdFile so the file is scanned only once
+	if (!SectionDirectory.IsSet() && !ScanArchive())
+	{
+		return VmdParseResult;
 	}
+	const FVmdSectionDirectory& Directory = SectionDirectory.GetValue();
 	
 	FScopedSlowTask ImportVmdTask(7, LOCTEXT("ReadingVMDFile", "Reading VMD File"));
 	ImportVmdTask.MakeDialog(true, true);
 
-	const int64 FileSize = FileReader->TotalSize();
-
-	FVmdParseResult VmdParseResult;
-	VmdParseResult.bIsSuccess = false;
-	
 	if (ImportVmdTask.ShouldCancel())
 	{
 		return VmdParseResult;
 	}
 	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFileHeader", "Reading Header"));
-	FileReader->Seek(0);
+	FileReader->Seek(Directory.Header.Offset);
 	FileReader->Serialize(&VmdParseResult.Header, sizeof(FVmdObject::FHeader));
 
 	if (ImportVmdTask.ShouldCancel())
@@ -182,108 +263,131 @@ FVmdParseResult FVmdImporter::ParseVmdFile()
 		return VmdParseResult;
 	}
 	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFileBoneKeyFrames", "Reading Bone Key Frames"));
-	uint32 BoneKeyFrameCount = 0;
-	FileReader->Serialize(&BoneKeyFrameCount, sizeof(uint32));
-	VmdParseResult.BoneKeyFrames.SetNum(BoneKeyFrameCount);
-	FileReader->Serialize(VmdParseResult.BoneKeyFrames.GetData(), sizeof(FVmdObject::FBoneKeyFrame) * BoneKeyFrameCount);
-	VmdParseResult.BoneKeyFrames.Sort([](const FVmdObject::FBoneKeyFrame& A, const FVmdObject::FBoneKeyFrame& B) { return A.FrameNumber < B.FrameNumber; });
+	if (EnumHasAnyFlags(Sections, EVmdSections::Bone))
+	{
+		ReadSection(*FileReader, Directory.BoneKeyFrames, VmdParseResult.BoneKeyFrames);
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.BoneKeyFrames);
+	}
 
 	if (ImportVmdTask.ShouldCancel())
 	{
 		return VmdParseResult;
 	}
 	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFileMorphKeyFrames", "Reading Morph Key Frames"));
-	uint32 MorphKeyFrameCount = 0;
-	FileReader->Serialize(&MorphKeyFrameCount, sizeof(uint32));
-	VmdParseResult.MorphKeyFrames.SetNum(MorphKeyFrameCount);
-	FileReader->Serialize(VmdParseResult.MorphKeyFrames.GetData(), sizeof(FVmdObject::FMorphKeyFrame) * MorphKeyFrameCount);
-	VmdParseResult.MorphKeyFrames.Sort([](const FVmdObject::FMorphKeyFrame& A, const FVmdObject::FMorphKeyFrame& B) { return A.FrameNumber < B.FrameNumber; });
+	if (EnumHasAnyFlags(Sections, EVmdSections::Morph))
+	{
+		ReadSection(*FileReader, Directory.MorphKeyFrames, VmdParseResult.MorphKeyFrames);
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.MorphKeyFrames);
+	}
 
 	if (ImportVmdTask.ShouldCancel())
 	{
 		return VmdParseResult;
 	}
-	if (FileSize < FileReader->Tell() + static_cast<int64>(sizeof(uint32))) // some VMD files don't have camera, light key frames
+	if (!Directory.CameraKeyFrames.bIsPresent) // some VMD files don't have camera, light key frames
 	{
 		VmdParseResult.bIsSuccess = true;
 		return VmdParseResult;
 	}
 	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFileCameraKeyFrames", "Reading Camera Key Frames"));
-	uint32 CameraKeyFrameCount = 0;
-	FileReader->Serialize(&CameraKeyFrameCount, sizeof(uint32));
-	VmdParseResult.CameraKeyFrames.SetNum(CameraKeyFrameCount);
-	FileReader->Serialize(VmdParseResult.CameraKeyFrames.GetData(), sizeof(FVmdObject::FCameraKeyFrame) * CameraKeyFrameCount);
-	VmdParseResult.CameraKeyFrames.Sort([](const FVmdObject::FCameraKeyFrame& A, const FVmdObject::FCameraKeyFrame& B) { return A.FrameNumber < B.FrameNumber; });
+	if (EnumHasAnyFlags(Sections, EVmdSections::Camera))
+	{
+		ReadSection(*FileReader, Directory.CameraKeyFrames, VmdParseResult.CameraKeyFrames);
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.CameraKeyFrames);
+	}
 
 	if (ImportVmdTask.ShouldCancel())
 	{
 		return VmdParseResult;
 	}
 	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFileLightKeyFrames", "Reading Light Key Frames"));
-	uint32 LightKeyFrameCount = 0;
-	FileReader->Serialize(&LightKeyFrameCount, sizeof(uint32));
-	VmdParseResult.LightKeyFrames.SetNum(LightKeyFrameCount);
-	FileReader->Serialize(VmdParseResult.LightKeyFrames.GetData(), sizeof(FVmdObject::FLightKeyFrame) * LightKeyFrameCount);
-	VmdParseResult.LightKeyFrames.Sort([](const FVmdObject::FLightKeyFrame& A, const FVmdObject::FLightKeyFrame& B) { return A.FrameNumber < B.FrameNumber; });
+	if (EnumHasAnyFlags(Sections, EVmdSections::Light))
+	{
+		ReadSection(*FileReader, Directory.LightKeyFrames, VmdParseResult.LightKeyFrames);
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.LightKeyFrames);
+	}
 
 	if (ImportVmdTask.ShouldCancel())
 	{
 		return VmdParseResult;
 	}
-	if (FileSize < FileReader->Tell() + static_cast<int64>(sizeof(uint32))) // some VMD files don't have self shadow key frames
+	if (!Directory.SelfShadowKeyFrames.bIsPresent) // some VMD files don't have self shadow key frames
 	{
 		VmdParseResult.bIsSuccess = true;
 		return VmdParseResult;
 	}
 	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFileSelfShadowKeyFrames", "Reading Self Shadow Key Frames"));
-	uint32 SelfShadowKeyFrameCount = 0;
-	FileReader->Serialize(&SelfShadowKeyFrameCount, sizeof(uint32));
-	VmdParseResult.SelfShadowKeyFrames.SetNum(SelfShadowKeyFrameCount);
-	FileReader->Serialize(VmdParseResult.SelfShadowKeyFrames.GetData(), sizeof(FVmdObject::FSelfShadowKeyFrame) * SelfShadowKeyFrameCount);
-	VmdParseResult.SelfShadowKeyFrames.Sort([](const FVmdObject::FSelfShadowKeyFrame& A, const FVmdObject::FSelfShadowKeyFrame& B) { return A.FrameNumber < B.FrameNumber; });
+	if (EnumHasAnyFlags(Sections, EVmdSections::SelfShadow))
+	{
+		ReadSection(*FileReader, Directory.SelfShadowKeyFrames, VmdParseResult.SelfShadowKeyFrames);
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.SelfShadowKeyFrames);
+	}
 
 	if (ImportVmdTask.ShouldCancel())
 	{
 		return VmdParseResult;
 	}
-	if (FileSize < FileReader->Tell() + static_cast<int64>(sizeof(uint32))) // some VMD files don't have property key frames
+	if (!Directory.PropertyKeyFrames.bIsPresent || !EnumHasAnyFlags(Sections, EVmdSections::Property)) // some VMD files don't have property key frames
 	{
 		VmdParseResult.bIsSuccess = true;
 		return VmdParseResult;
 	}
 	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFilePropertyKeyFrames", "Reading Property Key Frames"));
-	uint32 PropertyKeyFrameCount = 0;
-	FileReader->Serialize(&PropertyKeyFrameCount, sizeof(uint32));
-	VmdParseResult.PropertyKeyFrames.SetNum(PropertyKeyFrameCount);
 	{
-		FScopedSlowTask ImportPropertyKeyFramesTask(PropertyKeyFrameCount, LOCTEXT("ReadingVMDFilePropertyKeyFrames", "Reading Property Key Frames"));
+		// whole section in one read, then decoded in memory
+		TArray<uint8> SectionBytes;
+		SectionBytes.SetNumUninitialized(static_cast<int32>(Directory.EndOffset - Directory.PropertyKeyFrames.Offset));
+		FileReader->Seek(Directory.PropertyKeyFrames.Offset);
+		FileReader->Serialize(SectionBytes.GetData(), SectionBytes.Num());
 
-		for (PTRINT i = 0; i < PropertyKeyFrameCount; ++i)
+		if (!DecodePropertyKeyFrames(SectionBytes, Directory, VmdParseResult))
 		{
-			if (ImportPropertyKeyFramesTask.ShouldCancel())
-			{
-				return VmdParseResult;
-			}
-			ImportPropertyKeyFramesTask.EnterProgressFrame();
-
-			FVmdObject::FPropertyKeyFrame PropertyKeyFrame;
-			FileReader->Serialize(&PropertyKeyFrame, sizeof(FVmdObject::FPropertyKeyFrame));
-			VmdParseResult.PropertyKeyFrames[i].FrameNumber = PropertyKeyFrame.FrameNumber;
-			VmdParseResult.PropertyKeyFrames[i].Visible = static_cast<bool>(PropertyKeyFrame.Visible);
-
-			uint32 IkStateCount = 0;
-			FileReader->Serialize(&IkStateCount, sizeof(uint32));
-			VmdParseResult.PropertyKeyFrames[i].IkStates.SetNum(IkStateCount);
-			FileReader->Serialize(VmdParseResult.PropertyKeyFrames[i].IkStates.GetData(), sizeof(FVmdObject::FPropertyKeyFrame::FIkState) * IkStateCount);
+			return VmdParseResult;
 		}
 	}
-	VmdParseResult.PropertyKeyFrames.Sort([](const FVmdParseResult::FPropertyKeyFrameWithIkState& A, const FVmdParseResult::FPropertyKeyFrameWithIkState& B) { return A.FrameNumber < B.FrameNumber; });
 
 	VmdParseResult.bIsSuccess = true;
 
 	return VmdParseResult;
 }
 
+FVmdCameraImportParams FVmdCameraImportParams::Make(const UMovieScene* InMovieScene, const UMmdUserImportVmdSettings* ImportVmdSettings)
+{
+	FVmdCameraImportParams Params;
+	Params.SampleRate = InMovieScene->GetDisplayRate();
+	Params.FrameRate = InMovieScene->GetTickResolution();
+	Params.ImportUniformScale = ImportVmdSettings->ImportUniformScale;
+	Params.CameraCutImportType = ImportVmdSettings->CameraCutImportType;
+	Params.CameraCount = ImportVmdSettings->CameraCount;
+	Params.CurveImportType = ImportVmdSettings->CurveImportType;
+	Params.bAddMotionBlurKey = ImportVmdSettings->bAddMotionBlurKey;
+	Params.MotionBlurAmount = ImportVmdSettings->MotionBlurAmount;
+	Params.SensorWidth = ImportVmdSettings->CameraFilmback.SensorWidth;
+	Params.SensorHeight = ImportVmdSettings->CameraFilmback.SensorHeight;
+	Params.KeyReductionType = ImportVmdSettings->KeyReductionType;
+	Params.PositionTolerance = ImportVmdSettings->PositionTolerance;
+	Params.AngleTolerance = ImportVmdSettings->AngleTolerance;
+	Params.FocalLengthTolerance = ImportVmdSettings->FocalLengthTolerance;
+	Params.CameraCutPositionTolerance = ImportVmdSettings->CameraCutPositionTolerance;
+	Params.CameraCutAngleTolerance = ImportVmdSettings->CameraCutAngleTolerance;
+	Params.CameraCutViewAngleTolerance = ImportVmdSettings->CameraCutViewAngleTolerance;
+	Params.CameraCutMaxFrameGap = ImportVmdSettings->CameraCutMaxFrameGap;
+	Params.bParallelChannels = true;
+	Params.bReimportExisting = ImportVmdSettings->bReimportExisting;
+	Params.bUseImportCache = ImportVmdSettings->bUseImportCache;
+	return Params;
+}
+
+VmdCore::FCameraCutThresholds FVmdCameraImportParams::GetCameraCutThresholds() const
+{
+	VmdCore::FCameraCutThresholds Thresholds;
+	Thresholds.PositionTolerance = ImportUniformScale > 0.0f ? CameraCutPositionTolerance / ImportUniformScale : 0.0f;
+	Thresholds.AngleTolerance = FMath::DegreesToRadians(CameraCutAngleTolerance);
+	Thresholds.ViewAngleTolerance = CameraCutViewAngleTolerance;
+	Thresholds.MaxFrameGap = static_cast<uint32>(FMath::Max(CameraCutMaxFrameGap, 1));
+	return Thresholds;
+}
+
 void FVmdImporter::ImportVmdCamera(
 	const FVmdParseResult& InVmdParseResult,
 	UMovieSceneSequence* InSequence,
@@ -307,318 +411,785 @@ void FVmdImporter::ImportVmdCamera(
 		return;
 	}
 
+	const FVmdCameraImportParams Params = FVmdCameraImportParams::Make(InSequence->GetMovieScene(), ImportVmdSettings);
+
+	const FVmdComputedCamera ComputedCamera = FVmdImportCache::ComputeVmdCamera(InVmdParseResult.CameraKeyFrames, Params);
+
+	ImportComputedVmdCamera(
+		ComputedCamera,
+		InVmdParseResult.CameraKeyFrames[0],
+		InSequence,
+		InSequencer,
+		Params);
+}
+
+void FVmdImporter::ImportComputedVmdCamera(
+	const FVmdComputedCamera& InComputedCamera,
+	const FVmdObject::FCameraKeyFrame& InFirstKeyFrame,
+	UMovieSceneSequence* InSequence,
+	ISequencer& InSequencer,
+	const FVmdCameraImportParams& Params
+)
+{
 	TArray<FGuid> CameraGuids;
 	TArray<FGuid> CameraCenterGuids;
-	CameraGuids.Reserve(ImportVmdSettings->CameraCount);
-	CameraCenterGuids.Reserve(ImportVmdSettings->CameraCount);
 
-	for (PTRINT i = 0; i < ImportVmdSettings->CameraCount; ++i)
+	if (Params.bReimportExisting)
 	{
-		UWorld* World = GCurrentLevelEditingViewportClient ? GCurrentLevelEditingViewportClient->GetWorld() : nullptr;
-		check(World != nullptr && "World is null");
-
-		FActorSpawnParameters CameraCenterSpawnParams;
-		CameraCenterSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		AActor* NewCameraCenter = World->SpawnActor<AActor>(CameraCenterSpawnParams);
-		NewCameraCenter->SetActorLabel(FString::Format(TEXT("MmdCameraCenter{0}"), { i }));
-		USceneComponent* RootSceneComponent = NewObject<USceneComponent>(NewCameraCenter, TEXT("SceneComponent"));
-		NewCameraCenter->SetRootComponent(RootSceneComponent);
-		NewCameraCenter->AddInstanceComponent(RootSceneComponent);
+		const FMovieSceneSequenceIDRef TemplateID = InSequencer.GetFocusedTemplateID();
+		if (FindImportedCameraBindings(InSequence->GetMovieScene(), &InSequencer, TemplateID, Params.CameraCount, CameraGuids, CameraCenterGuids))
+		{
+			const auto FindBoundObject = [&InSequencer, TemplateID](const FGuid& Guid, const UClass* Class) -> UObject*
+			{
+				for (const TWeakObjectPtr<>& WeakObject : InSequencer.FindBoundObjects(Guid, TemplateID))
+				{
+					if (WeakObject.IsValid() && WeakObject->IsA(Class))
+					{
+						return WeakObject.Get();
+					}
+				}
+				return nullptr;
+			};
 
-		FActorSpawnParameters CameraSpawnParams;
-		CameraSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		ACineCameraActor* NewCamera = World->SpawnActor<ACineCameraActor>(CameraSpawnParams);
-		NewCamera->SetActorLabel(FString::Format(TEXT("MmdCamera{0}"), { i }));
+			for (int32 i = 0; i < Params.CameraCount; ++i)
+			{
+				// only missing cameras are spawned, the labels of the existing ones stay unique
+				if (!CameraGuids[i].IsValid())
+				{
+					SpawnCameraActors(i, InFirstKeyFrame, InSequencer, Params, CameraGuids[i], CameraCenterGuids[i]);
+					continue;
+				}
 
-		NewCamera->AttachToActor(NewCameraCenter, FAttachmentTransformRules(EAttachmentRule::KeepWorld, true));
+				// the settings and the first frame may differ from the previous import
+				ACineCameraActor* Camera = Cast<ACineCameraActor>(FindBoundObject(CameraGuids[i], ACineCameraActor::StaticClass()));
+				AActor* CameraCenter = Cast<AActor>(FindBoundObject(CameraCenterGuids[i], AActor::StaticClass()));
+				if (Camera != nullptr && CameraCenter != nullptr)
+				{
+					Camera->Modify();
+					Camera->GetCineCameraComponent()->Modify();
+					CameraCenter->Modify();
+					ApplyCameraDefaults(Camera, CameraCenter, InFirstKeyFrame, Params);
+				}
+			}
 
-		{
-			// ReSharper disable once CppUseStructuredBinding
-			const FVmdObject::FCameraKeyFrame FirstFrame = InVmdParseResult.CameraKeyFrames[0];
-			const float UniformScale = ImportVmdSettings->ImportUniformScale;
-			
-			NewCamera->SetActorRelativeLocation(FVector(FirstFrame.Distance * UniformScale, 0, 0));
-
-			// Position:
-			// X -> Y
-			// Y -> Z
-			// Z -> X
-			NewCameraCenter->SetActorRelativeLocation(
-				FVector(
-					FirstFrame.Position[2] * UniformScale,
-					FirstFrame.Position[0] * UniformScale,
-					FirstFrame.Position[1] * UniformScale));
-
-			// Rotation:
-			// X -> Y
-			// Y -> Z
-			// Z -> X
-			NewCameraCenter->SetActorRelativeRotation(
-				FRotator(
-					FMath::RadiansToDegrees(FirstFrame.Rotation[2]),
-					FMath::RadiansToDegrees(FirstFrame.Rotation[0]),
-					-FMath::RadiansToDegrees(FirstFrame.Rotation[1])));
-
-			UCineCameraComponent* CineCameraComponent = NewCamera->GetCineCameraComponent();
-
-			CineCameraComponent->Filmback.SensorWidth = ImportVmdSettings->CameraFilmback.SensorWidth;
-			CineCameraComponent->Filmback.SensorHeight = ImportVmdSettings->CameraFilmback.SensorHeight;
-
-			CineCameraComponent->CurrentFocalLength =
-				ComputeFocalLength(FirstFrame.ViewAngle, CineCameraComponent->Filmback.SensorWidth) / 2;
-
-			CineCameraComponent->FocusSettings.FocusMethod = ECameraFocusMethod::Disable;
+			FVmdReimportStats ReimportStats;
+			ImportVmdCameraToExisting(
+				InComputedCamera,
+				InSequence,
+				&InSequencer,
+				TemplateID,
+				CameraGuids,
+				CameraCenterGuids,
+				&ReimportStats);
+
+			UE_LOG(
+				LogMMDCameraImporter,
+				Log,
+				TEXT("Re-import: %d of %d channels changed, %d keys rewritten%s"),
+				ReimportStats.ChangedChannels,
+				ReimportStats.ChangedChannels + ReimportStats.UnchangedChannels,
+				ReimportStats.RewrittenKeys,
+				ReimportStats.bCameraCutsChanged ? TEXT(", camera cuts rebuilt") : TEXT(""));
+			return;
 		}
 
-		TArray<TWeakObjectPtr<AActor>> NewActors;
-		NewActors.Add(NewCameraCenter);
-		NewActors.Add(NewCamera);
-		TArray<FGuid> NewActorGuids = InSequencer.AddActors(NewActors);
-		
-		CameraCenterGuids.Add(NewActorGuids[0]);
-		CameraGuids.Add(NewActorGuids[1]);
+		UE_LOG(LogMMDCameraImporter, Log, TEXT("No previously imported cameras found, importing new cameras"));
+	}
+
+	CameraGuids.SetNum(Params.CameraCount);
+	CameraCenterGuids.SetNum(Params.CameraCount);
+
+	for (int32 i = 0; i < Params.CameraCount; ++i)
+	{
+		SpawnCameraActors(i, InFirstKeyFrame, InSequencer, Params, CameraGuids[i], CameraCenterGuids[i]);
 	}
 
 	ImportVmdCameraToExisting(
-		InVmdParseResult,
+		InComputedCamera,
 		InSequence,
 		&InSequencer,
 		InSequencer.GetFocusedTemplateID(),
 		CameraGuids,
 		CameraCenterGuids,
-		ImportVmdSettings);
+		nullptr);
 }
 
-FArchive* FVmdImporter::OpenFile(const FString FilePath)
+void FVmdImporter::SpawnCameraActors(
+	const int32 Index,
+	const FVmdObject::FCameraKeyFrame& InFirstKeyFrame,
+	ISequencer& InSequencer,
+	const FVmdCameraImportParams& Params,
+	FGuid& OutCameraGuid,
+	FGuid& OutCameraCenterGuid
+)
 {
-	return IFileManager::Get().CreateFileReader(*FilePath);
+	UWorld* World = GCurrentLevelEditingViewportClient ? GCurrentLevelEditingViewportClient->GetWorld() : nullptr;
+	check(World != nullptr && "World is null");
+
+	FActorSpawnParameters CameraCenterSpawnParams;
+	CameraCenterSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AActor* NewCameraCenter = World->SpawnActor<AActor>(CameraCenterSpawnParams);
+	NewCameraCenter->SetActorLabel(FString::Format(TEXT("MmdCameraCenter{0}"), { Index }));
+	USceneComponent* RootSceneComponent = NewObject<USceneComponent>(NewCameraCenter, TEXT("SceneComponent"));
+	NewCameraCenter->SetRootComponent(RootSceneComponent);
+	NewCameraCenter->AddInstanceComponent(RootSceneComponent);
+
+	FActorSpawnParameters CameraSpawnParams;
+	CameraSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	ACineCameraActor* NewCamera = World->SpawnActor<ACineCameraActor>(CameraSpawnParams);
+	NewCamera->SetActorLabel(FString::Format(TEXT("MmdCamera{0}"), { Index }));
+
+	NewCamera->AttachToActor(NewCameraCenter, FAttachmentTransformRules(EAttachmentRule::KeepWorld, true));
+
+	ApplyCameraDefaults(NewCamera, NewCameraCenter, InFirstKeyFrame, Params);
+
+	TArray<TWeakObjectPtr<AActor>> NewActors;
+	NewActors.Add(NewCameraCenter);
+	NewActors.Add(NewCamera);
+	TArray<FGuid> NewActorGuids = InSequencer.AddActors(NewActors);
+
+	OutCameraCenterGuid = NewActorGuids[0];
+	OutCameraGuid = NewActorGuids[1];
 }
 
-void FVmdImporter::ImportVmdCameraToExisting(
-	const FVmdParseResult& InVmdParseResult,
-	UMovieSceneSequence* InSequence,
+void FVmdImporter::ApplyCameraDefaults(
+	ACineCameraActor* Camera,
+	AActor* CameraCenter,
+	const FVmdObject::FCameraKeyFrame& InFirstKeyFrame,
+	const FVmdCameraImportParams& Params
+)
+{
+	// ReSharper disable once CppUseStructuredBinding
+	const FVmdObject::FCameraKeyFrame FirstFrame = InFirstKeyFrame;
+	const float UniformScale = Params.ImportUniformScale;
+
+	Camera->SetActorRelativeLocation(FVector(FirstFrame.Distance * UniformScale, 0, 0));
+
+	// Position:
+	// X -> Y
+	// Y -> Z
+	// Z -> X
+	CameraCenter->SetActorRelativeLocation(
+		FVector(
+			FirstFrame.Position[2] * UniformScale,
+			FirstFrame.Position[0] * UniformScale,
+			FirstFrame.Position[1] * UniformScale));
+
+	// Rotation:
+	// X -> Y
+	// Y -> Z
+	// Z -> X
+	CameraCenter->SetActorRelativeRotation(
+		FRotator(
+			FMath::RadiansToDegrees(FirstFrame.Rotation[2]),
+			FMath::RadiansToDegrees(FirstFrame.Rotation[0]),
+			-FMath::RadiansToDegrees(FirstFrame.Rotation[1])));
+
+	UCineCameraComponent* CineCameraComponent = Camera->GetCineCameraComponent();
+
+	CineCameraComponent->Filmback.SensorWidth = Params.SensorWidth;
+	CineCameraComponent->Filmback.SensorHeight = Params.SensorHeight;
+
+	CineCameraComponent->CurrentFocalLength =
+		ComputeFocalLength(FirstFrame.ViewAngle, CineCameraComponent->Filmback.SensorWidth) / 2;
+
+	CineCameraComponent->FocusSettings.FocusMethod = ECameraFocusMethod::Disable;
+}
+
+bool FVmdImporter::FindImportedCameraBindings(
+	UMovieScene* InMovieScene,
 	IMovieScenePlayer* Player,
 	FMovieSceneSequenceIDRef TemplateID,
-	const TArray<FGuid>& CameraGuids,
-	const TArray<FGuid>& CameraCenterGuids,
-	const UMmdUserImportVmdSettings* ImportVmdSettings
+	const int32 CameraCount,
+	TArray<FGuid>& OutCameraGuids,
+	TArray<FGuid>& OutCameraCenterGuids
 )
 {
-	UMovieScene* MovieScene = InSequence->GetMovieScene();
-
-	TArray<FGuid> CameraPropertyOwnerGuids;
-	TArray<UCineCameraComponent*> CameraComponents;
+	OutCameraGuids.Reset(CameraCount);
+	OutCameraCenterGuids.Reset(CameraCount);
 
-	// ReSharper disable once CppUseStructuredBinding
-	for (const FGuid& MmdCameraGuid : CameraGuids)
+	// bindings are named after the actor labels given on import
+	const auto FindBinding = [InMovieScene](const FString& Name)
 	{
-		const TArrayView<TWeakObjectPtr<>> BoundObjects = Player->FindBoundObjects(MmdCameraGuid, TemplateID);
-		for (TWeakObjectPtr<>& WeakObject : BoundObjects)
+		for (int32 i = 0; i < InMovieScene->GetPossessableCount(); ++i)
 		{
-			// ReSharper disable once CppTooWideScopeInitStatement
-			UObject* FoundObject = WeakObject.Get();
-
-			if (FoundObject && FoundObject->GetClass()->IsChildOf(ACineCameraActor::StaticClass()))
+			const FMovieScenePossessable& Possessable = InMovieScene->GetPossessable(i);
+			if (Possessable.GetName() == Name)
 			{
-				const ACineCameraActor* CineCameraActor = Cast<ACineCameraActor>(FoundObject);
-				UCineCameraComponent* CameraComponent = CineCameraActor->GetCineCameraComponent();
+				return Possessable.GetGuid();
+			}
+		}
+		for (int32 i = 0; i < InMovieScene->GetSpawnableCount(); ++i)
+		{
+			const FMovieSceneSpawnable& Spawnable = InMovieScene->GetSpawnable(i);
+			if (Spawnable.GetName() == Name)
+			{
+				return Spawnable.GetGuid();
+			}
+		}
+		return FGuid();
+	};
 
+	bool bFoundAny = false;
+	for (int32 i = 0; i < CameraCount; ++i)
+	{
+		FGuid CameraGuid = FindBinding(FString::Format(TEXT("MmdCamera{0}"), { i }));
+		FGuid CameraCenterGuid = FindBinding(FString::Format(TEXT("MmdCameraCenter{0}"), { i }));
 
-				// Set the default value of the current focal length or field of view section
-				//FGuid PropertyOwnerGuid = Player->GetHandleToObject(CameraComponent);
-				FGuid PropertyOwnerGuid = GetHandleToObject(CameraComponent, InSequence, Player, TemplateID, true);
+		// the focal length is keyed on the camera component, so the camera actor has to exist
+		const bool bHasCameraActor = CameraGuid.IsValid() && Player->FindBoundObjects(CameraGuid, TemplateID).ContainsByPredicate([](const TWeakObjectPtr<>& WeakObject)
+		{
+			return WeakObject.IsValid() && WeakObject->IsA<ACineCameraActor>();
+		});
 
-				if (!PropertyOwnerGuid.IsValid())
-				{
-					continue;
-				}
+		if (!bHasCameraActor || !CameraCenterGuid.IsValid())
+		{
+			CameraGuid.Invalidate();
+			CameraCenterGuid.Invalidate();
+		}
+		bFoundAny |= CameraGuid.IsValid();
 
-				// If copying properties to a spawnable object, the template object must be updated
-				// ReSharper disable once CppTooWideScope
-				FMovieSceneSpawnable* Spawnable = MovieScene->FindSpawnable(MmdCameraGuid);
-				if (Spawnable)
-				{
-					Spawnable->CopyObjectTemplate(*FoundObject, *InSequence);
-				}
+		OutCameraGuids.Add(CameraGuid);
+		OutCameraCenterGuids.Add(CameraCenterGuid);
+	}
 
-				CameraPropertyOwnerGuids.Add(PropertyOwnerGuid);
-				CameraComponents.Add(CameraComponent);
-			}
-		}
+	// cameras of a previous import with a higher camera count are no longer cut to
+	for (int32 i = CameraCount; FindBinding(FString::Format(TEXT("MmdCamera{0}"), { i })).IsValid(); ++i)
+	{
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("MmdCamera%d is not part of this import, its keys are left as they are"), i);
 	}
 
-	check(CameraPropertyOwnerGuids.Num() == CameraGuids.Num());
-	check(CameraComponents.Num() == CameraGuids.Num());
+	return bFoundAny;
+}
 
-	const TArray<TRange<uint32>> CameraCuts = ImportVmdSettings->CameraCount == 1
-		? TArray{ TRange<uint32>(0, InVmdParseResult.CameraKeyFrames.Last().FrameNumber + 1) }
-	    : ComputeCameraCuts(InVmdParseResult.CameraKeyFrames);
-	
-	CreateCameraCutTrack(CameraCuts, CameraGuids, InSequence);
+void FVmdImporter::ImportComputedVmdCameraAsSpawnables(
+	const FVmdComputedCamera& InComputedCamera,
+	UMovieSceneSequence* InSequence,
+	const FVmdCameraImportParams& Params
+)
+{
+	UMovieScene* MovieScene = InSequence->GetMovieScene();
+	MovieScene->Modify();
 
-	ImportVmdCameraFocalLengthProperty(
-		InVmdParseResult.CameraKeyFrames,
-		CameraCuts,
-		CameraPropertyOwnerGuids,
-		InSequence,
-		CameraComponents,
-		ImportVmdSettings);
+	const int32 FrameRatio = static_cast<int32>(Params.FrameRate.AsDecimal() / 30.f);
+	const int32 Duration = InComputedCamera.CameraCuts.Num() != 0
+		? static_cast<int32>(InComputedCamera.CameraCuts.Last().GetUpperBoundValue()) * FrameRatio
+		: 0;
+
+	TArray<FGuid> CameraGuids;
+	TArray<FGuid> CameraPropertyOwnerGuids;
+	TArray<FGuid> CameraCenterGuids;
+	CameraGuids.Reserve(Params.CameraCount);
+	CameraPropertyOwnerGuids.Reserve(Params.CameraCount);
+	CameraCenterGuids.Reserve(Params.CameraCount);
 
-	if (ImportVmdSettings->bAddMotionBlurKey)
+	for (PTRINT i = 0; i < Params.CameraCount; ++i)
 	{
-		CreateVmdCameraMotionBlurProperty(
-			InVmdParseResult.CameraKeyFrames,
-			CameraCuts,
-			CameraPropertyOwnerGuids,
-			InSequence,
-			ImportVmdSettings);
+		const FString CameraCenterLabel = FString::Format(TEXT("MmdCameraCenter{0}"), { i });
+		AActor* CameraCenterTemplate = NewObject<AActor>(
+			MovieScene,
+			AActor::StaticClass(),
+			MakeUniqueObjectName(MovieScene, AActor::StaticClass(), *CameraCenterLabel),
+			RF_Transactional);
+		USceneComponent* RootSceneComponent = NewObject<USceneComponent>(CameraCenterTemplate, TEXT("SceneComponent"), RF_Transactional);
+		CameraCenterTemplate->SetRootComponent(RootSceneComponent);
+		CameraCenterTemplate->AddInstanceComponent(RootSceneComponent);
+
+		const FString CameraLabel = FString::Format(TEXT("MmdCamera{0}"), { i });
+		ACineCameraActor* CameraTemplate = NewObject<ACineCameraActor>(
+			MovieScene,
+			ACineCameraActor::StaticClass(),
+			MakeUniqueObjectName(MovieScene, ACineCameraActor::StaticClass(), *CameraLabel),
+			RF_Transactional);
+
+		UCineCameraComponent* CineCameraComponent = CameraTemplate->GetCineCameraComponent();
+		CineCameraComponent->Filmback.SensorWidth = Params.SensorWidth;
+		CineCameraComponent->Filmback.SensorHeight = Params.SensorHeight;
+		CineCameraComponent->FocusSettings.FocusMethod = ECameraFocusMethod::Disable;
+
+		const FGuid CameraCenterGuid = MovieScene->AddSpawnable(CameraCenterLabel, *CameraCenterTemplate);
+		const FGuid CameraGuid = MovieScene->AddSpawnable(CameraLabel, *CameraTemplate);
+
+		// the camera component is possessed relative to the spawned camera
+		const FGuid CameraComponentGuid = MovieScene->AddPossessable(CineCameraComponent->GetName(), CineCameraComponent->GetClass());
+		{
+			FMovieScenePossessable* ComponentPossessable = MovieScene->FindPossessable(CameraComponentGuid);
+#if ENGINE_MAJOR_VERSION < 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION == 0)
+			ComponentPossessable->SetParent(CameraGuid);
+#else
+			ComponentPossessable->SetParent(CameraGuid, MovieScene);
+#endif
+			MovieScene->FindSpawnable(CameraGuid)->AddChildPossessable(CameraComponentGuid);
+			InSequence->BindPossessableObject(CameraComponentGuid, *CineCameraComponent, CameraTemplate);
+		}
+
+		// spawnables can't keep their attachment, so the camera is attached to its center with a track
+		{
+			UMovieScene3DAttachTrack* AttachTrack = MovieScene->AddTrack<UMovieScene3DAttachTrack>(CameraGuid);
+			AttachTrack->AddConstraint(
+				0,
+				Duration,
+				NAME_None,
+				NAME_None,
+				UE::MovieScene::FRelativeObjectBindingID(CameraCenterGuid));
+		}
+
+		CameraCenterGuids.Add(CameraCenterGuid);
+		CameraGuids.Add(CameraGuid);
+		CameraPropertyOwnerGuids.Add(CameraComponentGuid);
 	}
 
-	ImportVmdCameraTransform(
-		InVmdParseResult.CameraKeyFrames,
-		CameraCuts,
-		CameraGuids,
+	WriteComputedCamera(
+		InComputedCamera,
 		InSequence,
-		ImportVmdSettings);
-
-	ImportVmdCameraCenterTransform(
-		InVmdParseResult.CameraKeyFrames,
-		CameraCuts,
+		CameraGuids,
+		CameraPropertyOwnerGuids,
 		CameraCenterGuids,
-		InSequence,
-		ImportVmdSettings);
+		nullptr);
 }
 
-void FVmdImporter::CreateCameraCutTrack(
-	const TArray<TRange<uint32>>& InCameraCuts,
-	const TArray<FGuid>& ObjectBindings,
-	const UMovieSceneSequence* InSequence
+UMovieSceneSubSection* FVmdImporter::CreateShotSequence(
+	const FString& InFilePath,
+	const uint32 LastFrameNumber,
+	UMovieSceneSequence* InParentSequence
 )
 {
-	UMovieScene* MovieScene = InSequence->GetMovieScene();
+	UMovieScene* ParentMovieScene = InParentSequence->GetMovieScene();
 
-	UMovieSceneCameraCutTrack* CameraCutTrack = GetCameraCutTrack(MovieScene);
-	const FFrameRate FrameRate = CameraCutTrack->GetTypedOuter<UMovieScene>()->GetTickResolution();
+	const IAssetTools& AssetTools = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools").Get();
+
+	const FString BasePackageName = FPackageName::GetLongPackagePath(InParentSequence->GetOutermost()->GetName()) / FPaths::GetBaseFilename(InFilePath);
+	FString PackageName;
+	FString AssetName;
+	AssetTools.CreateUniqueAssetName(BasePackageName, TEXT(""), PackageName, AssetName);
+
+	UPackage* Package = CreatePackage(*PackageName);
+	ULevelSequence* ShotSequence = NewObject<ULevelSequence>(Package, *AssetName, RF_Public | RF_Standalone | RF_Transactional);
+	if (ShotSequence == nullptr)
+	{
+		return nullptr;
+	}
+	ShotSequence->Initialize();
+
+	const FFrameRate FrameRate = ParentMovieScene->GetTickResolution();
 	const int32 FrameRatio = static_cast<int32>(FrameRate.AsDecimal() / 30.f);
+	const FFrameNumber Duration = static_cast<int32>(LastFrameNumber + 1) * FrameRatio;
 
-	CameraCutTrack->RemoveAllAnimationData();
+	UMovieScene* ShotMovieScene = ShotSequence->GetMovieScene();
+	ShotMovieScene->SetTickResolutionDirectly(FrameRate);
+	ShotMovieScene->SetDisplayRate(ParentMovieScene->GetDisplayRate());
+	ShotMovieScene->SetPlaybackRange(0, Duration.Value);
 
-	for (PTRINT i = 0; i < InCameraCuts.Num(); ++i)
+	FAssetRegistryModule::AssetCreated(ShotSequence);
+	Package->MarkPackageDirty();
+
+#if ENGINE_MAJOR_VERSION < 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION < 2)
+	UMovieSceneCinematicShotTrack* ShotTrack = ParentMovieScene->FindMasterTrack<UMovieSceneCinematicShotTrack>();
+	if (ShotTrack == nullptr)
 	{
-		const TRange<uint32>& CameraCut = InCameraCuts[i];
-		const FGuid CameraBinding = ObjectBindings[i % ObjectBindings.Num()];
-		CameraCutTrack->AddNewCameraCut(
-			UE::MovieScene::FRelativeObjectBindingID(CameraBinding),
-			static_cast<int>(CameraCut.GetLowerBoundValue() * FrameRatio));
+		ParentMovieScene->Modify();
+		ShotTrack = ParentMovieScene->AddMasterTrack<UMovieSceneCinematicShotTrack>();
 	}
+#else
+	UMovieSceneCinematicShotTrack* ShotTrack = ParentMovieScene->FindTrack<UMovieSceneCinematicShotTrack>();
+	if (ShotTrack == nullptr)
+	{
+		ParentMovieScene->Modify();
+		ShotTrack = ParentMovieScene->AddTrack<UMovieSceneCinematicShotTrack>();
+	}
+#endif
+
+	// shots are appended one after another
+	FFrameNumber StartFrame = ParentMovieScene->GetPlaybackRange().GetLowerBoundValue();
+	for (const UMovieSceneSection* Section : ShotTrack->GetAllSections())
+	{
+		if (Section->HasEndFrame())
+		{
+			StartFrame = FMath::Max(StartFrame, Section->GetExclusiveEndFrame());
+		}
+	}
+
+	ShotTrack->Modify();
+	return ShotTrack->AddSequence(ShotSequence, StartFrame, Duration.Value);
 }
 
-bool FVmdImporter::ImportVmdCameraFocalLengthProperty(
-	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
-	const TArray<TRange<uint32>>& InCameraCuts,
-	const TArray<FGuid>& ObjectBindings,
-	const UMovieSceneSequence* InSequence,
-	const TArray<UCineCameraComponent*>& InCineCameraComponents,
-	const UMmdUserImportVmdSettings* ImportVmdSettings
-)
+TSharedPtr<const FVmdMappedFile> FVmdImporter::MapVmdFile()
 {
-	check(ObjectBindings.Num() != 0);
-	check(InCineCameraComponents.Num() != 0);
-
-	const UMovieScene* MovieScene = InSequence->GetMovieScene();
+	// a failed map or scan is remembered, the file is opened at most once
+	if (MapResult == EVmdMapResult::NotAttempted)
+	{
+		MappedFile = FVmdMappedFile::Open(FilePath, MapResult);
+	}
 
-	const FName TrackName = TEXT("CurrentFocalLength");
+	return MappedFile;
+}
 
-	TArray<FMovieSceneFloatChannel*> Channels;
-	Channels.Reserve(ObjectBindings.Num());
+FArchive* FVmdImporter::OpenFile(const FString FilePath)
+{
+	return IFileManager::Get().CreateFileReader(*FilePath);
+}
 
-	for (FGuid ObjectBinding : ObjectBindings)
+bool FVmdImporter::ScanArchive()
+{
+	if (!FileReader.IsValid())
 	{
-		UMovieSceneFloatTrack* FloatTrack = MovieScene->FindTrack<UMovieSceneFloatTrack>(ObjectBinding, TrackName);
-		if (FloatTrack == nullptr)
+		FileReader = TUniquePtr<FArchive>(OpenFile(FilePath));
+
+		if (!FileReader.IsValid())
 		{
+			UE_LOG(LogMMDCameraImporter, Error, TEXT("Can't open file(%s)"), *FilePath);
 			return false;
 		}
+	}
 
-		FloatTrack->Modify();
-		FloatTrack->RemoveAllAnimationData();
+	FVmdSectionDirectory Directory;
+	const bool bIsValid = FVmdSectionDirectory::Scan(
+		FileReader->TotalSize(),
+		[this](const int64 Offset, void* Dest, const int64 Size)
+		{
+			FileReader->Seek(Offset);
+			FileReader->Serialize(Dest, Size);
+			return !FileReader->IsError();
+		},
+		Directory);
 
-		bool bSectionAdded = false;
-		UMovieSceneFloatSection* FloatSection = Cast<UMovieSceneFloatSection>(FloatTrack->FindOrAddSection(0, bSectionAdded));
-		if (!FloatSection)
+	if (bIsValid)
+	{
+		SectionDirectory = MoveTemp(Directory);
+	}
+
+	return bIsValid;
+}
+
+FVmdParseResult FVmdImporter::ParseMappedVmdFile(const FVmdMappedFile& InMappedFile, const EVmdSections Sections)
+{
+	FScopedSlowTask ImportVmdTask(3, LOCTEXT("ReadingVMDFile", "Reading VMD File"));
+	ImportVmdTask.MakeDialog(true, true);
+
+	FVmdParseResult VmdParseResult;
+	VmdParseResult.bIsSuccess = false;
+	VmdParseResult.Header = InMappedFile.GetHeader();
+
+	if (ImportVmdTask.ShouldCancel())
+	{
+		return VmdParseResult;
+	}
+	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFileKeyFrames", "Reading Key Frames"));
+	if (EnumHasAnyFlags(Sections, EVmdSections::Bone))
+	{
+		VmdParseResult.BoneKeyFrames = FVmdMappedFile::Materialize(InMappedFile.GetBoneKeyFrames());
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.BoneKeyFrames);
+	}
+	if (EnumHasAnyFlags(Sections, EVmdSections::Morph))
+	{
+		VmdParseResult.MorphKeyFrames = FVmdMappedFile::Materialize(InMappedFile.GetMorphKeyFrames());
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.MorphKeyFrames);
+	}
+	if (EnumHasAnyFlags(Sections, EVmdSections::Camera))
+	{
+		VmdParseResult.CameraKeyFrames = FVmdMappedFile::Materialize(InMappedFile.GetCameraKeyFrames());
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.CameraKeyFrames);
+	}
+	if (EnumHasAnyFlags(Sections, EVmdSections::Light))
+	{
+		VmdParseResult.LightKeyFrames = FVmdMappedFile::Materialize(InMappedFile.GetLightKeyFrames());
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.LightKeyFrames);
+	}
+	if (EnumHasAnyFlags(Sections, EVmdSections::SelfShadow))
+	{
+		VmdParseResult.SelfShadowKeyFrames = FVmdMappedFile::Materialize(InMappedFile.GetSelfShadowKeyFrames());
+		FMmdImportHelper::SortByFrameNumber(VmdParseResult.SelfShadowKeyFrames);
+	}
+
+	if (ImportVmdTask.ShouldCancel())
+	{
+		return VmdParseResult;
+	}
+	ImportVmdTask.EnterProgressFrame(1, LOCTEXT("ReadingVMDFilePropertyKeyFrames", "Reading Property Key Frames"));
+	if (EnumHasAnyFlags(Sections, EVmdSections::Property) && InMappedFile.GetSectionDirectory().PropertyKeyFrames.bIsPresent)
+	{
+		if (!DecodePropertyKeyFrames(InMappedFile.GetPropertySection(), InMappedFile.GetSectionDirectory(), VmdParseResult))
 		{
-			return false;
+			return VmdParseResult;
 		}
+	}
 
-		FloatSection->Modify();
+	ImportVmdTask.EnterProgressFrame(1);
+	VmdParseResult.bIsSuccess = true;
 
-		if (bSectionAdded)
+	return VmdParseResult;
+}
+
+bool FVmdImporter::DecodePropertyKeyFrames(
+	const TConstArrayView<uint8> InSectionBytes,
+	const FVmdSectionDirectory& InDirectory,
+	FVmdParseResult& OutVmdParseResult
+)
+{
+	const TArray<FVmdSectionDirectory::FIkRun>& IkRuns = InDirectory.IkRuns;
+	const int64 BaseOffset = InDirectory.PropertyKeyFrames.Offset;
+
+	if (InSectionBytes.Num() != InDirectory.EndOffset - BaseOffset)
+	{
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("Failed to read property keyframes"));
+		return false;
+	}
+
+	int64 IkStateCount = 0;
+	for (const FVmdSectionDirectory::FIkRun& IkRun : IkRuns)
+	{
+		IkStateCount += IkRun.Count;
+	}
+	if (MAX_int32 < IkStateCount)
+	{
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Too many IK state keyframes)"));
+		return false;
+	}
+
+	TArray<FVmdParseResult::FPropertyKeyFrameState>& PropertyKeyFrames = OutVmdParseResult.PropertyKeyFrames;
+	TArray<int32>& IkStateOffsets = OutVmdParseResult.IkStateOffsets;
+	TArray<FVmdObject::FPropertyKeyFrame::FIkState>& IkStates = OutVmdParseResult.IkStates;
+
+	PropertyKeyFrames.SetNumUninitialized(IkRuns.Num());
+	IkStateOffsets.SetNumUninitialized(IkRuns.Num() + 1);
+	IkStates.SetNumUninitialized(static_cast<int32>(IkStateCount));
+
+	// run offsets come from the section directory, so bounds are already validated
+	const uint8* Data = InSectionBytes.GetData();
+	int32 IkStateOffset = 0;
+	for (int32 i = 0; i < IkRuns.Num(); ++i)
+	{
+		const FVmdSectionDirectory::FIkRun& IkRun = IkRuns[i];
+
+		FVmdObject::FPropertyKeyFrame RawPropertyKeyFrame;
+		FMemory::Memcpy(&RawPropertyKeyFrame, Data + (IkRun.KeyFrameOffset - BaseOffset), sizeof(FVmdObject::FPropertyKeyFrame));
+		PropertyKeyFrames[i].FrameNumber = RawPropertyKeyFrame.FrameNumber;
+		PropertyKeyFrames[i].Visible = static_cast<bool>(RawPropertyKeyFrame.Visible);
+
+		IkStateOffsets[i] = IkStateOffset;
+		FMemory::Memcpy(IkStates.GetData() + IkStateOffset, Data + (IkRun.Offset - BaseOffset), sizeof(FVmdObject::FPropertyKeyFrame::FIkState) * IkRun.Count);
+		IkStateOffset += static_cast<int32>(IkRun.Count);
+	}
+	IkStateOffsets[IkRuns.Num()] = IkStateOffset;
+
+	TArray<int32> Permutation;
+	if (FMmdImportHelper::ComputeFrameNumberPermutation(PropertyKeyFrames, Permutation))
+	{
+		TArray<FVmdParseResult::FPropertyKeyFrameState> SortedPropertyKeyFrames;
+		TArray<int32> SortedIkStateOffsets;
+		TArray<FVmdObject::FPropertyKeyFrame::FIkState> SortedIkStates;
+		SortedPropertyKeyFrames.Reserve(PropertyKeyFrames.Num());
+		SortedIkStateOffsets.Reserve(IkStateOffsets.Num());
+		SortedIkStates.Reserve(IkStates.Num());
+
+		for (const int32 Index : Permutation)
 		{
-			FloatSection->SetRange(TRange<FFrameNumber>::All());
+			SortedPropertyKeyFrames.Add(PropertyKeyFrames[Index]);
+			SortedIkStateOffsets.Add(SortedIkStates.Num());
+			SortedIkStates.Append(OutVmdParseResult.GetIkStates(Index).GetData(), IkStateOffsets[Index + 1] - IkStateOffsets[Index]);
 		}
+		SortedIkStateOffsets.Add(SortedIkStates.Num());
 
-		FMovieSceneFloatChannel* Channel = FloatSection->GetChannelProxy().GetChannel<FMovieSceneFloatChannel>(0);
-		Channels.Add(Channel);
+		PropertyKeyFrames = MoveTemp(SortedPropertyKeyFrames);
+		IkStateOffsets = MoveTemp(SortedIkStateOffsets);
+		IkStates = MoveTemp(SortedIkStates);
+	}
+
+	return true;
+}
+
+void FVmdImporter::ImportVmdCameraToExisting(
+	const FVmdComputedCamera& InComputedCamera,
+	UMovieSceneSequence* InSequence,
+	IMovieScenePlayer* Player,
+	FMovieSceneSequenceIDRef TemplateID,
+	const TArray<FGuid>& CameraGuids,
+	const TArray<FGuid>& CameraCenterGuids,
+	FVmdReimportStats* OutReimportStats
+)
+{
+	UMovieScene* MovieScene = InSequence->GetMovieScene();
+
+	TArray<FGuid> CameraPropertyOwnerGuids;
+
+	// ReSharper disable once CppUseStructuredBinding
+	for (const FGuid& MmdCameraGuid : CameraGuids)
+	{
+		const TArrayView<TWeakObjectPtr<>> BoundObjects = Player->FindBoundObjects(MmdCameraGuid, TemplateID);
+		for (TWeakObjectPtr<>& WeakObject : BoundObjects)
+		{
+			// ReSharper disable once CppTooWideScopeInitStatement
+			UObject* FoundObject = WeakObject.Get();
+
+			if (FoundObject && FoundObject->GetClass()->IsChildOf(ACineCameraActor::StaticClass()))
+			{
+				const ACineCameraActor* CineCameraActor = Cast<ACineCameraActor>(FoundObject);
+				UCineCameraComponent* CameraComponent = CineCameraActor->GetCineCameraComponent();
+
+
+				// Set the default value of the current focal length or field of view section
+				//FGuid PropertyOwnerGuid = Player->GetHandleToObject(CameraComponent);
+				FGuid PropertyOwnerGuid = GetHandleToObject(CameraComponent, InSequence, Player, TemplateID, true);
+
+				if (!PropertyOwnerGuid.IsValid())
+				{
+					continue;
+				}
+
+				// If copying properties to a spawnable object, the template object must be updated
+				// ReSharper disable once CppTooWideScope
+				FMovieSceneSpawnable* Spawnable = MovieScene->FindSpawnable(MmdCameraGuid);
+				if (Spawnable)
+				{
+					Spawnable->CopyObjectTemplate(*FoundObject, *InSequence);
+				}
+
+				CameraPropertyOwnerGuids.Add(PropertyOwnerGuid);
+			}
+		}
 	}
 
-	const FFrameRate SampleRate = MovieScene->GetDisplayRate();
-	const FFrameRate FrameRate = MovieScene->GetTickResolution();
-	const float SensorWidth = InCineCameraComponents.Last()->Filmback.SensorWidth;
-	FTangentAccessIndices TangentAccessIndices;
+	check(CameraPropertyOwnerGuids.Num() == CameraGuids.Num());
+
+	WriteComputedCamera(
+		InComputedCamera,
+		InSequence,
+		CameraGuids,
+		CameraPropertyOwnerGuids,
+		CameraCenterGuids,
+		OutReimportStats);
+}
+
+void FVmdImporter::WriteComputedCamera(
+	const FVmdComputedCamera& InComputedCamera,
+	UMovieSceneSequence* InSequence,
+	const TArray<FGuid>& CameraGuids,
+	const TArray<FGuid>& CameraPropertyOwnerGuids,
+	const TArray<FGuid>& CameraCenterGuids,
+	FVmdReimportStats* OutReimportStats
+)
+{
+	CreateCameraCutTrack(InComputedCamera.CameraCuts, CameraGuids, InSequence, OutReimportStats);
+
+	ImportVmdCameraFocalLengthProperty(
+		InComputedCamera.FocalLength,
+		CameraPropertyOwnerGuids,
+		InSequence,
+		OutReimportStats);
+
+	if (InComputedCamera.MotionBlur.CameraKeys.Num() != 0)
 	{
-		TangentAccessIndices.ArriveTangentX = 21;
-		TangentAccessIndices.ArriveTangentY = 23;
-		TangentAccessIndices.LeaveTangentX = 20;
-		TangentAccessIndices.LeaveTangentY = 22;
+		CreateVmdCameraMotionBlurProperty(
+			InComputedCamera.MotionBlur,
+			CameraPropertyOwnerGuids,
+			InSequence,
+			OutReimportStats);
+	}
+	else if (OutReimportStats != nullptr)
+	{
+		// the new motion has no motion blur, the keys of the previous import would be stale
+		RemoveVmdCameraMotionBlurProperty(CameraPropertyOwnerGuids, InSequence, OutReimportStats);
 	}
 
-	ImportCameraSingleChannel(
-		CameraKeyFrames,
-		InCameraCuts,
-		Channels,
-		SampleRate,
-		FrameRate,
-		ImportVmdSettings->CameraCutImportType,
-		TangentAccessIndices,
-		[](const FVmdObject::FCameraKeyFrame& KeyFrames)
+	ImportVmdCameraTransform(
+		InComputedCamera.Distance,
+		CameraGuids,
+		InSequence,
+		OutReimportStats);
+
+	ImportVmdCameraCenterTransform(
+		InComputedCamera,
+		CameraCenterGuids,
+		InSequence,
+		OutReimportStats);
+}
+
+void FVmdImporter::CreateCameraCutTrack(
+	const TArray<TRange<uint32>>& InCameraCuts,
+	const TArray<FGuid>& ObjectBindings,
+	const UMovieSceneSequence* InSequence,
+	FVmdReimportStats* OutReimportStats
+)
+{
+	UMovieScene* MovieScene = InSequence->GetMovieScene();
+
+	UMovieSceneCameraCutTrack* CameraCutTrack = GetCameraCutTrack(MovieScene);
+	const FFrameRate FrameRate = CameraCutTrack->GetTypedOuter<UMovieScene>()->GetTickResolution();
+	const int32 FrameRatio = static_cast<int32>(FrameRate.AsDecimal() / 30.f);
+
+	if (OutReimportStats != nullptr)
+	{
+		// cut sections are cheap to rebuild, they are only left alone if none of them changed
+		const TArray<UMovieSceneSection*>& Sections = CameraCutTrack->GetAllSections();
+		bool bIsSame = Sections.Num() == InCameraCuts.Num();
+		for (PTRINT i = 0; bIsSame && i < InCameraCuts.Num(); ++i)
 		{
-			return KeyFrames.ViewAngle;
-		},
-		[SensorWidth](const float Value)
+			const UMovieSceneCameraCutSection* CameraCutSection = Cast<UMovieSceneCameraCutSection>(Sections[i]);
+			bIsSame = CameraCutSection != nullptr &&
+				CameraCutSection->GetInclusiveStartFrame() == static_cast<int32>(InCameraCuts[i].GetLowerBoundValue() * FrameRatio) &&
+				CameraCutSection->GetCameraBindingID().GetGuid() == ObjectBindings[i % ObjectBindings.Num()];
+		}
+
+		if (bIsSame)
 		{
-			return ComputeFocalLength(Value, SensorWidth) / 2;
-		});
-	
-	return true;
+			return;
+		}
+
+		OutReimportStats->bCameraCutsChanged = true;
+		CameraCutTrack->Modify();
+	}
+
+	CameraCutTrack->RemoveAllAnimationData();
+
+	for (PTRINT i = 0; i < InCameraCuts.Num(); ++i)
+	{
+		const TRange<uint32>& CameraCut = InCameraCuts[i];
+		const FGuid CameraBinding = ObjectBindings[i % ObjectBindings.Num()];
+		CameraCutTrack->AddNewCameraCut(
+			UE::MovieScene::FRelativeObjectBindingID(CameraBinding),
+			static_cast<int>(CameraCut.GetLowerBoundValue() * FrameRatio));
+	}
 }
 
-bool FVmdImporter::CreateVmdCameraMotionBlurProperty(
-	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
-	const TArray<TRange<uint32>>& InCameraCuts,
+bool FVmdImporter::ImportVmdCameraFocalLengthProperty(
+	const TVmdComputedChannel<FMovieSceneFloatChannel>& InComputedChannel,
 	const TArray<FGuid>& ObjectBindings,
 	const UMovieSceneSequence* InSequence,
-	const UMmdUserImportVmdSettings* ImportVmdSettings
+	FVmdReimportStats* OutReimportStats
 )
 {
+	check(ObjectBindings.Num() != 0);
+
 	UMovieScene* MovieScene = InSequence->GetMovieScene();
 
-	const FName TrackName = TEXT("PostProcessSettings.MotionBlurAmount");
+	const FName TrackName = TEXT("CurrentFocalLength");
 
 	TArray<FMovieSceneFloatChannel*> Channels;
+	TArray<UMovieSceneSection*> Sections;
 	Channels.Reserve(ObjectBindings.Num());
+	Sections.Reserve(ObjectBindings.Num());
 
 	for (FGuid ObjectBinding : ObjectBindings)
 	{
 		UMovieSceneFloatTrack* FloatTrack = MovieScene->FindTrack<UMovieSceneFloatTrack>(ObjectBinding, TrackName);
 		if (FloatTrack == nullptr)
 		{
+			// sequencer adds this track when a camera actor is added, spawnables created without it don't have one
 			MovieScene->Modify();
 			FloatTrack = MovieScene->AddTrack<UMovieSceneFloatTrack>(ObjectBinding);
-			FloatTrack->SetPropertyNameAndPath("MotionBlurAmount", "PostProcessSettings.MotionBlurAmount");
+			FloatTrack->SetPropertyNameAndPath(TrackName, TrackName.ToString());
 		}
 
-		FloatTrack->Modify();
-		FloatTrack->RemoveAllAnimationData();
+		// a re-import keeps the section and only modifies what changes
+		if (OutReimportStats == nullptr)
+		{
+			FloatTrack->Modify();
+			FloatTrack->RemoveAllAnimationData();
+		}
+		else if (FloatTrack->GetAllSections().Num() == 0)
+		{
+			FloatTrack->Modify();
+		}
 
 		bool bSectionAdded = false;
 		UMovieSceneFloatSection* FloatSection = Cast<UMovieSceneFloatSection>(FloatTrack->FindOrAddSection(0, bSectionAdded));
@@ -627,172 +1198,145 @@ bool FVmdImporter::CreateVmdCameraMotionBlurProperty(
 			return false;
 		}
 
-		FloatSection->Modify();
-
-		if (bSectionAdded)
+		if (OutReimportStats == nullptr || bSectionAdded)
 		{
-			FloatSection->SetRange(TRange<FFrameNumber>::All());
+			FloatSection->Modify();
 		}
 
-		if (CameraKeyFrames.Num() == 0)
+		if (bSectionAdded)
 		{
-			return true;
+			FloatSection->SetRange(TRange<FFrameNumber>::All());
 		}
 
 		FMovieSceneFloatChannel* Channel = FloatSection->GetChannelProxy().GetChannel<FMovieSceneFloatChannel>(0);
 		Channels.Add(Channel);
+		Sections.Add(FloatSection);
 	}
 
-	const FFrameRate SampleRate = MovieScene->GetDisplayRate();
-	const FFrameRate FrameRate = MovieScene->GetTickResolution();
-	const FFrameNumber OneSampleFrame = (FrameRate / SampleRate).AsFrameNumber(1);
-	const int32 FrameRatio = static_cast<int32>(FrameRate.AsDecimal() / 30.f);
-	const float MotionBlurAmount = ImportVmdSettings->MotionBlurAmount;
-	const ECameraCutImportType CameraCutImportType = ImportVmdSettings->CameraCutImportType;
-
-	for (FMovieSceneFloatChannel* MovieSceneFloatChannel : Channels)
+	if (OutReimportStats != nullptr)
 	{
-		MovieSceneFloatChannel->SetDefault(MotionBlurAmount);
+		MergeComputedChannel(InComputedChannel, Channels, Sections, *OutReimportStats);
 	}
-
-	TArray<TRange<uint32>> CameraCutRanges;
+	else
 	{
-		uint32 RangeStart = CameraKeyFrames[0].FrameNumber;
-
-		for (PTRINT i = 1; i < CameraKeyFrames.Num(); ++i)
-		{
-			// ReSharper disable once CppUseStructuredBinding
-			const FVmdObject::FCameraKeyFrame& PreviousFrame = CameraKeyFrames[i - 1];
-			// ReSharper disable once CppUseStructuredBinding
-			const FVmdObject::FCameraKeyFrame& CurrentFrame = CameraKeyFrames[i];
-
-			if (
-				(CurrentFrame.FrameNumber - PreviousFrame.FrameNumber) <= 1 &&
-
-				(CurrentFrame.ViewAngle != PreviousFrame.ViewAngle ||
-				CurrentFrame.Distance != PreviousFrame.Distance ||
-				CurrentFrame.Position[0] != PreviousFrame.Position[0] ||
-				CurrentFrame.Position[1] != PreviousFrame.Position[1] ||
-				CurrentFrame.Position[2] != PreviousFrame.Position[2] ||
-				CurrentFrame.Rotation[0] != PreviousFrame.Rotation[0] ||
-				CurrentFrame.Rotation[1] != PreviousFrame.Rotation[1] ||
-				CurrentFrame.Rotation[2] != PreviousFrame.Rotation[2]))
-			{
-				continue;
-			}
-
-			if (PreviousFrame.FrameNumber != RangeStart)
-			{
-				CameraCutRanges.Push(TRange<uint32>(RangeStart, PreviousFrame.FrameNumber));
-			}
-			RangeStart = CurrentFrame.FrameNumber;
-		}
+		CommitComputedChannel(InComputedChannel, Channels);
 	}
+	
+	return true;
+}
 
-	TArray<TPair<FFrameNumber, FMovieSceneFloatValue>> Keys;
-
-	if (0 < CameraCutRanges.Num() && CameraCutRanges[0].GetLowerBoundValue() != 0)
-	{
-		FMovieSceneFloatValue MovieSceneFloatValue;
-		MovieSceneFloatValue.Value = MotionBlurAmount;
-		MovieSceneFloatValue.InterpMode = RCIM_Constant;
-		Keys.Add({ 0, MovieSceneFloatValue });
-	}
+bool FVmdImporter::CreateVmdCameraMotionBlurProperty(
+	const TVmdComputedChannel<FMovieSceneFloatChannel>& InComputedChannel,
+	const TArray<FGuid>& ObjectBindings,
+	const UMovieSceneSequence* InSequence,
+	FVmdReimportStats* OutReimportStats
+)
+{
+	UMovieScene* MovieScene = InSequence->GetMovieScene();
 
-	for (TRange<uint32>& CameraCutRange : CameraCutRanges)
-	{
-		const uint32 LowerBound = CameraCutRange.GetLowerBoundValue();
-		const uint32 UpperBound = CameraCutRange.GetUpperBoundValue();
+	const FName TrackName = TEXT("PostProcessSettings.MotionBlurAmount");
 
+	TArray<FMovieSceneFloatChannel*> Channels;
+	TArray<UMovieSceneSection*> Sections;
+	Channels.Reserve(ObjectBindings.Num());
+	Sections.Reserve(ObjectBindings.Num());
 
-		if (CameraCutImportType == ECameraCutImportType::ImportAsIs)
-		{
-			FMovieSceneFloatValue MovieSceneFloatValue;
-			MovieSceneFloatValue.Value = 0.0f;
-			MovieSceneFloatValue.InterpMode = RCIM_Constant;
-			Keys.Add({ static_cast<int32>(LowerBound) * FrameRatio, MovieSceneFloatValue });
-		}
-		else
+	for (FGuid ObjectBinding : ObjectBindings)
+	{
+		UMovieSceneFloatTrack* FloatTrack = MovieScene->FindTrack<UMovieSceneFloatTrack>(ObjectBinding, TrackName);
+		if (FloatTrack == nullptr)
 		{
-			FMovieSceneFloatValue MovieSceneFloatValue;
-			MovieSceneFloatValue.Value = 0.0f;
-			MovieSceneFloatValue.InterpMode = RCIM_Constant;
-			Keys.Add({ (static_cast<int32>(LowerBound + 1) * FrameRatio) - OneSampleFrame, MovieSceneFloatValue });
+			MovieScene->Modify();
+			FloatTrack = MovieScene->AddTrack<UMovieSceneFloatTrack>(ObjectBinding);
+			FloatTrack->SetPropertyNameAndPath("MotionBlurAmount", "PostProcessSettings.MotionBlurAmount");
 		}
 
+		// a re-import keeps the section and only modifies what changes
+		if (OutReimportStats == nullptr)
 		{
-			FMovieSceneFloatValue MovieSceneFloatValue;
-			MovieSceneFloatValue.Value = MotionBlurAmount;
-			MovieSceneFloatValue.InterpMode = RCIM_Constant;
-			Keys.Add({ (static_cast<int32>(UpperBound) * FrameRatio) + OneSampleFrame, MovieSceneFloatValue });
+			FloatTrack->Modify();
+			FloatTrack->RemoveAllAnimationData();
+		}
+		else if (FloatTrack->GetAllSections().Num() == 0)
+		{
+			FloatTrack->Modify();
 		}
-	}
-
-	PTRINT CurrentCameraCutIndex = 0;
-	for (PTRINT i = 0; i < Keys.Num(); ++i)
-	{
-		const TPair<FFrameNumber, FMovieSceneFloatValue>& CurrentKey = Keys[i];
-
-		while(static_cast<int32>(InCameraCuts[CurrentCameraCutIndex].GetUpperBoundValue() * FrameRatio) <= CurrentKey.Key)
-		{
-			CurrentCameraCutIndex += 1;
-			
-			TMovieSceneChannelData<FMovieSceneFloatValue> CurrentChannelData = Channels[CurrentCameraCutIndex % Channels.Num()]->GetData();
-			const TRange<uint32>& PreviousCameraCut = InCameraCuts[CurrentCameraCutIndex - 1];
-
-			const TPair<FFrameNumber, FMovieSceneFloatValue>& PreviousKey = 0 <= i - 1
-				? Keys[i - 1]
-				: Keys[0];
-
-			const FFrameNumber CurrentCameraCutStartFrameNumber = static_cast<int32>(PreviousCameraCut.GetUpperBoundValue() * FrameRatio);
-
-			if (CurrentCameraCutIndex != InCameraCuts.Num())
-			{
-				if (CurrentKey.Key != CurrentCameraCutStartFrameNumber)
-				{
-					CurrentChannelData.AddKey(CurrentCameraCutStartFrameNumber, PreviousKey.Value);
-				}
-			}
 
-			if(CurrentCameraCutIndex == InCameraCuts.Num())
-			{
-				break;
-			}
+		bool bSectionAdded = false;
+		UMovieSceneFloatSection* FloatSection = Cast<UMovieSceneFloatSection>(FloatTrack->FindOrAddSection(0, bSectionAdded));
+		if (!FloatSection)
+		{
+			return false;
 		}
 
-		if (CurrentCameraCutIndex == InCameraCuts.Num())
+		if (OutReimportStats == nullptr || bSectionAdded)
 		{
-			break;
+			FloatSection->Modify();
 		}
 
-		TMovieSceneChannelData<FMovieSceneFloatValue> ChannelData = Channels[CurrentCameraCutIndex % Channels.Num()]->GetData();
-		ChannelData.AddKey(CurrentKey.Key, CurrentKey.Value);
-	}
+		if (bSectionAdded)
+		{
+			FloatSection->SetRange(TRange<FFrameNumber>::All());
+		}
 
-	const TPair<FFrameNumber, FMovieSceneFloatValue>& LastKey = Keys.Last();
+		FMovieSceneFloatChannel* Channel = FloatSection->GetChannelProxy().GetChannel<FMovieSceneFloatChannel>(0);
+		Channels.Add(Channel);
+		Sections.Add(FloatSection);
+	}
 
-	for (PTRINT i = 0; i < Channels.Num() - 1; ++i)
+	if (OutReimportStats != nullptr)
 	{
-		CurrentCameraCutIndex += 1;
-		TMovieSceneChannelData<FMovieSceneFloatValue> ChannelData = Channels[CurrentCameraCutIndex % Channels.Num()]->GetData();
-		ChannelData.AddKey(LastKey.Key, LastKey.Value);
+		MergeComputedChannel(InComputedChannel, Channels, Sections, *OutReimportStats);
+	}
+	else
+	{
+		CommitComputedChannel(InComputedChannel, Channels);
 	}
 
 	return true;
 }
 
+void FVmdImporter::RemoveVmdCameraMotionBlurProperty(
+	const TArray<FGuid>& ObjectBindings,
+	const UMovieSceneSequence* InSequence,
+	FVmdReimportStats* OutReimportStats
+)
+{
+	UMovieScene* MovieScene = InSequence->GetMovieScene();
+
+	const FName TrackName = TEXT("PostProcessSettings.MotionBlurAmount");
+
+	for (FGuid ObjectBinding : ObjectBindings)
+	{
+		UMovieSceneFloatTrack* FloatTrack = MovieScene->FindTrack<UMovieSceneFloatTrack>(ObjectBinding, TrackName);
+		if (FloatTrack == nullptr)
+		{
+			continue;
+		}
+
+		MovieScene->Modify();
+		MovieScene->RemoveTrack(*FloatTrack);
+
+		if (OutReimportStats != nullptr)
+		{
+			OutReimportStats->ChangedChannels += 1;
+		}
+	}
+}
+
 bool FVmdImporter::ImportVmdCameraTransform(
-	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
-	const TArray<TRange<uint32>>& InCameraCuts,
+	const TVmdComputedChannel<FMovieSceneDoubleChannel>& InComputedDistance,
 	const TArray<FGuid>& ObjectBindings,
 	const UMovieSceneSequence* InSequence,
-	const UMmdUserImportVmdSettings* ImportVmdSettings
+	FVmdReimportStats* OutReimportStats
 )
 {
 	UMovieScene* MovieScene = InSequence->GetMovieScene();
 
 	TArray<FMovieSceneDoubleChannel*> Channels;
+	TArray<UMovieSceneSection*> Sections;
 	Channels.Reserve(ObjectBindings.Num());
+	Sections.Reserve(ObjectBindings.Num());
 
 	for (FGuid ObjectBinding : ObjectBindings)
 	{
@@ -803,7 +1347,10 @@ bool FVmdImporter::ImportVmdCameraTransform(
 			TransformTrack = MovieScene->AddTrack<UMovieScene3DTransformTrack>(ObjectBinding);
 		}
 
-		TransformTrack->Modify();
+		if (OutReimportStats == nullptr || TransformTrack->GetAllSections().Num() == 0)
+		{
+			TransformTrack->Modify();
+		}
 
 		bool bSectionAdded = false;
 		UMovieScene3DTransformSection* TransformSection = Cast<UMovieScene3DTransformSection>(TransformTrack->FindOrAddSection(0, bSectionAdded));
@@ -812,7 +1359,10 @@ bool FVmdImporter::ImportVmdCameraTransform(
 			return false;
 		}
 
-		TransformSection->Modify();
+		if (OutReimportStats == nullptr || bSectionAdded)
+		{
+			TransformSection->Modify();
+		}
 
 		if (bSectionAdded)
 		{
@@ -821,49 +1371,32 @@ bool FVmdImporter::ImportVmdCameraTransform(
 
 		FMovieSceneDoubleChannel* LocationXChannel = TransformSection->GetChannelProxy().GetChannel<FMovieSceneDoubleChannel>(0);
 		Channels.Add(LocationXChannel);
+		Sections.Add(TransformSection);
 	}
 
-	const FFrameRate SampleRate = MovieScene->GetDisplayRate();
-	const FFrameRate FrameRate = MovieScene->GetTickResolution();
-	const float UniformScale = ImportVmdSettings->ImportUniformScale;
-	FTangentAccessIndices TangentAccessIndices;
+	if (OutReimportStats != nullptr)
 	{
-		TangentAccessIndices.ArriveTangentX = 17;
-		TangentAccessIndices.ArriveTangentY = 19;
-		TangentAccessIndices.LeaveTangentX = 16;
-		TangentAccessIndices.LeaveTangentY = 18;
+		MergeComputedChannel(InComputedDistance, Channels, Sections, *OutReimportStats);
+	}
+	else
+	{
+		CommitComputedChannel(InComputedDistance, Channels);
 	}
-
-	ImportCameraSingleChannel(
-		CameraKeyFrames,
-		InCameraCuts,
-		Channels,
-		SampleRate,
-		FrameRate,
-		ImportVmdSettings->CameraCutImportType,
-		TangentAccessIndices,
-		[](const FVmdObject::FCameraKeyFrame& KeyFrames)
-		{
-			return KeyFrames.Distance;
-		},
-		[UniformScale](const double Value)
-		{
-			return Value * UniformScale;
-		});
 
 	return true;
 }
 
 bool FVmdImporter::ImportVmdCameraCenterTransform(
-	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
-	const TArray<TRange<uint32>>& InCameraCuts,
+	const FVmdComputedCamera& InComputedCamera,
 	const TArray<FGuid>& ObjectBindings,
 	const UMovieSceneSequence* InSequence,
-	const UMmdUserImportVmdSettings* ImportVmdSettings
+	FVmdReimportStats* OutReimportStats
 )
 {
 	UMovieScene* MovieScene = InSequence->GetMovieScene();
 
+	TArray<UMovieSceneSection*> Sections;
+	Sections.Reserve(ObjectBindings.Num());
 	TArray<FMovieSceneDoubleChannel*> LocationXChannels;
 	LocationXChannels.Reserve(ObjectBindings.Num());
 	TArray<FMovieSceneDoubleChannel*> LocationYChannels;
@@ -885,7 +1418,10 @@ bool FVmdImporter::ImportVmdCameraCenterTransform(
 			MovieScene->Modify();
 			TransformTrack = MovieScene->AddTrack<UMovieScene3DTransformTrack>(ObjectBinding);
 		}
-		TransformTrack->Modify();
+		if (OutReimportStats == nullptr || TransformTrack->GetAllSections().Num() == 0)
+		{
+			TransformTrack->Modify();
+		}
 
 		bool bSectionAdded = false;
 		UMovieScene3DTransformSection* TransformSection = Cast<UMovieScene3DTransformSection>(TransformTrack->FindOrAddSection(0, bSectionAdded));
@@ -894,7 +1430,10 @@ bool FVmdImporter::ImportVmdCameraCenterTransform(
 			return false;
 		}
 
-		TransformSection->Modify();
+		if (OutReimportStats == nullptr || bSectionAdded)
+		{
+			TransformSection->Modify();
+		}
 
 		if (bSectionAdded)
 		{
@@ -909,159 +1448,409 @@ bool FVmdImporter::ImportVmdCameraCenterTransform(
 		RotationXChannels.Add(Channels[3]);
 		RotationYChannels.Add(Channels[4]);
 		RotationZChannels.Add(Channels[5]);
+		Sections.Add(TransformSection);
+	}
+
+	if (OutReimportStats != nullptr)
+	{
+		MergeComputedChannel(InComputedCamera.LocationX, LocationXChannels, Sections, *OutReimportStats);
+		MergeComputedChannel(InComputedCamera.LocationY, LocationYChannels, Sections, *OutReimportStats);
+		MergeComputedChannel(InComputedCamera.LocationZ, LocationZChannels, Sections, *OutReimportStats);
+		MergeComputedChannel(InComputedCamera.RotationX, RotationXChannels, Sections, *OutReimportStats);
+		MergeComputedChannel(InComputedCamera.RotationY, RotationYChannels, Sections, *OutReimportStats);
+		MergeComputedChannel(InComputedCamera.RotationZ, RotationZChannels, Sections, *OutReimportStats);
+	}
+	else
+	{
+		CommitComputedChannel(InComputedCamera.LocationX, LocationXChannels);
+		CommitComputedChannel(InComputedCamera.LocationY, LocationYChannels);
+		CommitComputedChannel(InComputedCamera.LocationZ, LocationZChannels);
+		CommitComputedChannel(InComputedCamera.RotationX, RotationXChannels);
+		CommitComputedChannel(InComputedCamera.RotationY, RotationYChannels);
+		CommitComputedChannel(InComputedCamera.RotationZ, RotationZChannels);
 	}
 
-	const FFrameRate SampleRate = MovieScene->GetDisplayRate();
-	const FFrameRate FrameRate = MovieScene->GetTickResolution();
-	const float UniformScale = ImportVmdSettings->ImportUniformScale;
-	const ECameraCutImportType CameraCutImportType = ImportVmdSettings->CameraCutImportType;
+	return true;
+}
+
+FVmdComputedCamera FVmdImporter::ComputeVmdCamera(
+	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+	const FVmdCameraImportParams& Params
+)
+{
+	FVmdComputedCamera ComputedCamera;
 
+	if (CameraKeyFrames.Num() == 0)
 	{
-		FTangentAccessIndices LocationXTangentAccessIndices;
-		{
-			// mmd z axis tangent value indices
-			LocationXTangentAccessIndices.ArriveTangentX = 9;
-			LocationXTangentAccessIndices.ArriveTangentY = 11;
-			LocationXTangentAccessIndices.LeaveTangentX = 8;
-			LocationXTangentAccessIndices.LeaveTangentY = 10;
-		}
+		return ComputedCamera;
+	}
 
-		ImportCameraSingleChannel(
-			CameraKeyFrames,
-			InCameraCuts,
-			LocationXChannels,
-			SampleRate,
-			FrameRate,
-			CameraCutImportType,
-			LocationXTangentAccessIndices,
-			[](const FVmdObject::FCameraKeyFrame& KeyFrames)
-			{
-				return KeyFrames.Position[2];
-			},
-			[UniformScale](const double Value)
+	// scratch arrays of this thread are released together at the end of the import, worker tasks open their own marks
+	FMemMark ScratchMark(FMemStack::Get());
+
+	// structure of arrays copy of the keys, shared by cut detection and key reduction
+	TVmdScratchArray<float> ChannelValues;
+	ChannelValues.SetNumUninitialized(VmdCore::GCameraChannelCount * CameraKeyFrames.Num());
+	VmdCore::TransposeCameraKeyFrames(CameraKeyFrames.GetData(), CameraKeyFrames.Num(), ChannelValues.GetData());
+
+	TVmdScratchArray<int32> CutIndices;
+	DetectCameraCuts(CameraKeyFrames, ChannelValues.GetData(), Params, CutIndices);
+
+	ComputedCamera.CameraCuts = Params.CameraCount == 1
+		? TArray{ TRange<uint32>(0, CameraKeyFrames.Last().FrameNumber + 1) }
+		: ComputeCameraCutRanges(CameraKeyFrames, CutIndices);
+
+	const TArray<TRange<uint32>>& CameraCuts = ComputedCamera.CameraCuts;
+
+	if (Params.bAddMotionBlurKey)
+	{
+		ComputedCamera.MotionBlur = ComputeMotionBlurChannel(CameraKeyFrames, CutIndices, CameraCuts, Params);
+	}
+
+	if (Params.CurveImportType != ECurveImportType::WeightedTangent)
+	{
+		BakeVmdCamera(CameraKeyFrames, CutIndices, Params, ComputedCamera);
+		return ComputedCamera;
+	}
+
+	// one reduction pass for every channel
+	const int32 KeepMaskWordCount = VmdCore::GetKeepMaskWordCount(CameraKeyFrames.Num());
+	TVmdScratchArray<uint64> KeepMasks;
+	KeepMasks.SetNumUninitialized(VmdCore::GCameraChannelCount * KeepMaskWordCount);
+	VmdCore::ComputeCameraKeepMasks(ChannelValues.GetData(), CameraKeyFrames.Num(), KeepMasks.GetData());
+	const auto GetKeepMask = [&KeepMasks, KeepMaskWordCount](const VmdCore::ECameraChannel Channel)
+	{
+		return KeepMasks.GetData() + static_cast<int32>(Channel) * KeepMaskWordCount;
+	};
+
+	// keys on either side of a camera cut are pinned in the channels that step there, so no reduced segment spans a step
+	TVmdScratchArray<uint64> PinnedMasks;
+	PinnedMasks.SetNumUninitialized(VmdCore::GCameraChannelCount * KeepMaskWordCount);
+	for (int32 ChannelIndex = 0; ChannelIndex < VmdCore::GCameraChannelCount; ++ChannelIndex)
+	{
+		VmdCore::ComputeCameraCutKeyMask(
+			ChannelValues.GetData() + ChannelIndex * CameraKeyFrames.Num(),
+			CutIndices.GetData(),
+			CutIndices.Num(),
+			CameraKeyFrames.Num(),
+			PinnedMasks.GetData() + ChannelIndex * KeepMaskWordCount);
+	}
+
+	// bit i is set if key i starts a cut, the channels decide their steps from it instead of comparing values again
+	TVmdScratchArray<uint64> CutMask;
+	CutMask.SetNumZeroed(KeepMaskWordCount);
+	for (const int32 CutIndex : CutIndices)
+	{
+		VmdCore::SetKept(CutMask.GetData(), CutIndex);
+	}
+
+	FVmdKeyReductionStats& KeyReduction = ComputedCamera.KeyReduction;
+	const EParallelForFlags ParallelForFlags = Params.bParallelChannels ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
+	// the lossless keep masks already keep both keys of every step, only tolerance reduction needs the pins
+	if (Params.KeyReductionType == EKeyReductionType::Tolerance)
+	{
+		// every channel only writes its own keep mask and error
+		double ChannelErrors[VmdCore::GCameraChannelCount];
+		ParallelFor(VmdCore::GCameraChannelCount, [&](const int32 ChannelIndex)
+		{
+			FMemMark ChannelMark(FMemStack::Get());
+			TVmdScratchArray<double> ScratchValues;
+			const auto Reduce = [&](auto Descriptor, auto)
 			{
-				return Value * UniformScale;
-			});
+				using FDescriptor = decltype(Descriptor);
+				ChannelErrors[ChannelIndex] = ReduceKeysWithinTolerance<FDescriptor>(
+					CameraKeyFrames,
+					PinnedMasks.GetData() + static_cast<int32>(FDescriptor::Source) * KeepMaskWordCount,
+					Params,
+					ScratchValues,
+					GetKeepMask(FDescriptor::Source));
+			};
+
+			VisitCameraChannel(ChannelIndex, Reduce);
+		}, ParallelForFlags);
+
+		KeyReduction.MaxFocalLengthError = ChannelErrors[0];
+		KeyReduction.MaxPositionError = FMath::Max(FMath::Max(ChannelErrors[1], ChannelErrors[2]), FMath::Max(ChannelErrors[3], ChannelErrors[4]));
+		KeyReduction.MaxAngleError = FMath::Max3(ChannelErrors[5], ChannelErrors[6], ChannelErrors[7]);
+	}
+
+	KeyReduction.KeysBefore = VmdCore::GCameraChannelCount * CameraKeyFrames.Num();
+	KeyReduction.KeysAfter = VmdCore::CountKeptKeys(KeepMasks.GetData(), KeepMasks.Num() * 64);
+
+	if (Params.KeyReductionType == EKeyReductionType::Tolerance)
+	{
+		UE_LOG(
+			LogMMDCameraImporter,
+			Log,
+			TEXT("Key reduction: %d keys to %d, max error position %.4f cm, angle %.4f deg, focal length %.4f mm"),
+			KeyReduction.KeysBefore,
+			KeyReduction.KeysAfter,
+			KeyReduction.MaxPositionError,
+			KeyReduction.MaxAngleError,
+			KeyReduction.MaxFocalLengthError);
 	}
 
+	ParallelFor(VmdCore::GCameraChannelCount, [&](const int32 ChannelIndex)
+	{
+		FMemMark ChannelMark(FMemStack::Get());
+		VisitCameraChannel(ChannelIndex, [&](auto Descriptor, auto ComputedChannel)
+		{
+			using FDescriptor = decltype(Descriptor);
+			ComputedCamera.*ComputedChannel = ComputeCameraSingleChannel<FDescriptor>(
+				CameraKeyFrames,
+				GetKeepMask(FDescriptor::Source),
+				CutMask.GetData(),
+				CameraCuts,
+				Params);
+		});
+	}, ParallelForFlags);
+
+	return ComputedCamera;
+}
+
+void FVmdImporter::BakeVmdCamera(
+	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+	TConstArrayView<int32> CutIndices,
+	const FVmdCameraImportParams& Params,
+	FVmdComputedCamera& OutComputedCamera
+)
+{
+	// a single camera still steps at every cut, only the camera cut track ignores them
+	TArray<TRange<uint32>> SingleCameraCutRanges;
+	if (Params.CameraCount == 1)
+	{
+		SingleCameraCutRanges = ComputeCameraCutRanges(CameraKeyFrames, CutIndices);
+	}
+	const TArray<TRange<uint32>>& CutRanges = Params.CameraCount == 1
+		? SingleCameraCutRanges
+		: OutComputedCamera.CameraCuts;
+
+	const int32 FrameRatio = static_cast<int32>(Params.FrameRate.AsDecimal() / 30.f);
+	const double DisplayRate = Params.SampleRate.AsDecimal();
+	const uint32 LastFrameNumber = CameraKeyFrames.Last().FrameNumber;
+
+	// every range is sampled at its first and last frame and at the display frames in between
+	TVmdScratchArray<double> SampleFrames;
+	TVmdScratchArray<FFrameNumber> SampleTimes;
+	TVmdScratchArray<int32> RangeStarts;
 	{
-		FTangentAccessIndices LocationYTangentAccessIndices;
+		// display frames of the whole camera plus both ends of every range
+		const int32 SampleCountEstimate = FMath::CeilToInt((LastFrameNumber - CameraKeyFrames[0].FrameNumber) * DisplayRate / 30.0) + 2 * CutRanges.Num();
+		SampleFrames.Reserve(SampleCountEstimate);
+		SampleTimes.Reserve(SampleCountEstimate);
+		RangeStarts.Reserve(CutRanges.Num() + 1);
+
+		const auto AddSample = [&SampleFrames, &SampleTimes, &RangeStarts, FrameRatio](const double Frame)
+		{
+			const FFrameNumber Time = FMath::RoundToInt(Frame * FrameRatio);
+			if (RangeStarts.Last() < SampleTimes.Num() && Time <= SampleTimes.Last())
+			{
+				return;
+			}
+
+			SampleFrames.Add(Frame);
+			SampleTimes.Add(Time);
+		};
+
+		for (const TRange<uint32>& CutRange : CutRanges)
 		{
-			// mmd x axis tangent value indices
-			LocationYTangentAccessIndices.ArriveTangentX = 1;
-			LocationYTangentAccessIndices.ArriveTangentY = 3;
-			LocationYTangentAccessIndices.LeaveTangentX = 0;
-			LocationYTangentAccessIndices.LeaveTangentY = 2;
+			RangeStarts.Add(SampleFrames.Num());
+
+			const uint32 FirstFrame = CutRange.GetLowerBoundValue();
+			const uint32 LastFrame = FMath::Min(CutRange.GetUpperBoundValue() - 1, LastFrameNumber);
+
+			AddSample(FirstFrame);
+			for (int32 DisplayFrame = FMath::FloorToInt(FirstFrame * DisplayRate / 30.0) + 1; ; ++DisplayFrame)
+			{
+				const double Frame = DisplayFrame * 30.0 / DisplayRate;
+				if (LastFrame <= Frame)
+				{
+					break;
+				}
+				AddSample(Frame);
+			}
+			if (FirstFrame < LastFrame)
+			{
+				AddSample(LastFrame);
+			}
 		}
+		RangeStarts.Add(SampleFrames.Num());
+	}
 
-		ImportCameraSingleChannel(
-			CameraKeyFrames,
-			InCameraCuts,
-			LocationYChannels,
-			SampleRate,
-			FrameRate,
-			CameraCutImportType,
-			LocationYTangentAccessIndices,
-			[](const FVmdObject::FCameraKeyFrame& KeyFrames)
+	TVmdScratchArray<float> SampleValues;
+	{
+		TVmdScratchArray<float> ScratchValues;
+		TVmdScratchArray<int32> ScratchSegments;
+		ScratchValues.SetNumUninitialized(VmdCore::GetCameraCurveScratchSize(SampleFrames.Num()));
+		ScratchSegments.SetNumUninitialized(SampleFrames.Num());
+		SampleValues.SetNumUninitialized(VmdCore::GCameraChannelCount * SampleFrames.Num());
+
+		VmdCore::EvaluateCameraCurves(
+			CameraKeyFrames.GetData(),
+			CameraKeyFrames.Num(),
+			SampleFrames.Num(),
+			[&SampleFrames](const int32 Index)
 			{
-				return KeyFrames.Position[0];
+				return SampleFrames[Index];
 			},
-			[UniformScale](const double Value)
-			{
-				return Value * UniformScale;
-			});
+			ScratchValues.GetData(),
+			ScratchSegments.GetData(),
+			SampleValues.GetData());
 	}
 
+	ParallelFor(VmdCore::GCameraChannelCount, [&](const int32 ChannelIndex)
+	{
+		FMemMark ChannelMark(FMemStack::Get());
+		VisitCameraChannel(ChannelIndex, [&](auto Descriptor, auto ComputedChannel)
+		{
+			using FDescriptor = decltype(Descriptor);
+			OutComputedCamera.*ComputedChannel = BakeCameraSingleChannel<FDescriptor>(CameraKeyFrames, SampleValues, SampleTimes, RangeStarts, Params);
+		});
+	}, Params.bParallelChannels ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	OutComputedCamera.KeyReduction.KeysBefore = VmdCore::GCameraChannelCount * CameraKeyFrames.Num();
+	OutComputedCamera.KeyReduction.KeysAfter = VmdCore::GCameraChannelCount * SampleFrames.Num();
+}
+
+TVmdComputedChannel<FMovieSceneFloatChannel> FVmdImporter::ComputeMotionBlurChannel(
+	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+	TConstArrayView<int32> CutIndices,
+	const TArray<TRange<uint32>>& InCameraCuts,
+	const FVmdCameraImportParams& Params
+)
+{
+	const FFrameNumber OneSampleFrame = (Params.FrameRate / Params.SampleRate).AsFrameNumber(1);
+	const int32 FrameRatio = static_cast<int32>(Params.FrameRate.AsDecimal() / 30.f);
+	const float MotionBlurAmount = Params.MotionBlurAmount;
+	const ECameraCutImportType CameraCutImportType = Params.CameraCutImportType;
+	const int32 ChannelCount = Params.CameraCount;
+
+	TVmdComputedChannel<FMovieSceneFloatChannel> ComputedChannel;
+	ComputedChannel.DefaultValue = MotionBlurAmount;
+	ComputedChannel.CameraKeys.SetNum(ChannelCount);
+
+	// motion blur is off from the key before a run of consecutive cuts to the last cut of the run,
+	// a run that ends at the last key is left open
+	TVmdScratchArray<TRange<uint32>> CameraCutRanges;
+	CameraCutRanges.Reserve(CutIndices.Num());
+	for (int32 RunBegin = 0; RunBegin < CutIndices.Num();)
 	{
-		FTangentAccessIndices LocationZTangentAccessIndices;
+		int32 RunEnd = RunBegin;
+		while (RunEnd + 1 < CutIndices.Num() && CutIndices[RunEnd + 1] == CutIndices[RunEnd] + 1)
 		{
-			// mmd y axis tangent value indices
-			LocationZTangentAccessIndices.ArriveTangentX = 5;
-			LocationZTangentAccessIndices.ArriveTangentY = 7;
-			LocationZTangentAccessIndices.LeaveTangentX = 4;
-			LocationZTangentAccessIndices.LeaveTangentY = 6;
+			RunEnd += 1;
 		}
 
-		ImportCameraSingleChannel(
-			CameraKeyFrames,
-			InCameraCuts,
-			LocationZChannels,
-			SampleRate,
-			FrameRate,
-			CameraCutImportType,
-			LocationZTangentAccessIndices,
-			[](const FVmdObject::FCameraKeyFrame& KeyFrames)
-			{
-				return KeyFrames.Position[1];
-			},
-			[UniformScale](const double Value)
+		if (CutIndices[RunEnd] + 1 < CameraKeyFrames.Num())
+		{
+			const uint32 RangeStart = CameraKeyFrames[CutIndices[RunBegin] - 1].FrameNumber;
+			const uint32 RangeEnd = CameraKeyFrames[CutIndices[RunEnd]].FrameNumber;
+			if (RangeEnd != RangeStart)
 			{
-				return Value * UniformScale;
-			});
+				CameraCutRanges.Add(TRange<uint32>(RangeStart, RangeEnd));
+			}
+		}
+
+		RunBegin = RunEnd + 1;
+	}
+
+	TVmdScratchArray<TPair<FFrameNumber, FMovieSceneFloatValue>> Keys;
+	Keys.Reserve(2 * CameraCutRanges.Num() + 1);
+
+	if (0 < CameraCutRanges.Num() && CameraCutRanges[0].GetLowerBoundValue() != 0)
+	{
+		FMovieSceneFloatValue MovieSceneFloatValue;
+		MovieSceneFloatValue.Value = MotionBlurAmount;
+		MovieSceneFloatValue.InterpMode = RCIM_Constant;
+		Keys.Add({ 0, MovieSceneFloatValue });
 	}
 
+	for (TRange<uint32>& CameraCutRange : CameraCutRanges)
 	{
-		FTangentAccessIndices RotationTangentAccessIndices;
+		const uint32 LowerBound = CameraCutRange.GetLowerBoundValue();
+		const uint32 UpperBound = CameraCutRange.GetUpperBoundValue();
+
+
+		if (CameraCutImportType == ECameraCutImportType::ImportAsIs)
 		{
-			RotationTangentAccessIndices.ArriveTangentX = 13;
-			RotationTangentAccessIndices.ArriveTangentY = 15;
-			RotationTangentAccessIndices.LeaveTangentX = 12;
-			RotationTangentAccessIndices.LeaveTangentY = 14;
+			FMovieSceneFloatValue MovieSceneFloatValue;
+			MovieSceneFloatValue.Value = 0.0f;
+			MovieSceneFloatValue.InterpMode = RCIM_Constant;
+			Keys.Add({ static_cast<int32>(LowerBound) * FrameRatio, MovieSceneFloatValue });
+		}
+		else
+		{
+			FMovieSceneFloatValue MovieSceneFloatValue;
+			MovieSceneFloatValue.Value = 0.0f;
+			MovieSceneFloatValue.InterpMode = RCIM_Constant;
+			Keys.Add({ (static_cast<int32>(LowerBound + 1) * FrameRatio) - OneSampleFrame, MovieSceneFloatValue });
 		}
 
-		ImportCameraSingleChannel(
-			CameraKeyFrames,
-			InCameraCuts,
-			RotationXChannels,
-			SampleRate,
-			FrameRate,
-			CameraCutImportType,
-			RotationTangentAccessIndices,
-			[](const FVmdObject::FCameraKeyFrame& KeyFrames)
-			{
-				return KeyFrames.Rotation[2];
-			},
-			[](const double Value)
-			{
-				return FMath::RadiansToDegrees(Value);
-			});
-
-		ImportCameraSingleChannel(
-			CameraKeyFrames,
-			InCameraCuts,
-			RotationYChannels,
-			SampleRate,
-			FrameRate,
-			CameraCutImportType,
-			RotationTangentAccessIndices,
-			[](const FVmdObject::FCameraKeyFrame& KeyFrames)
-			{
-				return KeyFrames.Rotation[0];
-			},
-			[](const double Value)
-			{
-				return FMath::RadiansToDegrees(Value);
-			});
-
-		ImportCameraSingleChannel(
-			CameraKeyFrames,
-			InCameraCuts,
-			RotationZChannels,
-			SampleRate,
-			FrameRate,
-			CameraCutImportType,
-			RotationTangentAccessIndices,
-			[](const FVmdObject::FCameraKeyFrame& KeyFrames)
+		{
+			FMovieSceneFloatValue MovieSceneFloatValue;
+			MovieSceneFloatValue.Value = MotionBlurAmount;
+			MovieSceneFloatValue.InterpMode = RCIM_Constant;
+			Keys.Add({ (static_cast<int32>(UpperBound) * FrameRatio) + OneSampleFrame, MovieSceneFloatValue });
+		}
+	}
+
+	if (Keys.Num() == 0)
+	{
+		return ComputedChannel;
+	}
+
+	TArray<TArray<TPair<FFrameNumber, FMovieSceneFloatValue>>>& ChannelKeys = ComputedChannel.CameraKeys;
+
+	PTRINT CurrentCameraCutIndex = 0;
+	for (PTRINT i = 0; i < Keys.Num(); ++i)
+	{
+		const TPair<FFrameNumber, FMovieSceneFloatValue>& CurrentKey = Keys[i];
+
+		while(static_cast<int32>(InCameraCuts[CurrentCameraCutIndex].GetUpperBoundValue() * FrameRatio) <= CurrentKey.Key)
+		{
+			CurrentCameraCutIndex += 1;
+			
+			TArray<TPair<FFrameNumber, FMovieSceneFloatValue>>& CurrentChannelKeys = ChannelKeys[CurrentCameraCutIndex % ChannelCount];
+			const TRange<uint32>& PreviousCameraCut = InCameraCuts[CurrentCameraCutIndex - 1];
+
+			const TPair<FFrameNumber, FMovieSceneFloatValue>& PreviousKey = 0 <= i - 1
+				? Keys[i - 1]
+				: Keys[0];
+
+			const FFrameNumber CurrentCameraCutStartFrameNumber = static_cast<int32>(PreviousCameraCut.GetUpperBoundValue() * FrameRatio);
+
+			if (CurrentCameraCutIndex != InCameraCuts.Num())
 			{
-				return KeyFrames.Rotation[1];
-			},
-			[](const double Value)
+				if (CurrentKey.Key != CurrentCameraCutStartFrameNumber)
+				{
+					CurrentChannelKeys.Add({ CurrentCameraCutStartFrameNumber, PreviousKey.Value });
+				}
+			}
+
+			if(CurrentCameraCutIndex == InCameraCuts.Num())
 			{
-				return -FMath::RadiansToDegrees(Value);
-			});
+				break;
+			}
+		}
+
+		if (CurrentCameraCutIndex == InCameraCuts.Num())
+		{
+			break;
+		}
+
+		ChannelKeys[CurrentCameraCutIndex % ChannelCount].Add({ CurrentKey.Key, CurrentKey.Value });
 	}
 
-	return true;
+	const TPair<FFrameNumber, FMovieSceneFloatValue>& LastKey = Keys.Last();
+
+	for (PTRINT i = 0; i < ChannelCount - 1; ++i)
+	{
+		CurrentCameraCutIndex += 1;
+		ChannelKeys[CurrentCameraCutIndex % ChannelCount].Add({ LastKey.Key, LastKey.Value });
+	}
+
+	return ComputedChannel;
 }
 
 float FVmdImporter::ComputeFocalLength(const float FieldOfView, const float SensorWidth)
@@ -1070,37 +1859,42 @@ float FVmdImporter::ComputeFocalLength(const float FieldOfView, const float Sens
 	return (SensorWidth / 2.f) / FMath::Tan(FMath::DegreesToRadians(FieldOfView / 2.f));
 }
 
-TArray<TRange<uint32>> FVmdImporter::ComputeCameraCuts(const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames)
+void FVmdImporter::DetectCameraCuts(
+	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+	const float* ChannelValues,
+	const FVmdCameraImportParams& Params,
+	TVmdScratchArray<int32>& OutCutIndices
+)
+{
+	OutCutIndices.Reset();
+	VmdCore::DetectCameraCuts(
+		CameraKeyFrames.GetData(),
+		ChannelValues,
+		CameraKeyFrames.Num(),
+		Params.GetCameraCutThresholds(),
+		[&OutCutIndices](const int32 Index)
+		{
+			OutCutIndices.Add(Index);
+		});
+}
+
+TArray<TRange<uint32>> FVmdImporter::ComputeCameraCutRanges(
+	const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+	TConstArrayView<int32> CutIndices
+)
 {
 	TArray<TRange<uint32>> CameraCuts;
-
-	uint32 RangeStart = CameraKeyFrames[0].FrameNumber;
-
-	for (PTRINT i = 1; i < CameraKeyFrames.Num(); ++i)
-	{
-		// ReSharper disable once CppUseStructuredBinding
-		const FVmdObject::FCameraKeyFrame& PreviousFrame = CameraKeyFrames[i - 1];
-		// ReSharper disable once CppUseStructuredBinding
-		const FVmdObject::FCameraKeyFrame& CurrentFrame = CameraKeyFrames[i];
-
-		if (
-			(CurrentFrame.FrameNumber - PreviousFrame.FrameNumber) <= 1 &&
-
-			(CurrentFrame.ViewAngle != PreviousFrame.ViewAngle ||
-				CurrentFrame.Distance != PreviousFrame.Distance ||
-				CurrentFrame.Position[0] != PreviousFrame.Position[0] ||
-				CurrentFrame.Position[1] != PreviousFrame.Position[1] ||
-				CurrentFrame.Position[2] != PreviousFrame.Position[2] ||
-				CurrentFrame.Rotation[0] != PreviousFrame.Rotation[0] ||
-				CurrentFrame.Rotation[1] != PreviousFrame.Rotation[1] ||
-				CurrentFrame.Rotation[2] != PreviousFrame.Rotation[2]))
+	CameraCuts.Reserve(CutIndices.Num() + 1);
+
+	VmdCore::ComputeCameraCutRanges(
+		CameraKeyFrames.GetData(),
+		CameraKeyFrames.Num(),
+		CutIndices.GetData(),
+		CutIndices.Num(),
+		[&CameraCuts](const uint32 LowerBound, const uint32 UpperBound)
 		{
-			CameraCuts.Push(TRange<uint32>(RangeStart, CurrentFrame.FrameNumber));
-			RangeStart = CurrentFrame.FrameNumber;
-		}
-	}
-
-	CameraCuts.Push(TRange<uint32>(RangeStart, CameraKeyFrames.Last().FrameNumber + 1));
+			CameraCuts.Add(TRange<uint32>(LowerBound, UpperBound));
+		});
 
 	return CameraCuts;
 }
@@ -0,0 +1,208 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VMDImportCache.h"
+#include "VMDImporter.h"
+#include "VMDSyntheticWriter.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Camera key frames of a synthetic file, half of them with eased curves so the solver is not skipped */
+	bool MakeTestCameraKeyFrames(TArray<FVmdObject::FCameraKeyFrame>& OutCameraKeyFrames)
+	{
+		FVmdSyntheticSettings Settings;
+		Settings.CameraKeyFrameCount = 2000;
+
+		const FString VmdPath = FPaths::ProjectIntermediateDir() / TEXT("MMDCameraImporter") / TEXT("AutomationTest.vmd");
+		if (!FVmdSyntheticWriter::WriteToFile(Settings, VmdPath))
+		{
+			return false;
+		}
+
+		FVmdImporter VmdImporter;
+		VmdImporter.SetFilePath(VmdPath);
+		if (!VmdImporter.IsValidVmdFile())
+		{
+			return false;
+		}
+		OutCameraKeyFrames = VmdImporter.ParseVmdFile(EVmdSections::Camera).CameraKeyFrames;
+
+		FRandomStream Random(static_cast<int32>(Settings.Seed));
+		for (int32 i = 0; i < OutCameraKeyFrames.Num(); i += 2)
+		{
+			for (int8& Value : OutCameraKeyFrames[i].Interpolation)
+			{
+				Value = static_cast<int8>(Random.RandRange(0, 127));
+			}
+		}
+
+		return OutCameraKeyFrames.Num() != 0;
+	}
+
+	FVmdCameraImportParams MakeTestImportParams()
+	{
+		FVmdCameraImportParams Params;
+		Params.SampleRate = FFrameRate(30, 1);
+		Params.FrameRate = FFrameRate(24000, 1);
+		Params.ImportUniformScale = 10.0f;
+		Params.CameraCutImportType = ECameraCutImportType::OneFrameInterval;
+		Params.CameraCount = 2;
+		Params.CurveImportType = ECurveImportType::WeightedTangent;
+		Params.bAddMotionBlurKey = true;
+		Params.MotionBlurAmount = 0.5f;
+		Params.SensorWidth = 24.0f;
+		Params.SensorHeight = 13.5f;
+		Params.KeyReductionType = EKeyReductionType::Lossless;
+		Params.PositionTolerance = 0.1f;
+		Params.AngleTolerance = 0.1f;
+		Params.FocalLengthTolerance = 0.1f;
+		Params.CameraCutPositionTolerance = 0.0f;
+		Params.CameraCutAngleTolerance = 0.0f;
+		Params.CameraCutViewAngleTolerance = 0.0f;
+		Params.CameraCutMaxFrameGap = 1;
+		Params.bParallelChannels = true;
+		Params.bReimportExisting = false;
+		Params.bUseImportCache = false;
+		return Params;
+	}
+
+	template<typename MovieSceneChannel>
+	bool IsIdenticalChannel(const TVmdComputedChannel<MovieSceneChannel>& A, const TVmdComputedChannel<MovieSceneChannel>& B)
+	{
+		if (FMemory::Memcmp(&A.DefaultValue, &B.DefaultValue, sizeof(A.DefaultValue)) != 0 ||
+			A.bAutoSetTangents != B.bAutoSetTangents ||
+			A.CameraKeys.Num() != B.CameraKeys.Num())
+		{
+			return false;
+		}
+
+		for (int32 CameraIndex = 0; CameraIndex < A.CameraKeys.Num(); ++CameraIndex)
+		{
+			const auto& KeysA = A.CameraKeys[CameraIndex];
+			const auto& KeysB = B.CameraKeys[CameraIndex];
+			if (KeysA.Num() != KeysB.Num())
+			{
+				return false;
+			}
+
+			for (int32 i = 0; i < KeysA.Num(); ++i)
+			{
+				// the values are compared bitwise as well, operator== treats 0 and -0 as equal
+				if (KeysA[i].Key != KeysB[i].Key ||
+					!(KeysA[i].Value == KeysB[i].Value) ||
+					FMemory::Memcmp(&KeysA[i].Value.Value, &KeysB[i].Value.Value, sizeof(KeysA[i].Value.Value)) != 0)
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool IsIdenticalCamera(const FVmdComputedCamera& A, const FVmdComputedCamera& B)
+	{
+		return A.CameraCuts == B.CameraCuts &&
+			A.KeyReduction.KeysAfter == B.KeyReduction.KeysAfter &&
+			IsIdenticalChannel(A.FocalLength, B.FocalLength) &&
+			IsIdenticalChannel(A.MotionBlur, B.MotionBlur) &&
+			IsIdenticalChannel(A.Distance, B.Distance) &&
+			IsIdenticalChannel(A.LocationX, B.LocationX) &&
+			IsIdenticalChannel(A.LocationY, B.LocationY) &&
+			IsIdenticalChannel(A.LocationZ, B.LocationZ) &&
+			IsIdenticalChannel(A.RotationX, B.RotationX) &&
+			IsIdenticalChannel(A.RotationY, B.RotationY) &&
+			IsIdenticalChannel(A.RotationZ, B.RotationZ);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVmdParallelChannelsTest,
+	"MMDCameraImporter.ComputeVmdCamera.ParallelMatchesSerial",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVmdParallelChannelsTest::RunTest(const FString& Parameters)
+{
+	TArray<FVmdObject::FCameraKeyFrame> CameraKeyFrames;
+	if (!MakeTestCameraKeyFrames(CameraKeyFrames))
+	{
+		AddError(TEXT("Can't create the test camera"));
+		return false;
+	}
+
+	// the parallel channel computation has to match the serial one bit for bit in every mode
+	for (const EKeyReductionType KeyReductionType : { EKeyReductionType::Lossless, EKeyReductionType::Tolerance })
+	{
+		for (const ECurveImportType CurveImportType : { ECurveImportType::WeightedTangent, ECurveImportType::BakeLinear, ECurveImportType::BakeAuto })
+		{
+			FVmdCameraImportParams Params = MakeTestImportParams();
+			Params.KeyReductionType = KeyReductionType;
+			Params.CurveImportType = CurveImportType;
+
+			Params.bParallelChannels = false;
+			const FVmdComputedCamera SerialCamera = FVmdImporter::ComputeVmdCamera(CameraKeyFrames, Params);
+
+			Params.bParallelChannels = true;
+			const FVmdComputedCamera ParallelCamera = FVmdImporter::ComputeVmdCamera(CameraKeyFrames, Params);
+
+			TestTrue(
+				FString::Printf(
+					TEXT("Parallel channel computation matches the serial one(KeyReductionType %d, CurveImportType %d)"),
+					static_cast<int32>(KeyReductionType),
+					static_cast<int32>(CurveImportType)),
+				IsIdenticalCamera(SerialCamera, ParallelCamera));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FVmdImportCacheRoundTripTest,
+	"MMDCameraImporter.ImportCache.RoundTrip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVmdImportCacheRoundTripTest::RunTest(const FString& Parameters)
+{
+	TArray<FVmdObject::FCameraKeyFrame> CameraKeyFrames;
+	if (!MakeTestCameraKeyFrames(CameraKeyFrames))
+	{
+		AddError(TEXT("Can't create the test camera"));
+		return false;
+	}
+
+	FVmdCameraImportParams Params = MakeTestImportParams();
+	Params.CameraCount = 4;
+	FVmdComputedCamera ComputedCamera = FVmdImporter::ComputeVmdCamera(CameraKeyFrames, Params);
+
+	TArray<uint8> CacheBytes;
+	{
+		FMemoryWriter Writer(CacheBytes);
+		FVmdImportCache::Serialize(Writer, ComputedCamera);
+	}
+
+	FVmdComputedCamera CachedCamera;
+	{
+		FMemoryReader Reader(CacheBytes);
+		FVmdImportCache::Serialize(Reader, CachedCamera);
+		TestFalse(TEXT("Import cache entry reads without error"), Reader.IsError());
+	}
+
+	TestTrue(TEXT("Import cache round trip matches the computed camera"), IsIdenticalCamera(ComputedCamera, CachedCamera));
+
+	// every setting that changes the keys has to change the cache key
+	FVmdCameraImportParams KeyParams = Params;
+	KeyParams.CameraCount = 2;
+	TestNotEqual(
+		TEXT("Import cache key depends on the import settings"),
+		FVmdImportCache::MakeKey(CameraKeyFrames, Params),
+		FVmdImportCache::MakeKey(CameraKeyFrames, KeyParams));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,151 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VMDMappedFile.h"
+
+#include "MMDCameraImporter.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+
+namespace
+{
+	template<typename T>
+	TConstArrayView<T> MakeSectionView(const uint8* Data, const FVmdSectionDirectory::FSection& Section)
+	{
+		if (!Section.bIsPresent || Section.Count == 0)
+		{
+			return TConstArrayView<T>();
+		}
+
+		return TConstArrayView<T>(reinterpret_cast<const T*>(Data + Section.Offset), static_cast<int32>(Section.Count));
+	}
+}
+
+FVmdMappedFile::FVmdMappedFile(TUniquePtr<IMappedFileHandle>&& InHandle, TUniquePtr<IMappedFileRegion>&& InRegion)
+	: Handle(MoveTemp(InHandle))
+	, Region(MoveTemp(InRegion))
+{
+}
+
+FVmdMappedFile::~FVmdMappedFile()
+{
+	// region must be unmapped before the handle is closed
+	Region.Reset();
+	Handle.Reset();
+}
+
+TSharedPtr<FVmdMappedFile> FVmdMappedFile::Open(const FString& FilePath, EVmdMapResult& OutResult)
+{
+	OutResult = EVmdMapResult::MapFailed;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	TUniquePtr<IMappedFileHandle> Handle(PlatformFile.OpenMapped(*FilePath));
+	if (!Handle.IsValid())
+	{
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("Can't map file(%s)"), *FilePath);
+		return nullptr;
+	}
+
+	if (Handle->GetFileSize() < static_cast<int64>(sizeof(FVmdObject::FHeader)))
+	{
+		UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(FileSize < sizeof(FVmdObject::FHeader))"));
+		OutResult = EVmdMapResult::InvalidFile;
+		return nullptr;
+	}
+
+	// views are int32 sized, the section counts are bounded the same way in LocateSections
+	if (MAX_int32 < Handle->GetFileSize())
+	{
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("File is too large to map(%s)"), *FilePath);
+		return nullptr;
+	}
+
+	TUniquePtr<IMappedFileRegion> Region(Handle->MapRegion(0, Handle->GetFileSize()));
+	if (!Region.IsValid())
+	{
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("Can't map file region(%s)"), *FilePath);
+		return nullptr;
+	}
+
+	TSharedPtr<FVmdMappedFile> MappedFile = MakeShareable(new FVmdMappedFile(MoveTemp(Handle), MoveTemp(Region)));
+	if (!MappedFile->LocateSections())
+	{
+		OutResult = EVmdMapResult::InvalidFile;
+		return nullptr;
+	}
+
+	OutResult = EVmdMapResult::Success;
+	return MappedFile;
+}
+
+int64 FVmdMappedFile::GetFileSize() const
+{
+	return Region->GetMappedSize();
+}
+
+const FVmdObject::FHeader& FVmdMappedFile::GetHeader() const
+{
+	return *reinterpret_cast<const FVmdObject::FHeader*>(Region->GetMappedPtr());
+}
+
+TConstArrayView<uint8> FVmdMappedFile::GetBytes() const
+{
+	// Open rejects files larger than MAX_int32
+	return TConstArrayView<uint8>(Region->GetMappedPtr(), static_cast<int32>(Region->GetMappedSize()));
+}
+
+bool FVmdMappedFile::LocateSections()
+{
+	const uint8* Data = Region->GetMappedPtr();
+	const int64 FileSize = Region->GetMappedSize();
+
+	const bool bIsValid = FVmdSectionDirectory::Scan(
+		FileSize,
+		[Data, FileSize](const int64 Offset, void* Dest, const int64 Size)
+		{
+			if (Offset < 0 || FileSize < Offset + Size)
+			{
+				return false;
+			}
+
+			FMemory::Memcpy(Dest, Data + Offset, Size);
+			return true;
+		},
+		SectionDirectory);
+
+	if (!bIsValid)
+	{
+		return false;
+	}
+
+	// counts beyond int32 can't be viewed, Scan already guarantees that every section fits in the file
+	for (const FVmdSectionDirectory::FSection* Section : {
+		&SectionDirectory.BoneKeyFrames,
+		&SectionDirectory.MorphKeyFrames,
+		&SectionDirectory.CameraKeyFrames,
+		&SectionDirectory.LightKeyFrames,
+		&SectionDirectory.SelfShadowKeyFrames })
+	{
+		if (MAX_int32 < Section->Count)
+		{
+			UE_LOG(LogMMDCameraImporter, Error, TEXT("File seems to be corrupt(Too many keyframes)"));
+			return false;
+		}
+	}
+
+	BoneKeyFrames = MakeSectionView<FVmdObject::FBoneKeyFrame>(Data, SectionDirectory.BoneKeyFrames);
+	MorphKeyFrames = MakeSectionView<FVmdObject::FMorphKeyFrame>(Data, SectionDirectory.MorphKeyFrames);
+	CameraKeyFrames = MakeSectionView<FVmdObject::FCameraKeyFrame>(Data, SectionDirectory.CameraKeyFrames);
+	LightKeyFrames = MakeSectionView<FVmdObject::FLightKeyFrame>(Data, SectionDirectory.LightKeyFrames);
+	SelfShadowKeyFrames = MakeSectionView<FVmdObject::FSelfShadowKeyFrame>(Data, SectionDirectory.SelfShadowKeyFrames);
+
+	// the property section lies within the file, which Open limits to MAX_int32 bytes
+	if (SectionDirectory.PropertyKeyFrames.bIsPresent)
+	{
+		PropertySection = TConstArrayView<uint8>(
+			Data + SectionDirectory.PropertyKeyFrames.Offset,
+			static_cast<int32>(SectionDirectory.EndOffset - SectionDirectory.PropertyKeyFrames.Offset));
+	}
+
+	return true;
+}
@@ -0,0 +1,52 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VMDNameTable.h"
+
+#include "MMDCameraImporter.h"
+#include "MMDImportHelper.h"
+#include "Hash/CityHash.h"
+#include "VmdCore/VmdShiftJis.h"
+
+uint16 FVmdNameTable::Intern(const uint8* InField, const int32 InFieldSize)
+{
+	check(InFieldSize <= MaxFieldSize);
+
+	FKey Key;
+	Key.Length = VmdCore::GetFixedStringLength(InField, InFieldSize);
+	FMemory::Memzero(Key.Bytes);
+	FMemory::Memcpy(Key.Bytes, InField, Key.Length);
+	Key.Hash = CityHash32(reinterpret_cast<const char*>(Key.Bytes), Key.Length);
+
+	if (const uint16* Id = Ids.Find(Key))
+	{
+		return *Id;
+	}
+
+	if (Names.Num() == InvalidId)
+	{
+		if (!bWarnedFull)
+		{
+			UE_LOG(LogMMDCameraImporter, Warning, TEXT("Too many distinct names, name ids are limited to %d"), static_cast<int32>(InvalidId));
+			bWarnedFull = true;
+		}
+		return InvalidId;
+	}
+
+	const uint16 NewId = static_cast<uint16>(Names.Num());
+	Names.Add(FName(*FMmdImportHelper::ShiftJisToFString(Key.Bytes, Key.Length)));
+	Ids.Add(Key, NewId);
+
+	return NewId;
+}
+
+void FVmdNameTable::Reset()
+{
+	Ids.Reset();
+	Names.Reset();
+	bWarnedFull = false;
+}
+
+SIZE_T FVmdNameTable::GetAllocatedSize() const
+{
+	return Ids.GetAllocatedSize() + Names.GetAllocatedSize();
+}
@@ -0,0 +1,143 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VMDSniffer.h"
+
+#include "MMDCameraImporter.h"
+#include "MMDImportHelper.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "VmdCore/VmdShiftJis.h"
+
+FVmdSniffResult FVmdSniffer::Sniff(const FString& FilePath)
+{
+	FVmdSniffResult Result;
+	Result.FilePath = FilePath;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	const TUniquePtr<IFileHandle> Handle(PlatformFile.OpenRead(*FilePath));
+	if (!Handle.IsValid())
+	{
+		UE_LOG(LogMMDCameraImporter, Warning, TEXT("Can't open file(%s)"), *FilePath);
+		return Result;
+	}
+
+	Result.FileSize = Handle->Size();
+
+	// one read for the prefix, section counts past it are read on demand
+	uint8 Prefix[PrefixSize];
+	const int64 ReadPrefixSize = FMath::Min(Result.FileSize, PrefixSize);
+	if (!Handle->Read(Prefix, ReadPrefixSize))
+	{
+		return Result;
+	}
+
+	const VmdCore::FSniffResult SniffResult = VmdCore::SniffFile(
+		Result.FileSize,
+		[&Handle, &Prefix, ReadPrefixSize](const int64 Offset, void* Dest, const int64 Size)
+		{
+			if (Offset + Size <= ReadPrefixSize)
+			{
+				FMemory::Memcpy(Dest, Prefix + Offset, Size);
+				return true;
+			}
+
+			return Handle->Seek(Offset) && Handle->Read(static_cast<uint8*>(Dest), Size);
+		});
+
+	Result.Version = SniffResult.Version;
+	Result.ModelName = FMmdImportHelper::ShiftJisToFString(
+		SniffResult.ModelName,
+		VmdCore::GetFixedStringLength(SniffResult.ModelName, SniffResult.ModelNameSize));
+	Result.bHasCameraSection = SniffResult.bHasCameraSection;
+	Result.CameraKeyFrameCount = SniffResult.CameraKeyFrameCount;
+
+	return Result;
+}
+
+TArray<FVmdSniffResult> FVmdSniffer::ScanDirectory(const FString& Directory, const bool bRecursive)
+{
+	TArray<FString> FilePaths;
+	if (bRecursive)
+	{
+		IFileManager::Get().FindFilesRecursive(FilePaths, *Directory, TEXT("*.vmd"), true, false);
+	}
+	else
+	{
+		IFileManager::Get().FindFiles(FilePaths, *(Directory / TEXT("*.vmd")), true, false);
+		for (FString& FilePath : FilePaths)
+		{
+			FilePath = Directory / FilePath;
+		}
+	}
+	FilePaths.Sort();
+
+	TArray<FVmdSniffResult> Results;
+	Results.SetNum(FilePaths.Num());
+
+	// each file is a handful of small reads, so this is bound by file open latency rather than bandwidth
+	ParallelFor(FilePaths.Num(), [&FilePaths, &Results](const int32 Index)
+	{
+		Results[Index] = Sniff(FilePaths[Index]);
+	});
+
+	return Results;
+}
+
+namespace
+{
+	/**
+	 * MMD.ScanVmdLibrary <Directory>
+	 */
+	void RunScanVmdLibrary(const TArray<FString>& Args)
+	{
+		if (Args.Num() == 0)
+		{
+			UE_LOG(LogMMDCameraImporter, Error, TEXT("Usage: MMD.ScanVmdLibrary <Directory>"));
+			return;
+		}
+
+		const FString Directory = FString::Join(Args, TEXT(" "));
+
+		const double StartTime = FPlatformTime::Seconds();
+		const TArray<FVmdSniffResult> Results = FVmdSniffer::ScanDirectory(Directory);
+		const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+
+		int32 V1Count = 0;
+		int32 V2Count = 0;
+		int32 CameraCount = 0;
+		for (const FVmdSniffResult& Result : Results)
+		{
+			V1Count += Result.Version == EVmdFormatVersion::V1 ? 1 : 0;
+			V2Count += Result.Version == EVmdFormatVersion::V2 ? 1 : 0;
+			CameraCount += Result.IsCameraMotion() ? 1 : 0;
+
+			UE_LOG(
+				LogMMDCameraImporter,
+				Log,
+				TEXT("%s: %s, model \"%s\", %u camera keys"),
+				*Result.FilePath,
+				Result.Version == EVmdFormatVersion::V2 ? TEXT("v2") : Result.Version == EVmdFormatVersion::V1 ? TEXT("v1") : TEXT("unknown"),
+				*Result.ModelName,
+				Result.CameraKeyFrameCount);
+		}
+
+		UE_LOG(
+			LogMMDCameraImporter,
+			Display,
+			TEXT("Scanned %d files in %.2f ms: %d v2, %d v1, %d unknown, %d camera motions"),
+			Results.Num(),
+			ElapsedSeconds * 1000.0,
+			V2Count,
+			V1Count,
+			Results.Num() - V1Count - V2Count,
+			CameraCount);
+	}
+
+	FAutoConsoleCommand ScanVmdLibraryCommand(
+		TEXT("MMD.ScanVmdLibrary"),
+		TEXT("Classify every VMD file under a directory from its header, without parsing"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunScanVmdLibrary));
+}
@@ -0,0 +1,212 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VMDSyntheticWriter.h"
+
+#include "VMDImporter.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	template<typename T>
+	void AppendRecord(TArray<uint8>& Bytes, const T& Record)
+	{
+		Bytes.Append(reinterpret_cast<const uint8*>(&Record), sizeof(T));
+	}
+
+	void AppendCount(TArray<uint8>& Bytes, const int32 Count)
+	{
+		AppendRecord(Bytes, static_cast<uint32>(Count));
+	}
+
+	template<int32 Size>
+	void WriteName(uint8 (&OutName)[Size], const TCHAR* Prefix, const int32 Index)
+	{
+		FMemory::Memzero(OutName, Size);
+
+		const FString Name = FString::Printf(TEXT("%s%d"), Prefix, Index);
+		for (int32 i = 0; i < Name.Len() && i < Size - 1; ++i)
+		{
+			OutName[i] = static_cast<uint8>(Name[i]);
+		}
+	}
+
+	// linear curve for every interpolation slot, (x1, x2, y1, y2) per channel
+	template<int32 Size>
+	void WriteLinearInterpolation(int8 (&OutInterpolation)[Size])
+	{
+		for (int32 i = 0; i < Size; i += 4)
+		{
+			OutInterpolation[i + 0] = 20;
+			OutInterpolation[i + 1] = 107;
+			OutInterpolation[i + 2] = 20;
+			OutInterpolation[i + 3] = 107;
+		}
+	}
+
+	template<typename T>
+	void AppendKeyFrames(TArray<uint8>& Bytes, TArray<T>& KeyFrames, const bool bShuffle, FRandomStream& Random)
+	{
+		if (bShuffle)
+		{
+			for (int32 i = KeyFrames.Num() - 1; 0 < i; --i)
+			{
+				KeyFrames.Swap(i, Random.RandRange(0, i));
+			}
+		}
+
+		AppendCount(Bytes, KeyFrames.Num());
+		Bytes.Append(reinterpret_cast<const uint8*>(KeyFrames.GetData()), KeyFrames.Num() * sizeof(T));
+	}
+}
+
+TArray<uint8> FVmdSyntheticWriter::Write(const FVmdSyntheticSettings& Settings)
+{
+	FRandomStream Random(static_cast<int32>(Settings.Seed));
+
+	TArray<uint8> Bytes;
+	Bytes.Reserve(
+		sizeof(FVmdObject::FHeader) + 7 * sizeof(uint32) +
+		Settings.BoneKeyFrameCount * sizeof(FVmdObject::FBoneKeyFrame) +
+		Settings.MorphKeyFrameCount * sizeof(FVmdObject::FMorphKeyFrame) +
+		Settings.CameraKeyFrameCount * sizeof(FVmdObject::FCameraKeyFrame) +
+		Settings.LightKeyFrameCount * sizeof(FVmdObject::FLightKeyFrame) +
+		Settings.SelfShadowKeyFrameCount * sizeof(FVmdObject::FSelfShadowKeyFrame) +
+		Settings.PropertyKeyFrameCount * (sizeof(FVmdObject::FPropertyKeyFrame) + sizeof(uint32) +
+			Settings.IkStatesPerPropertyKeyFrame * sizeof(FVmdObject::FPropertyKeyFrame::FIkState)));
+
+	{
+		FVmdObject::FHeader Header;
+		FMemory::Memzero(Header);
+		FMemory::Memcpy(Header.Magic, "Vocaloid Motion Data 0002", 25);
+		FMemory::Memcpy(Header.ModelName, "Synthetic", 9);
+		AppendRecord(Bytes, Header);
+	}
+
+	{
+		TArray<FVmdObject::FBoneKeyFrame> BoneKeyFrames;
+		BoneKeyFrames.SetNumZeroed(Settings.BoneKeyFrameCount);
+		for (int32 i = 0; i < BoneKeyFrames.Num(); ++i)
+		{
+			FVmdObject::FBoneKeyFrame& KeyFrame = BoneKeyFrames[i];
+			WriteName(KeyFrame.BoneName, TEXT("Bone"), i % FMath::Max(1, Settings.BoneNameCount));
+			KeyFrame.FrameNumber = i / FMath::Max(1, Settings.BoneNameCount);
+			KeyFrame.Position[0] = Random.FRandRange(-1.0f, 1.0f);
+			KeyFrame.Position[1] = Random.FRandRange(-1.0f, 1.0f);
+			KeyFrame.Position[2] = Random.FRandRange(-1.0f, 1.0f);
+			KeyFrame.Rotation[3] = 1.0f;
+			WriteLinearInterpolation(KeyFrame.Interpolation);
+		}
+		AppendKeyFrames(Bytes, BoneKeyFrames, Settings.bShuffleKeyFrames, Random);
+	}
+
+	{
+		TArray<FVmdObject::FMorphKeyFrame> MorphKeyFrames;
+		MorphKeyFrames.SetNumZeroed(Settings.MorphKeyFrameCount);
+		for (int32 i = 0; i < MorphKeyFrames.Num(); ++i)
+		{
+			FVmdObject::FMorphKeyFrame& KeyFrame = MorphKeyFrames[i];
+			WriteName(KeyFrame.MorphName, TEXT("Morph"), i % FMath::Max(1, Settings.MorphNameCount));
+			KeyFrame.FrameNumber = i / FMath::Max(1, Settings.MorphNameCount);
+			KeyFrame.Weight = Random.FRand();
+		}
+		AppendKeyFrames(Bytes, MorphKeyFrames, Settings.bShuffleKeyFrames, Random);
+	}
+
+	{
+		TArray<FVmdObject::FCameraKeyFrame> CameraKeyFrames;
+		CameraKeyFrames.SetNumZeroed(Settings.CameraKeyFrameCount);
+
+		uint32 FrameNumber = 0;
+		for (int32 i = 0; i < CameraKeyFrames.Num(); ++i)
+		{
+			FVmdObject::FCameraKeyFrame& KeyFrame = CameraKeyFrames[i];
+
+			// a cut is a key right after the previous one, otherwise keys are a few frames apart
+			const bool bIsCut = 0 < i && Random.FRand() < Settings.CameraCutDensity;
+			FrameNumber += i == 0 ? 0 : bIsCut ? 1 : static_cast<uint32>(Random.RandRange(2, 30));
+
+			KeyFrame.FrameNumber = FrameNumber;
+			KeyFrame.Distance = Random.FRandRange(-50.0f, -5.0f);
+			KeyFrame.Position[0] = Random.FRandRange(-20.0f, 20.0f);
+			KeyFrame.Position[1] = Random.FRandRange(0.0f, 20.0f);
+			KeyFrame.Position[2] = Random.FRandRange(-20.0f, 20.0f);
+			KeyFrame.Rotation[0] = Random.FRandRange(-PI, PI);
+			KeyFrame.Rotation[1] = Random.FRandRange(-PI, PI);
+			KeyFrame.Rotation[2] = Random.FRandRange(-PI, PI);
+			WriteLinearInterpolation(KeyFrame.Interpolation);
+			KeyFrame.ViewAngle = static_cast<uint32>(Random.RandRange(10, 60));
+			KeyFrame.Perspective = 0;
+		}
+		AppendKeyFrames(Bytes, CameraKeyFrames, Settings.bShuffleKeyFrames, Random);
+	}
+
+	{
+		TArray<FVmdObject::FLightKeyFrame> LightKeyFrames;
+		LightKeyFrames.SetNumZeroed(Settings.LightKeyFrameCount);
+		for (int32 i = 0; i < LightKeyFrames.Num(); ++i)
+		{
+			FVmdObject::FLightKeyFrame& KeyFrame = LightKeyFrames[i];
+			KeyFrame.FrameNumber = i;
+			KeyFrame.Color[0] = KeyFrame.Color[1] = KeyFrame.Color[2] = 0.6f;
+			KeyFrame.Direction[0] = -0.5f;
+			KeyFrame.Direction[1] = -1.0f;
+			KeyFrame.Direction[2] = 0.5f;
+		}
+		AppendKeyFrames(Bytes, LightKeyFrames, Settings.bShuffleKeyFrames, Random);
+	}
+
+	{
+		TArray<FVmdObject::FSelfShadowKeyFrame> SelfShadowKeyFrames;
+		SelfShadowKeyFrames.SetNumZeroed(Settings.SelfShadowKeyFrameCount);
+		for (int32 i = 0; i < SelfShadowKeyFrames.Num(); ++i)
+		{
+			FVmdObject::FSelfShadowKeyFrame& KeyFrame = SelfShadowKeyFrames[i];
+			KeyFrame.FrameNumber = i;
+			KeyFrame.Mode = 1;
+			KeyFrame.Distance = 0.1f;
+		}
+		AppendKeyFrames(Bytes, SelfShadowKeyFrames, Settings.bShuffleKeyFrames, Random);
+	}
+
+	{
+		// property key frames are variable length, written in place instead of through AppendKeyFrames
+		TArray<uint32> FrameNumbers;
+		FrameNumbers.SetNum(Settings.PropertyKeyFrameCount);
+		for (int32 i = 0; i < FrameNumbers.Num(); ++i)
+		{
+			FrameNumbers[i] = i;
+		}
+		if (Settings.bShuffleKeyFrames)
+		{
+			for (int32 i = FrameNumbers.Num() - 1; 0 < i; --i)
+			{
+				FrameNumbers.Swap(i, Random.RandRange(0, i));
+			}
+		}
+
+		AppendCount(Bytes, Settings.PropertyKeyFrameCount);
+		for (const uint32 FrameNumber : FrameNumbers)
+		{
+			FVmdObject::FPropertyKeyFrame KeyFrame;
+			KeyFrame.FrameNumber = FrameNumber;
+			KeyFrame.Visible = 1;
+			AppendRecord(Bytes, KeyFrame);
+
+			AppendCount(Bytes, Settings.IkStatesPerPropertyKeyFrame);
+			for (int32 i = 0; i < Settings.IkStatesPerPropertyKeyFrame; ++i)
+			{
+				FVmdObject::FPropertyKeyFrame::FIkState IkState;
+				WriteName(IkState.IkName, TEXT("Ik"), i % FMath::Max(1, Settings.IkNameCount));
+				IkState.Enabled = Random.RandRange(0, 1);
+				AppendRecord(Bytes, IkState);
+			}
+		}
+	}
+
+	return Bytes;
+}
+
+bool FVmdSyntheticWriter::WriteToFile(const FVmdSyntheticSettings& Settings, const FString& FilePath)
+{
+	return FFileHelper::SaveArrayToFile(Write(Settings), *FilePath);
+}
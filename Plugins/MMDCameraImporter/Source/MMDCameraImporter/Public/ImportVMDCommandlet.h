@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ImportVMDCommandlet.generated.h"
+
+class UMmdUserImportVmdSettings;
+
+/**
+ * Imports VMD camera motion into a level sequence without any viewport or dialog
+ *
+ * Usage: -run=ImportVmd -Path=<file or directory> -Sequence=<level sequence object path> [-<Setting>=<Value> ...] [-CreateShotPerFile] [-NoSave]
+ *
+ * Any property of UMmdUserImportVmdSettings can be overridden by name, e.g. -CameraCount=1 -CameraCutImportType=ConstantKey.
+ * Files of a directory are parsed in parallel and each one is imported into its own shot.
+ */
+UCLASS()
+class UImportVmdCommandlet final : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UImportVmdCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	static void ApplySettingsOverrides(const TMap<FString, FString>& ParamVals, const TArray<FString>& Switches, UMmdUserImportVmdSettings* ImportVmdSettings);
+
+	static bool CollectFiles(const FString& InPath, TArray<FString>& OutFilePaths, bool& bOutIsDirectory);
+};
@@ -4,8 +4,109 @@
 
 #include "CoreMinimal.h"
 
+/**
+ * Decoded names of a whole section in one shared buffer
+ */
+struct FMmdStringPool
+{
+	// every name back to back, without terminators
+	TArray<TCHAR> Chars;
+
+	// Num() + 1 entries, name i is Chars[Offsets[i]] .. Chars[Offsets[i + 1] - 1]
+	TArray<int32> Offsets;
+
+	int32 Num() const
+	{
+		return FMath::Max(0, Offsets.Num() - 1);
+	}
+
+	FStringView Get(const int32 Index) const
+	{
+		return FStringView(Chars.GetData() + Offsets[Index], Offsets[Index + 1] - Offsets[Index]);
+	}
+};
+
 class FMmdImportHelper
 {
 public:
 	static FString ShiftJisToFString(const uint8* InBuffer, int32 InSize);
+
+	/**
+	 * Bulk decode of InCount fixed width name fields InStride bytes apart, each name ends at its first NUL
+	 *
+	 * The pool is reset and filled with a fixed number of allocations regardless of InCount.
+	 */
+	static void ShiftJisToStringPool(const uint8* InBuffer, int32 InCount, int32 InStride, int32 InFieldSize, FMmdStringPool& OutPool);
+
+	/** Decode a name field of every key frame, e.g. DecodeNames(BoneKeyFrames, &FVmdObject::FBoneKeyFrame::BoneName, Pool) */
+	template<typename T, int32 FieldSize>
+	static void DecodeNames(const TArray<T>& KeyFrames, const uint8 (T::*InField)[FieldSize], FMmdStringPool& OutPool)
+	{
+		const uint8* FirstField = KeyFrames.Num() != 0 ? (KeyFrames[0].*InField) : nullptr;
+		ShiftJisToStringPool(FirstField, KeyFrames.Num(), sizeof(T), FieldSize, OutPool);
+	}
+
+	/**
+	 * Stable sort of key frames by their uint32 FrameNumber
+	 *
+	 * Already sorted arrays are detected in O(n) and left untouched,
+	 * otherwise an LSD radix sort runs over an index permutation and every key frame is moved exactly once.
+	 */
+	template<typename T>
+	static void SortByFrameNumber(TArray<T>& KeyFrames)
+	{
+		TArray<int32> Permutation;
+		if (!ComputeFrameNumberPermutation(KeyFrames, Permutation))
+		{
+			return;
+		}
+
+		TArray<T> Sorted;
+		Sorted.Reserve(KeyFrames.Num());
+		for (const int32 Index : Permutation)
+		{
+			Sorted.Add(MoveTemp(KeyFrames[Index]));
+		}
+		KeyFrames = MoveTemp(Sorted);
+	}
+
+	/**
+	 * Stable order of key frames by their uint32 FrameNumber, for layouts that have to gather more than one array
+	 *
+	 * @return false if the key frames are already sorted, OutPermutation is left empty in that case
+	 */
+	template<typename T>
+	static bool ComputeFrameNumberPermutation(const TArray<T>& KeyFrames, TArray<int32>& OutPermutation)
+	{
+		const int32 Num = KeyFrames.Num();
+
+		bool bIsSorted = true;
+		for (int32 i = 1; i < Num; ++i)
+		{
+			if (KeyFrames[i].FrameNumber < KeyFrames[i - 1].FrameNumber)
+			{
+				bIsSorted = false;
+				break;
+			}
+		}
+
+		if (bIsSorted)
+		{
+			OutPermutation.Reset();
+			return false;
+		}
+
+		TArray<uint32> FrameNumbers;
+		FrameNumbers.SetNumUninitialized(Num);
+		for (int32 i = 0; i < Num; ++i)
+		{
+			FrameNumbers[i] = KeyFrames[i].FrameNumber;
+		}
+
+		RadixSortIndices(FrameNumbers, OutPermutation);
+		return true;
+	}
+
+	/** Stable LSD radix sort, OutPermutation[i] is the index of the i-th smallest key */
+	static void RadixSortIndices(const TArray<uint32>& Keys, TArray<int32>& OutPermutation);
 };
@@ -16,6 +16,21 @@ enum class ECameraCutImportType
 	ImportAsIs UMETA(DisplayName = "Import As Is (For 30 frame animation)"),
 };
 
+UENUM()
+enum class ECurveImportType
+{
+	WeightedTangent UMETA(DisplayName = "Weighted Tangent (Key per MMD key, follows the MMD curve shape)"),
+	BakeLinear UMETA(DisplayName = "Bake Linear (Key per display frame, cheapest to evaluate)"),
+	BakeAuto UMETA(DisplayName = "Bake Auto Tangent (Key per display frame, smooth between frames)"),
+};
+
+UENUM()
+enum class EKeyReductionType
+{
+	Lossless UMETA(DisplayName = "Lossless (Drop keys equal to both neighbours)"),
+	Tolerance UMETA(DisplayName = "Tolerance (Drop keys while the curve stays within the tolerances)"),
+};
+
 USTRUCT()
 struct FFilmbackImportSettings
 {
@@ -52,6 +67,10 @@ public:
 	UPROPERTY(EditAnywhere, config, Category = KeyFrame, meta = (ClampMin = "1", ClampMax = "4"))
 	int CameraCount;
 
+	/** Curve Import Type, baked curves are sampled at the display rate of the sequence and ignore key reduction */
+	UPROPERTY(EditAnywhere, config, Category = KeyFrame)
+	ECurveImportType CurveImportType;
+
 	/** Add Motion Blur Key */
 	UPROPERTY(EditAnywhere, config, Category = KeyFrame)
 	bool bAddMotionBlurKey;
@@ -60,6 +79,54 @@ public:
 	UPROPERTY(EditAnywhere, config, Category = KeyFrame, meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "bAddMotionBlurKey"))
 	float MotionBlurAmount;
 
+	/** Largest change of camera location and distance that does not start a camera cut, after Import Uniform Scale. 0 treats every change as a cut */
+	UPROPERTY(EditAnywhere, config, Category = KeyFrame, meta = (ClampMin = "0.0", ForceUnits = cm))
+	float CameraCutPositionTolerance;
+
+	/** Largest change of camera rotation that does not start a camera cut */
+	UPROPERTY(EditAnywhere, config, Category = KeyFrame, meta = (ClampMin = "0.0", ForceUnits = deg))
+	float CameraCutAngleTolerance;
+
+	/** Largest change of the MMD view angle that does not start a camera cut */
+	UPROPERTY(EditAnywhere, config, Category = KeyFrame, meta = (ClampMin = "0.0", ForceUnits = deg))
+	float CameraCutViewAngleTolerance;
+
+	/** Largest distance in MMD frames between the two keys of a camera cut */
+	UPROPERTY(EditAnywhere, config, Category = KeyFrame, meta = (ClampMin = "1", ClampMax = "30"))
+	int CameraCutMaxFrameGap;
+
+	/** Key Reduction Type */
+	UPROPERTY(EditAnywhere, config, Category = KeyReduction)
+	EKeyReductionType KeyReductionType;
+
+	/** Largest allowed deviation of camera location and distance, after Import Uniform Scale */
+	UPROPERTY(EditAnywhere, config, Category = KeyReduction, meta = (ClampMin = "0.0", ForceUnits = cm, EditCondition = "KeyReductionType == EKeyReductionType::Tolerance"))
+	float PositionTolerance;
+
+	/** Largest allowed deviation of camera rotation */
+	UPROPERTY(EditAnywhere, config, Category = KeyReduction, meta = (ClampMin = "0.0", ForceUnits = deg, EditCondition = "KeyReductionType == EKeyReductionType::Tolerance"))
+	float AngleTolerance;
+
+	/** Largest allowed deviation of focal length */
+	UPROPERTY(EditAnywhere, config, Category = KeyReduction, meta = (ClampMin = "0.0", ForceUnits = mm, EditCondition = "KeyReductionType == EKeyReductionType::Tolerance"))
+	float FocalLengthTolerance;
+
+	/** Parse and compute keys on worker threads, progress is shown in a notification instead of a modal dialog */
+	UPROPERTY(EditAnywhere, config, Category = Import)
+	bool bImportInBackground;
+
+	/** Import every selected file into its own new shot sub-sequence instead of the current sequence, always on when several files are selected */
+	UPROPERTY(EditAnywhere, config, Category = Import)
+	bool bCreateShotPerFile;
+
+	/** Reuse the MmdCamera bindings of a previous import and only rewrite the keys that changed, new cameras are spawned if there are none */
+	UPROPERTY(EditAnywhere, config, Category = Import)
+	bool bReimportExisting;
+
+	/** Keep computed camera keys in Saved/MMDCameraImporter/Cache, importing the same file with the same settings again skips the computation */
+	UPROPERTY(EditAnywhere, config, Category = Import)
+	bool bUseImportCache;
+
 	/** Filmback */
 	UPROPERTY(EditAnywhere, config, Category = Camera, meta = (ShowOnlyInnerProperties))
 	FFilmbackImportSettings CameraFilmback;
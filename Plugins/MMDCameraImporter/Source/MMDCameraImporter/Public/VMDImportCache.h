@@ -0,0 +1,43 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VMDImporter.h"
+
+/**
+ * On-disk cache of computed cameras under Saved/MMDCameraImporter/Cache
+ *
+ * Entries are keyed by the camera key frames, every import setting that changes the keys and the movie scene rates,
+ * a hit skips key reduction and tangent computation and goes straight to the channel commit.
+ */
+class FVmdImportCache
+{
+public:
+	/** Hex digest of everything the computed camera depends on */
+	static FString MakeKey(const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames, const FVmdCameraImportParams& Params);
+
+	/** Returns false on a miss or if the entry can't be read, an unreadable entry is deleted */
+	static bool Load(const FString& Key, FVmdComputedCamera& OutComputedCamera);
+
+	/** The first store of a session also runs Evict */
+	static void Store(const FString& Key, const FVmdComputedCamera& InComputedCamera);
+
+	/** Deletes entries unused for 30 days, then the least recently used ones until the cache is below 512 MB */
+	static void Evict();
+
+	/** FVmdImporter::ComputeVmdCamera through the cache, a miss computes the camera and stores it. bypassed if Params.bUseImportCache is false */
+	static FVmdComputedCamera ComputeVmdCamera(
+		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		const FVmdCameraImportParams& Params,
+		bool* bOutCacheHit = nullptr
+	);
+
+	/** Compact binary form of a computed camera, reads or writes depending on the archive. Corrupt array counts set the archive error */
+	static void Serialize(FArchive& Ar, FVmdComputedCamera& ComputedCamera);
+
+	static FString GetCacheDirectory();
+
+private:
+	static FString GetEntryPath(const FString& Key);
+};
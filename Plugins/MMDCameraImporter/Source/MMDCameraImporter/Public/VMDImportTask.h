@@ -0,0 +1,88 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VMDImporter.h"
+
+class ISequencer;
+class SNotificationItem;
+class UMmdUserImportVmdSettings;
+class UMovieSceneSequence;
+class UMovieSceneSubSection;
+
+/**
+ * Non modal VMD camera import
+ *
+ * Every file is parsed and computed on its own worker task, only the actor spawns and channel writes run on the game thread,
+ * one file after another in selection order.
+ * Progress is shown in a notification with a cancel button, cancellation is checked at every stage boundary.
+ */
+class FVmdImportTask final : public TSharedFromThis<FVmdImportTask>
+{
+public:
+	/** Settings are copied on the calling thread, so they can be edited while the import is running */
+	static TSharedRef<FVmdImportTask> Launch(
+		const TArray<FString>& InFilePaths,
+		UMovieSceneSequence* InSequence,
+		ISequencer& InSequencer,
+		const UMmdUserImportVmdSettings* ImportVmdSettings
+	);
+
+	void Cancel();
+
+	bool IsCancelled() const { return bCancelRequested; }
+
+private:
+	struct FFileResult
+	{
+		FString FilePath;
+		bool bIsSuccess = false;
+		FText ErrorText;
+
+		TSharedPtr<FVmdComputedCamera> ComputedCamera;
+		FVmdObject::FCameraKeyFrame FirstKeyFrame;
+		uint32 LastFrameNumber = 0;
+		FVmdKeyReductionStats KeyReduction;
+
+		double ParseSeconds = 0.0;
+		double ComputeSeconds = 0.0;
+		double CommitSeconds = 0.0;
+	};
+
+	FVmdImportTask(
+		const TArray<FString>& InFilePaths,
+		UMovieSceneSequence* InSequence,
+		ISequencer& InSequencer,
+		const FVmdCameraImportParams& InParams,
+		const bool bInCreateShotPerFile
+	);
+
+	void Start();
+
+	/** Parse and compute a single file, runs on a worker task and only writes FileResults[Index] */
+	void ProcessFile(const int32 Index);
+
+	void CommitAll();
+
+	bool CommitFile(FFileResult& InFileResult, UMovieSceneSequence* InSequence, ISequencer& InSequencer) const;
+
+	void ReportSummary() const;
+
+	FText GetFileLabel() const;
+
+	void SetStageText(const FText& InText) const;
+
+	void Finish(const bool bIsSuccess, const FText& InText) const;
+
+private:
+	TArray<FFileResult> FileResults;
+	TWeakObjectPtr<UMovieSceneSequence> WeakSequence;
+	TWeakPtr<ISequencer> WeakSequencer;
+	FVmdCameraImportParams Params;
+	bool bCreateShotPerFile;
+
+	TSharedPtr<SNotificationItem> Notification;
+	std::atomic<bool> bCancelRequested;
+	std::atomic<int32> ProcessedFileCount;
+};
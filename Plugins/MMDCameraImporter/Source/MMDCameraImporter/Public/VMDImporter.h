@@ -6,130 +6,348 @@
 #include "CineCameraComponent.h"
 #include "ISequencer.h"
 #include "MMDUserImportVMDSettings.h"
+#include "VMDNameTable.h"
+#include "Algo/IsSorted.h"
+#include "Algo/StableSort.h"
 #include "Channels/MovieSceneDoubleChannel.h"
+#include "Channels/MovieSceneFloatChannel.h"
+#include "Misc/MemStack.h"
 #include "Tracks/MovieSceneCameraCutTrack.h"
+#include "VmdCore/VmdCameraMath.h"
+#include "VmdCore/VmdFormat.h"
 
-// TODO: little endian check
+using FVmdObject = VmdCore::FVmdObject;
 
-#pragma pack (push, 1)
 /**
- * Representation of raw VMD data
+ * Offset and count of every section in a VMD file
+ *
+ * Built by a single scan over the section counts, so a file can be inspected without being parsed
  */
-struct FVmdObject
+struct FVmdSectionDirectory : VmdCore::FSectionLayout
 {
-	struct FHeader
-	{
-		uint8 Magic[30]; // this value must be 'Vocaloid Motion Data 0002'
-		uint8 ModelName[20];
-	};
+	using FSection = VmdCore::FSection;
 
-	// uint32 BoneKeyFrameCount; then FBoneKeyFrame[BoneKeyFrameCount]
+	using FIkRun = VmdCore::FIkRun;
 
-	struct FBoneKeyFrame
-	{
-		uint8 BoneName[15];
-		uint32 FrameNumber;
-		float Position[3];
-		float Rotation[4];
-		int8 Interpolation[64];
-	};
+	// one run per property key frame, in file order
+	TArray<FIkRun> IkRuns;
 
-	// uint32 MorphKeyFrameCount; then FMorphKeyFrame[MorphKeyFrameCount]
+	// must read exactly Size bytes at Offset, returns false on failure
+	using FReadFunc = TFunctionRef<bool(int64 Offset, void* Dest, int64 Size)>;
 
-	struct FMorphKeyFrame
-	{
-		uint8 MorphName[15];
-		uint32 FrameNumber;
-		float Weight;
-	};
+	/** Scan the section counts of a file, logs the reason and returns false if the file is not a valid VMD file */
+	static bool Scan(const int64 InFileSize, FReadFunc Read, FVmdSectionDirectory& OutDirectory);
+};
 
-	// uint32 CameraKeyFrameCount; then FCameraKeyFrame[CameraKeyFrameCount]
+struct FVmdParseResult
+{
+	bool bIsSuccess;
 
-	struct FCameraKeyFrame
-	{
-		uint32 FrameNumber;
-		float Distance;
-		float Position[3];
-		float Rotation[3];
-		int8 Interpolation[24];
-		uint32 ViewAngle;
-		uint8 Perspective; // this value can be reinterpret_cast to bool
-	};
+	FVmdObject::FHeader Header;
 
-	// uint32 LightKeyFrameCount; then FLightKeyFrame[LightKeyFrameCount]
 
-	struct FLightKeyFrame
-	{
-		uint32 FrameNumber;
-		float Color[3];
-		float Direction[3];
-	};
+	TArray<FVmdObject::FBoneKeyFrame> BoneKeyFrames;
+
+	TArray<FVmdObject::FMorphKeyFrame> MorphKeyFrames;
+
+	TArray<FVmdObject::FCameraKeyFrame> CameraKeyFrames;
+
+	TArray<FVmdObject::FLightKeyFrame> LightKeyFrames;
 
-	// uint32 SelfShadowKeyFrameCount; then FSelfShadowKeyFrame[SelfShadowKeyFrameCount]
+	TArray<FVmdObject::FSelfShadowKeyFrame> SelfShadowKeyFrames;
 
-	struct FSelfShadowKeyFrame
+	/**
+	 * Property key frames are stored in compressed sparse row layout,
+	 * ik states of PropertyKeyFrames[i] are IkStates[IkStateOffsets[i]] .. IkStates[IkStateOffsets[i + 1] - 1]
+	 */
+	struct FPropertyKeyFrameState
 	{
 		uint32 FrameNumber;
-		uint8 Mode;
-		float Distance;
+		bool Visible;
 	};
+	TArray<FPropertyKeyFrameState> PropertyKeyFrames;
+
+	// PropertyKeyFrames.Num() + 1 entries
+	TArray<int32> IkStateOffsets;
+
+	TArray<FVmdObject::FPropertyKeyFrame::FIkState> IkStates;
 
-	// uint32 PropertyKeyFrameCount; then FPropertyKeyFrame[PropertyKeyFrameCount]
+	/**
+	 * Interned names, BoneNameIds[i] is the id of BoneKeyFrames[i] in BoneNames and so on.
+	 * IkNameIds is parallel to IkStates.
+	 */
+	FVmdNameTable BoneNames;
+	TArray<uint16> BoneNameIds;
 
-	struct FPropertyKeyFrame
+	FVmdNameTable MorphNames;
+	TArray<uint16> MorphNameIds;
+
+	FVmdNameTable IkNames;
+	TArray<uint16> IkNameIds;
+
+	TConstArrayView<FVmdObject::FPropertyKeyFrame::FIkState> GetIkStates(const int32 PropertyKeyFrameIndex) const
 	{
-		uint32 FrameNumber;
-		uint8 Visible; // this value can be reinterpret_cast to bool
+		const int32 Begin = IkStateOffsets[PropertyKeyFrameIndex];
+		return TConstArrayView<FVmdObject::FPropertyKeyFrame::FIkState>(IkStates.GetData() + Begin, IkStateOffsets[PropertyKeyFrameIndex + 1] - Begin);
+	}
 
-		// uint32 IkStateCount; then FIkState[IkStateCount]
+	/** heap memory owned by the key frame arrays */
+	SIZE_T GetAllocatedSize() const;
+};
 
-		struct FIkState
-		{
-			uint8 IkName[20];
-			uint8 Enabled; // this value can be reinterpret_cast to bool
-		};
-	};
+class ACineCameraActor;
+class FVmdMappedFile;
+class UMovieSceneSubSection;
+
+enum class EVmdReadMode : uint8
+{
+	// read every section through FArchive
+	Archive,
+	// map the whole file into memory, falls back to Archive if the platform can't map the file
+	MemoryMapped,
 };
-#pragma pack (pop)
 
-struct FVmdParseResult
+/** Outcome of FVmdMappedFile::Open */
+enum class EVmdMapResult : uint8
 {
-	bool bIsSuccess;
+	NotAttempted,
+	Success,
+	// the platform can't map the file, archive reads are used instead
+	MapFailed,
+	// mapped but not a valid VMD file, the archive read would reject it as well
+	InvalidFile,
+};
 
-	FVmdObject::FHeader Header;
+/**
+ * Sections to read in FVmdImporter::ParseVmdFile, unrequested sections are skipped using their counts
+ */
+enum class EVmdSections : uint8
+{
+	None = 0,
+	Bone = 1 << 0,
+	Morph = 1 << 1,
+	Camera = 1 << 2,
+	Light = 1 << 3,
+	SelfShadow = 1 << 4,
+	Property = 1 << 5,
+	All = Bone | Morph | Camera | Light | SelfShadow | Property,
+};
+ENUM_CLASS_FLAGS(EVmdSections);
 
+/**
+ * Copy of the import settings and movie scene rates, safe to read from worker threads
+ */
+struct FVmdCameraImportParams
+{
+	// display rate of the movie scene
+	FFrameRate SampleRate;
 
-	TArray<FVmdObject::FBoneKeyFrame> BoneKeyFrames;
+	// tick resolution of the movie scene
+	FFrameRate FrameRate;
 
-	TArray<FVmdObject::FMorphKeyFrame> MorphKeyFrames;
+	float ImportUniformScale;
 
-	TArray<FVmdObject::FCameraKeyFrame> CameraKeyFrames;
+	ECameraCutImportType CameraCutImportType;
 
-	TArray<FVmdObject::FLightKeyFrame> LightKeyFrames;
+	int32 CameraCount;
 
-	TArray<FVmdObject::FSelfShadowKeyFrame> SelfShadowKeyFrames;
+	ECurveImportType CurveImportType;
+
+	bool bAddMotionBlurKey;
+
+	float MotionBlurAmount;
+
+	float SensorWidth;
+
+	float SensorHeight;
+
+	EKeyReductionType KeyReductionType;
+
+	float PositionTolerance;
+
+	float AngleTolerance;
+
+	float FocalLengthTolerance;
+
+	// camera cut thresholds in sequencer units, like the key reduction tolerances
+	float CameraCutPositionTolerance;
+
+	float CameraCutAngleTolerance;
+
+	float CameraCutViewAngleTolerance;
+
+	int32 CameraCutMaxFrameGap;
+
+	// compute the camera channels on worker threads, the result is identical to the serial path
+	bool bParallelChannels;
+
+	// reuse the bindings of a previous import and only rewrite the keys that changed
+	bool bReimportExisting;
+
+	// look up computed cameras in FVmdImportCache before computing them
+	bool bUseImportCache;
+
+	static FVmdCameraImportParams Make(const UMovieScene* InMovieScene, const UMmdUserImportVmdSettings* ImportVmdSettings);
+
+	/** Camera cut thresholds converted to the units of the key frame fields */
+	VmdCore::FCameraCutThresholds GetCameraCutThresholds() const;
+};
+
+/**
+ * Temporary array of the camera computation, allocated from the FMemStack of the calling thread
+ *
+ * Every thread that computes a camera opens an FMemMark first, all scratch arrays are freed together when it goes out of scope.
+ */
+template<typename T>
+using TVmdScratchArray = TArray<T, TMemStackAllocator<>>;
+
+/**
+ * Keys of a single camera property, already distributed to one channel per camera
+ */
+template<typename MovieSceneChannel>
+struct TVmdComputedChannel
+{
+	using FMovieSceneValue = typename MovieSceneChannel::ChannelValueType;
+
+	typename MovieSceneChannel::CurveValueType DefaultValue;
+
+	// indexed by camera, keys are in the order they have to be added to the channel
+	TArray<TArray<TPair<FFrameNumber, FMovieSceneValue>>> CameraKeys;
+
+	// keys use auto tangents that are computed once they are in the channel
+	bool bAutoSetTangents = false;
+};
+
+/**
+ * Key counts of the eight camera channels before and after key reduction
+ */
+struct FVmdKeyReductionStats
+{
+	int32 KeysBefore = 0;
+
+	int32 KeysAfter = 0;
+
+	// largest deviation from the imported curves in sequencer units, zero for lossless reduction
+	double MaxPositionError = 0.0;
+
+	double MaxAngleError = 0.0;
+
+	double MaxFocalLengthError = 0.0;
+};
+
+/**
+ * What a re-import into existing camera bindings had to rewrite
+ */
+struct FVmdReimportStats
+{
+	int32 ChangedChannels = 0;
+
+	int32 UnchangedChannels = 0;
+
+	// keys in the rewritten spans, keys before the first and after the last difference of a channel are kept
+	int32 RewrittenKeys = 0;
+
+	bool bCameraCutsChanged = false;
+};
+
+/**
+ * Every key of a camera import, computed without touching the movie scene
+ */
+struct FVmdComputedCamera
+{
+	TArray<TRange<uint32>> CameraCuts;
+
+	FVmdKeyReductionStats KeyReduction;
+
+	TVmdComputedChannel<FMovieSceneFloatChannel> FocalLength;
+
+	// empty if motion blur keys are disabled
+	TVmdComputedChannel<FMovieSceneFloatChannel> MotionBlur;
+
+	TVmdComputedChannel<FMovieSceneDoubleChannel> Distance;
+
+	TVmdComputedChannel<FMovieSceneDoubleChannel> LocationX;
+
+	TVmdComputedChannel<FMovieSceneDoubleChannel> LocationY;
+
+	TVmdComputedChannel<FMovieSceneDoubleChannel> LocationZ;
+
+	TVmdComputedChannel<FMovieSceneDoubleChannel> RotationX;
+
+	TVmdComputedChannel<FMovieSceneDoubleChannel> RotationY;
+
+	TVmdComputedChannel<FMovieSceneDoubleChannel> RotationZ;
+};
 
-	struct FPropertyKeyFrameWithIkState
+/**
+ * Conversion from a VMD channel value to the unit of the sequencer channel
+ */
+enum class EVmdCameraUnitMapping : uint8
+{
+	// view angle in degrees to half of the focal length
+	FocalLength,
+	// MMD units scaled by ImportUniformScale
+	UniformScale,
+	// radians to degrees
+	Degrees,
+	// radians to degrees, negated for the opposite handedness
+	NegatedDegrees,
+};
+
+/**
+ * Compile time description of a sequencer camera channel
+ *
+ * Source picks the key frame field and the interpolation bytes, Mapping the unit conversion.
+ */
+template<typename InMovieSceneChannel, VmdCore::ECameraChannel InSource, EVmdCameraUnitMapping InMapping>
+struct TVmdCameraChannelDescriptor
+{
+	using MovieSceneChannel = InMovieSceneChannel;
+
+	using FSourceDescriptor = VmdCore::TCameraChannelDescriptor<InSource>;
+
+	static constexpr VmdCore::ECameraChannel Source = InSource;
+
+	static constexpr EVmdCameraUnitMapping Mapping = InMapping;
+
+	static typename MovieSceneChannel::CurveValueType GetValue(const FVmdObject::FCameraKeyFrame& KeyFrame)
 	{
-		uint32 FrameNumber;
-		bool Visible;
-		TArray<FVmdObject::FPropertyKeyFrame::FIkState> IkStates;
-	};
-	TArray<FPropertyKeyFrameWithIkState> PropertyKeyFrames;
+		return VmdCore::GetCameraChannelValue<InSource>(KeyFrame);
+	}
 };
 
+// mmd is y up, the sequencer location x, y and z come from mmd z, x and y
+using FVmdFocalLengthChannel = TVmdCameraChannelDescriptor<FMovieSceneFloatChannel, VmdCore::ECameraChannel::ViewAngle, EVmdCameraUnitMapping::FocalLength>;
+using FVmdDistanceChannel = TVmdCameraChannelDescriptor<FMovieSceneDoubleChannel, VmdCore::ECameraChannel::Distance, EVmdCameraUnitMapping::UniformScale>;
+using FVmdLocationXChannel = TVmdCameraChannelDescriptor<FMovieSceneDoubleChannel, VmdCore::ECameraChannel::PositionZ, EVmdCameraUnitMapping::UniformScale>;
+using FVmdLocationYChannel = TVmdCameraChannelDescriptor<FMovieSceneDoubleChannel, VmdCore::ECameraChannel::PositionX, EVmdCameraUnitMapping::UniformScale>;
+using FVmdLocationZChannel = TVmdCameraChannelDescriptor<FMovieSceneDoubleChannel, VmdCore::ECameraChannel::PositionY, EVmdCameraUnitMapping::UniformScale>;
+using FVmdRotationXChannel = TVmdCameraChannelDescriptor<FMovieSceneDoubleChannel, VmdCore::ECameraChannel::RotationZ, EVmdCameraUnitMapping::Degrees>;
+using FVmdRotationYChannel = TVmdCameraChannelDescriptor<FMovieSceneDoubleChannel, VmdCore::ECameraChannel::RotationX, EVmdCameraUnitMapping::Degrees>;
+using FVmdRotationZChannel = TVmdCameraChannelDescriptor<FMovieSceneDoubleChannel, VmdCore::ECameraChannel::RotationY, EVmdCameraUnitMapping::NegatedDegrees>;
+
 class FVmdImporter
 {
 private:
-	struct FTangentAccessIndices;
+	using FTangentAccessIndices = VmdCore::FTangentAccessIndices;
 
 	template<typename T>
 	struct TComputedKey;
 
 public:
 	void SetFilePath(const FString& InFilePath);
+	void SetReadMode(const EVmdReadMode InReadMode);
 	bool IsValidVmdFile();
-	FVmdParseResult ParseVmdFile();
+	FVmdParseResult ParseVmdFile(const EVmdSections Sections = EVmdSections::All);
+
+	/** Fill the name tables and ids of the parsed bone, morph and ik key frames */
+	static void InternNames(FVmdParseResult& InOutVmdParseResult);
+
+	/** Section directory produced by IsValidVmdFile, nullptr if the file has not been validated yet */
+	const FVmdSectionDirectory* GetSectionDirectory() const;
+
+	/** Zero copy access to the file, key frames are not sorted. returns nullptr if the file can't be mapped */
+	TSharedPtr<const FVmdMappedFile> MapVmdFile();
 
 	static void ImportVmdCamera(
 		const FVmdParseResult& InVmdParseResult,
@@ -138,64 +356,243 @@ public:
 		const UMmdUserImportVmdSettings* ImportVmdSettings
 	);
 
+	/** Key reduction, camera cut detection and tangent computation. does not touch any UObject, so it can run on any thread */
+	static FVmdComputedCamera ComputeVmdCamera(
+		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		const FVmdCameraImportParams& Params
+	);
+
+	/**
+	 * Keys that start a camera cut, a key at most CameraCutMaxFrameGap frames after the previous one with a value that changed by more than its cut tolerance
+	 *
+	 * ChannelValues is the transposition of the key frames from VmdCore::TransposeCameraKeyFrames.
+	 * The cut list is computed once per import and shared by the camera cut track, the channel distribution and the motion blur keys.
+	 */
+	static void DetectCameraCuts(
+		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		const float* ChannelValues,
+		const FVmdCameraImportParams& Params,
+		TVmdScratchArray<int32>& OutCutIndices
+	);
+
+	/** Frame ranges between camera cuts */
+	static TArray<TRange<uint32>> ComputeCameraCutRanges(
+		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		TConstArrayView<int32> CutIndices
+	);
+
+	/** Convert a VMD channel value to the unit of the sequencer channel */
+	template<EVmdCameraUnitMapping Mapping, typename T>
+	static T MapCameraValue(const T Value, const FVmdCameraImportParams& Params)
+	{
+		if constexpr (Mapping == EVmdCameraUnitMapping::FocalLength)
+		{
+			return ComputeFocalLength(Value, Params.SensorWidth) / 2;
+		}
+		else if constexpr (Mapping == EVmdCameraUnitMapping::UniformScale)
+		{
+			return Value * Params.ImportUniformScale;
+		}
+		else if constexpr (Mapping == EVmdCameraUnitMapping::Degrees)
+		{
+			return FMath::RadiansToDegrees(Value);
+		}
+		else
+		{
+			return -FMath::RadiansToDegrees(Value);
+		}
+	}
+
+	/**
+	 * Add keys to a channel in one operation
+	 *
+	 * Same result as calling AddKey for every key in order, but the time and value arrays are built once
+	 * and installed with Set, so the channel reallocates and rebuilds its key handles a single time.
+	 */
+	template<typename MovieSceneChannel>
+	static void PopulateChannel(
+		MovieSceneChannel& Channel,
+		const TArray<TPair<FFrameNumber, typename MovieSceneChannel::ChannelValueType>>& Keys
+	)
+	{
+		using FMovieSceneValue = typename MovieSceneChannel::ChannelValueType;
+
+		if (Keys.Num() == 0)
+		{
+			return;
+		}
+
+		TArray<FFrameNumber> Times;
+		TArray<FMovieSceneValue> Values;
+		{
+			const TMovieSceneChannelData<FMovieSceneValue> ChannelData = Channel.GetData();
+			Times.Reserve(ChannelData.GetTimes().Num() + Keys.Num());
+			Values.Reserve(ChannelData.GetTimes().Num() + Keys.Num());
+			Times.Append(ChannelData.GetTimes().GetData(), ChannelData.GetTimes().Num());
+			Values.Append(ChannelData.GetValues().GetData(), ChannelData.GetValues().Num());
+		}
+
+		AppendSortedKeys(Keys, Times, Values);
+
+		Channel.Set(MoveTemp(Times), MoveTemp(Values));
+	}
+
+	/** Spawn camera actors and write the computed keys to the sequence, game thread only */
+	static void ImportComputedVmdCamera(
+		const FVmdComputedCamera& InComputedCamera,
+		const FVmdObject::FCameraKeyFrame& InFirstKeyFrame,
+		UMovieSceneSequence* InSequence,
+		ISequencer& InSequencer,
+		const FVmdCameraImportParams& Params
+	);
+
+	/**
+	 * Create spawnable camera rigs in the sequence and write the computed keys to them
+	 *
+	 * Unlike ImportComputedVmdCamera this needs neither a sequencer nor an editor world, so it can be used by commandlets.
+	 */
+	static void ImportComputedVmdCameraAsSpawnables(
+		const FVmdComputedCamera& InComputedCamera,
+		UMovieSceneSequence* InSequence,
+		const FVmdCameraImportParams& Params
+	);
+
+	/** Create a new level sequence asset next to the parent and append it to the parent's cinematic shot track */
+	static UMovieSceneSubSection* CreateShotSequence(
+		const FString& InFilePath,
+		const uint32 LastFrameNumber,
+		UMovieSceneSequence* InParentSequence
+	);
+
 private:
 	static FArchive* OpenFile(FString FilePath);
+
+	bool ScanArchive();
+
+	FVmdParseResult ParseArchiveVmdFile(const EVmdSections Sections);
+
+	static FVmdParseResult ParseMappedVmdFile(const FVmdMappedFile& InMappedFile, const EVmdSections Sections);
+
+	/** Bulk decode of the whole property section, InSectionBytes starts at InDirectory.PropertyKeyFrames.Offset */
+	static bool DecodePropertyKeyFrames(
+		const TConstArrayView<uint8> InSectionBytes,
+		const FVmdSectionDirectory& InDirectory,
+		FVmdParseResult& OutVmdParseResult
+	);
 	
 	static void ImportVmdCameraToExisting(
-		const FVmdParseResult& InVmdParseResult,
+		const FVmdComputedCamera& InComputedCamera,
 		UMovieSceneSequence* InSequence,
 		IMovieScenePlayer* Player,
 		FMovieSceneSequenceIDRef TemplateID,
 		const TArray<FGuid>& CameraGuids,
 		const TArray<FGuid>& CameraCenterGuids,
-		const UMmdUserImportVmdSettings* ImportVmdSettings
+		FVmdReimportStats* OutReimportStats
+	);
+
+	/**
+	 * Find the MmdCamera{N} and MmdCameraCenter{N} bindings of a previous import
+	 *
+	 * Cameras without both bindings or a resolvable camera actor get invalid guids, bindings past CameraCount are reported with a warning.
+	 *
+	 * @return false if no camera of a previous import is found
+	 */
+	static bool FindImportedCameraBindings(
+		UMovieScene* InMovieScene,
+		IMovieScenePlayer* Player,
+		FMovieSceneSequenceIDRef TemplateID,
+		const int32 CameraCount,
+		TArray<FGuid>& OutCameraGuids,
+		TArray<FGuid>& OutCameraCenterGuids
+	);
+
+	/** Spawn the MmdCamera{Index} and MmdCameraCenter{Index} actors into the focused sequence */
+	static void SpawnCameraActors(
+		const int32 Index,
+		const FVmdObject::FCameraKeyFrame& InFirstKeyFrame,
+		ISequencer& InSequencer,
+		const FVmdCameraImportParams& Params,
+		FGuid& OutCameraGuid,
+		FGuid& OutCameraCenterGuid
+	);
+
+	/** Actor defaults of an import, the first frame transform, the filmback and the focal length */
+	static void ApplyCameraDefaults(
+		ACineCameraActor* Camera,
+		AActor* CameraCenter,
+		const FVmdObject::FCameraKeyFrame& InFirstKeyFrame,
+		const FVmdCameraImportParams& Params
+	);
+
+	/** OutReimportStats is null for a full rewrite, otherwise existing keys are diffed and only the changed spans are written */
+	static void WriteComputedCamera(
+		const FVmdComputedCamera& InComputedCamera,
+		UMovieSceneSequence* InSequence,
+		const TArray<FGuid>& CameraGuids,
+		const TArray<FGuid>& CameraPropertyOwnerGuids,
+		const TArray<FGuid>& CameraCenterGuids,
+		FVmdReimportStats* OutReimportStats
 	);
 
 	static void CreateCameraCutTrack(
 		const TArray<TRange<uint32>>& InCameraCuts,
 		const TArray<FGuid>& ObjectBindings,
-		const UMovieSceneSequence* InSequence
+		const UMovieSceneSequence* InSequence,
+		FVmdReimportStats* OutReimportStats
 	);
 
 	static bool ImportVmdCameraFocalLengthProperty(
-		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
-		const TArray<TRange<uint32>>& InCameraCuts,
+		const TVmdComputedChannel<FMovieSceneFloatChannel>& InComputedChannel,
 		const TArray<FGuid>& ObjectBindings,
 		const UMovieSceneSequence* InSequence,
-		const TArray<UCineCameraComponent*>& InCineCameraComponents,
-		const UMmdUserImportVmdSettings* ImportVmdSettings
+		FVmdReimportStats* OutReimportStats
 	);
 
 	static bool CreateVmdCameraMotionBlurProperty(
-		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
-		const TArray<TRange<uint32>>& InCameraCuts,
+		const TVmdComputedChannel<FMovieSceneFloatChannel>& InComputedChannel,
 		const TArray<FGuid>& ObjectBindings,
 		const UMovieSceneSequence* InSequence,
-		const UMmdUserImportVmdSettings* ImportVmdSettings
+		FVmdReimportStats* OutReimportStats
+	);
+
+	/** Remove the motion blur tracks a previous import with motion blur keys added */
+	static void RemoveVmdCameraMotionBlurProperty(
+		const TArray<FGuid>& ObjectBindings,
+		const UMovieSceneSequence* InSequence,
+		FVmdReimportStats* OutReimportStats
 	);
 
 	static bool ImportVmdCameraTransform(
-		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
-		const TArray<TRange<uint32>>& InCameraCuts,
+		const TVmdComputedChannel<FMovieSceneDoubleChannel>& InComputedDistance,
 		const TArray<FGuid>& ObjectBindings,
 		const UMovieSceneSequence* InSequence,
-		const UMmdUserImportVmdSettings* ImportVmdSettings
+		FVmdReimportStats* OutReimportStats
 	);
 
 	static bool ImportVmdCameraCenterTransform(
-		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
-		const TArray<TRange<uint32>>& InCameraCuts,
+		const FVmdComputedCamera& InComputedCamera,
 		const TArray<FGuid>& ObjectBindings,
 		const UMovieSceneSequence* InSequence,
-		const UMmdUserImportVmdSettings* ImportVmdSettings
+		FVmdReimportStats* OutReimportStats
 	);
 
-	static float ComputeFocalLength(const float FieldOfView, const float SensorWidth);
+	/** Sample the MMD curves at the display rate instead of converting every key, see ECurveImportType */
+	static void BakeVmdCamera(
+		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		TConstArrayView<int32> CutIndices,
+		const FVmdCameraImportParams& Params,
+		FVmdComputedCamera& OutComputedCamera
+	);
 
-	static TArray<TRange<uint32>> ComputeCameraCuts(
-		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames
+	static TVmdComputedChannel<FMovieSceneFloatChannel> ComputeMotionBlurChannel(
+		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		TConstArrayView<int32> CutIndices,
+		const TArray<TRange<uint32>>& InCameraCuts,
+		const FVmdCameraImportParams& Params
 	);
 
+	static float ComputeFocalLength(const float FieldOfView, const float SensorWidth);
+
 	static FGuid GetHandleToObject(
 		UObject* InObject,
 		UMovieSceneSequence* InSequence,
@@ -205,67 +602,291 @@ private:
 	);
 
 	static UMovieSceneCameraCutTrack* GetCameraCutTrack(UMovieScene* InMovieScene);
-	
-	// MovieSceneChannel must be FMovieSceneDoubleChannel or FMovieSceneFloatChannel
+
+	/** Append keys to parallel time and value arrays, a stable sort afterwards gives the order AddKey would */
+	template<typename FMovieSceneValue>
+	static void AppendSortedKeys(
+		const TArray<TPair<FFrameNumber, FMovieSceneValue>>& Keys,
+		TArray<FFrameNumber>& InOutTimes,
+		TArray<FMovieSceneValue>& InOutValues
+	)
+	{
+		for (const TPair<FFrameNumber, FMovieSceneValue>& Key : Keys)
+		{
+			InOutTimes.Add(Key.Key);
+			InOutValues.Add(Key.Value);
+		}
+
+		// AddKey inserts after keys at the same time
+		if (!Algo::IsSorted(InOutTimes))
+		{
+			TArray<int32> Order;
+			Order.SetNumUninitialized(InOutTimes.Num());
+			for (int32 i = 0; i < Order.Num(); ++i)
+			{
+				Order[i] = i;
+			}
+			Algo::StableSortBy(Order, [&InOutTimes](const int32 Index) { return InOutTimes[Index]; });
+
+			TArray<FFrameNumber> SortedTimes;
+			TArray<FMovieSceneValue> SortedValues;
+			SortedTimes.Reserve(Order.Num());
+			SortedValues.Reserve(Order.Num());
+			for (const int32 Index : Order)
+			{
+				SortedTimes.Add(InOutTimes[Index]);
+				SortedValues.Add(InOutValues[Index]);
+			}
+			InOutTimes = MoveTemp(SortedTimes);
+			InOutValues = MoveTemp(SortedValues);
+		}
+	}
+
+	/**
+	 * Write computed keys to channels that already hold a previous import
+	 *
+	 * Keys before the first and after the last difference stay in place, only the span between them is replaced.
+	 * A section is modified only if one of its channels changed, so unchanged channels stay out of the undo transaction.
+	 * Auto tangents are compared without the tangents, which are recomputed after the merge.
+	 */
+	template<typename MovieSceneChannel>
+	static void MergeComputedChannel(
+		const TVmdComputedChannel<MovieSceneChannel>& InComputedChannel,
+		TArray<MovieSceneChannel*>& Channels,
+		const TArray<UMovieSceneSection*>& Sections,
+		FVmdReimportStats& OutReimportStats
+	)
+	{
+		using FMovieSceneValue = typename MovieSceneChannel::ChannelValueType;
+
+		check(Channels.Num() == Sections.Num());
+		check(InComputedChannel.CameraKeys.Num() == 0 || InComputedChannel.CameraKeys.Num() == Channels.Num());
+
+		const auto IsSameKey = [bAutoSetTangents = InComputedChannel.bAutoSetTangents](const FMovieSceneValue& A, const FMovieSceneValue& B)
+		{
+			return bAutoSetTangents
+				? A.Value == B.Value && A.InterpMode == B.InterpMode && A.TangentMode == B.TangentMode
+				: A == B;
+		};
+
+		for (int32 i = 0; i < Channels.Num(); ++i)
+		{
+			MovieSceneChannel& Channel = *Channels[i];
+
+			TArray<FFrameNumber> NewTimes;
+			TArray<FMovieSceneValue> NewValues;
+			if (InComputedChannel.CameraKeys.IsValidIndex(i))
+			{
+				NewTimes.Reserve(InComputedChannel.CameraKeys[i].Num());
+				NewValues.Reserve(InComputedChannel.CameraKeys[i].Num());
+				AppendSortedKeys(InComputedChannel.CameraKeys[i], NewTimes, NewValues);
+			}
+
+			const TMovieSceneChannelData<FMovieSceneValue> ChannelData = Channel.GetData();
+			const TArrayView<const FFrameNumber> OldTimes = ChannelData.GetTimes();
+			const TArrayView<const FMovieSceneValue> OldValues = ChannelData.GetValues();
+
+			// common prefix and suffix, the suffix never overlaps the prefix
+			const int32 SharedCount = FMath::Min(OldTimes.Num(), NewTimes.Num());
+			int32 PrefixCount = 0;
+			while (PrefixCount < SharedCount && OldTimes[PrefixCount] == NewTimes[PrefixCount] && IsSameKey(OldValues[PrefixCount], NewValues[PrefixCount]))
+			{
+				PrefixCount += 1;
+			}
+			int32 SuffixCount = 0;
+			while (SuffixCount < SharedCount - PrefixCount &&
+				OldTimes[OldTimes.Num() - 1 - SuffixCount] == NewTimes[NewTimes.Num() - 1 - SuffixCount] &&
+				IsSameKey(OldValues[OldValues.Num() - 1 - SuffixCount], NewValues[NewValues.Num() - 1 - SuffixCount]))
+			{
+				SuffixCount += 1;
+			}
+
+			const bool bKeysChanged = PrefixCount + SuffixCount != OldTimes.Num() || OldTimes.Num() != NewTimes.Num();
+			const TOptional<typename MovieSceneChannel::CurveValueType> OldDefault = Channel.GetDefault();
+			const bool bDefaultChanged = !OldDefault.IsSet() || OldDefault.GetValue() != InComputedChannel.DefaultValue;
+
+			if (!bKeysChanged && !bDefaultChanged)
+			{
+				OutReimportStats.UnchangedChannels += 1;
+				continue;
+			}
+
+			Sections[i]->Modify();
+			OutReimportStats.ChangedChannels += 1;
+
+			if (bDefaultChanged)
+			{
+				Channel.SetDefault(InComputedChannel.DefaultValue);
+			}
+
+			if (bKeysChanged)
+			{
+				TArray<FFrameNumber> Times;
+				TArray<FMovieSceneValue> Values;
+				Times.Reserve(NewTimes.Num());
+				Values.Reserve(NewTimes.Num());
+
+				Times.Append(OldTimes.GetData(), PrefixCount);
+				Values.Append(OldValues.GetData(), PrefixCount);
+				Times.Append(NewTimes.GetData() + PrefixCount, NewTimes.Num() - PrefixCount - SuffixCount);
+				Values.Append(NewValues.GetData() + PrefixCount, NewTimes.Num() - PrefixCount - SuffixCount);
+				Times.Append(OldTimes.GetData() + OldTimes.Num() - SuffixCount, SuffixCount);
+				Values.Append(OldValues.GetData() + OldValues.Num() - SuffixCount, SuffixCount);
+
+				OutReimportStats.RewrittenKeys += NewTimes.Num() - PrefixCount - SuffixCount;
+
+				Channel.Set(MoveTemp(Times), MoveTemp(Values));
+
+				if (InComputedChannel.bAutoSetTangents)
+				{
+					Channel.AutoSetTangents();
+				}
+			}
+		}
+	}
+
 	template<typename MovieSceneChannel>
-	static void ImportCameraSingleChannel(
+	static void CommitComputedChannel(
+		const TVmdComputedChannel<MovieSceneChannel>& InComputedChannel,
+		TArray<MovieSceneChannel*>& Channels
+	)
+	{
+		check(InComputedChannel.CameraKeys.Num() == 0 || InComputedChannel.CameraKeys.Num() == Channels.Num());
+
+		for (PTRINT i = 0; i < Channels.Num(); ++i)
+		{
+			Channels[i]->SetDefault(InComputedChannel.DefaultValue);
+
+			if (!InComputedChannel.CameraKeys.IsValidIndex(i))
+			{
+				continue;
+			}
+
+			PopulateChannel(*Channels[i], InComputedChannel.CameraKeys[i]);
+
+			if (InComputedChannel.bAutoSetTangents)
+			{
+				Channels[i]->AutoSetTangents();
+			}
+		}
+	}
+
+	/**
+	 * Replace the lossless keep mask of a channel with one that stays within the tolerance of its unit
+	 *
+	 * @return largest error of the reduced curve
+	 */
+	template<typename ChannelDescriptor>
+	static double ReduceKeysWithinTolerance(
 		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		const uint64* PinnedMask,
+		const FVmdCameraImportParams& Params,
+		TVmdScratchArray<double>& ScratchValues,
+		uint64* OutKeepMask
+	)
+	{
+		constexpr EVmdCameraUnitMapping Mapping = ChannelDescriptor::Mapping;
+
+		// errors are measured on the sequencer curve, so the values are compared after the unit mapping
+		ScratchValues.SetNumUninitialized(CameraKeyFrames.Num());
+		for (int32 i = 0; i < CameraKeyFrames.Num(); ++i)
+		{
+			ScratchValues[i] = MapCameraValue<Mapping>(ChannelDescriptor::GetValue(CameraKeyFrames[i]), Params);
+		}
+
+		double Tolerance;
+		if constexpr (Mapping == EVmdCameraUnitMapping::FocalLength)
+		{
+			Tolerance = Params.FocalLengthTolerance;
+		}
+		else if constexpr (Mapping == EVmdCameraUnitMapping::UniformScale)
+		{
+			Tolerance = Params.PositionTolerance;
+		}
+		else
+		{
+			Tolerance = Params.AngleTolerance;
+		}
+
+		return VmdCore::ComputeToleranceKeepMask(
+			CameraKeyFrames.GetData(),
+			ScratchValues.GetData(),
+			CameraKeyFrames.Num(),
+			ChannelDescriptor::FSourceDescriptor::TangentAccessIndices,
+			PinnedMask,
+			Tolerance,
+			OutKeepMask);
+	}
+
+	// ChannelDescriptor must be a TVmdCameraChannelDescriptor
+	template<typename ChannelDescriptor>
+	static TVmdComputedChannel<typename ChannelDescriptor::MovieSceneChannel> ComputeCameraSingleChannel(
+		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		const uint64* KeepMask,
+		const uint64* CutMask,
 		const TArray<TRange<uint32>>& InCameraCuts,
-		TArray<MovieSceneChannel*>& Channels,
-		const FFrameRate SampleRate,
-		const FFrameRate FrameRate,
-		const ECameraCutImportType CameraCutImportType,
-		const FTangentAccessIndices TangentAccessIndices,
-		const TFunction<typename MovieSceneChannel::CurveValueType(const FVmdObject::FCameraKeyFrame&)> GetValueFunc,
-		const TFunction<typename MovieSceneChannel::CurveValueType(const typename MovieSceneChannel::CurveValueType)> MapFunc
+		const FVmdCameraImportParams& Params
 	)
 	{
+		using MovieSceneChannel = typename ChannelDescriptor::MovieSceneChannel;
 		using T = typename MovieSceneChannel::CurveValueType;
 
+		constexpr FTangentAccessIndices TangentAccessIndices = ChannelDescriptor::FSourceDescriptor::TangentAccessIndices;
+		constexpr EVmdCameraUnitMapping Mapping = ChannelDescriptor::Mapping;
+
+		const int32 ChannelCount = Params.CameraCount;
+		const FFrameRate SampleRate = Params.SampleRate;
+		const FFrameRate FrameRate = Params.FrameRate;
+		const ECameraCutImportType CameraCutImportType = Params.CameraCutImportType;
+
+		TVmdComputedChannel<MovieSceneChannel> ComputedChannel;
+
 		if (CameraKeyFrames.Num() == 0)
 		{
-			return;
+			ComputedChannel.DefaultValue = T();
+			return ComputedChannel;
 		}
 
 		const FFrameNumber OneSampleFrame = (FrameRate / SampleRate).AsFrameNumber(1);
 		const int32 FrameRatio = static_cast<int32>(FrameRate.AsDecimal() / 30.f);
 
+		ComputedChannel.DefaultValue = MapCameraValue<Mapping>(ChannelDescriptor::GetValue(CameraKeyFrames[0]), Params);
+
+		// keys kept by the reducer, indices into the shared key frames
+		TVmdScratchArray<int32> KeptIndices;
+		KeptIndices.Reserve(VmdCore::CountKeptKeys(KeepMask, CameraKeyFrames.Num()));
+		VmdCore::ForEachKeptKey(KeepMask, CameraKeyFrames.Num(), [&KeptIndices](const int32 Index)
 		{
-			const FVmdObject::FCameraKeyFrame& FirstCameraKeyFrame = CameraKeyFrames[0];
-			for (MovieSceneChannel* Channel : Channels)
-			{
-				Channel->SetDefault(MapFunc(GetValueFunc(FirstCameraKeyFrame)));
-			}
-		}
+			KeptIndices.Add(Index);
+		});
 
-		const TArray<FVmdObject::FCameraKeyFrame> ReducedKeys = ReduceKeys<T>(
-			CameraKeyFrames,
-			[&GetValueFunc](const TArray<FVmdObject::FCameraKeyFrame>& KeyFrames, const PTRINT Index)
-			{
-				return GetValueFunc(KeyFrames[Index]);
-			});
+		TVmdScratchArray<TComputedKey<T>> TimeComputedKeys;
 
-		TArray<TComputedKey<T>> TimeComputedKeys;
+		TimeComputedKeys.Reserve(KeptIndices.Num());
 
-		for (PTRINT i = 0; i < ReducedKeys.Num(); ++i)
+		for (PTRINT i = 0; i < KeptIndices.Num(); ++i)
 		{
 			// ReSharper disable once CppUseStructuredBinding
-			const FVmdObject::FCameraKeyFrame& CurrentKeyFrame = ReducedKeys[i];
+			const FVmdObject::FCameraKeyFrame& CurrentKeyFrame = CameraKeyFrames[KeptIndices[i]];
+
+			// a channel steps at a cut where both keys of the cut are kept, a channel that holds its value through the cut has no step
+			const bool bStartsCut = (i + 1) < KeptIndices.Num() && KeptIndices[i + 1] == KeptIndices[i] + 1 && VmdCore::IsKept(CutMask, KeptIndices[i + 1]);
+			const bool bEndsCut = 1 <= i && KeptIndices[i] == KeptIndices[i - 1] + 1 && VmdCore::IsKept(CutMask, KeptIndices[i]);
 
 			// ReSharper disable once CppTooWideScopeInitStatement
-			const FVmdObject::FCameraKeyFrame* NextKeyFrame = (i + 1) < ReducedKeys.Num()
-				? &ReducedKeys[i + 1]
+			const FVmdObject::FCameraKeyFrame* NextKeyFrame = (i + 1) < KeptIndices.Num()
+				? &CameraKeyFrames[KeptIndices[i + 1]]
 				: nullptr;
 
-			const T Value = MapFunc(GetValueFunc(CurrentKeyFrame));
+			const T Value = MapCameraValue<Mapping>(ChannelDescriptor::GetValue(CurrentKeyFrame), Params);
 
-			const float ArriveTangentX = static_cast<float>(CurrentKeyFrame.Interpolation[TangentAccessIndices.ArriveTangentX]) / 127.0f;
-			const float ArriveTangentY = static_cast<float>(CurrentKeyFrame.Interpolation[TangentAccessIndices.ArriveTangentY]) / 127.0f;
+			const float ArriveTangentX = VmdCore::DecodeInterpolationFactor(CurrentKeyFrame.Interpolation[TangentAccessIndices.ArriveTangentX]);
+			const float ArriveTangentY = VmdCore::DecodeInterpolationFactor(CurrentKeyFrame.Interpolation[TangentAccessIndices.ArriveTangentY]);
 			const float LeaveTangentX = NextKeyFrame != nullptr
-				? static_cast<float>(NextKeyFrame->Interpolation[TangentAccessIndices.LeaveTangentX]) / 127.0f
+				? VmdCore::DecodeInterpolationFactor(NextKeyFrame->Interpolation[TangentAccessIndices.LeaveTangentX])
 				: 0.0f;
 			const float LeaveTangentY = NextKeyFrame != nullptr
-				? static_cast<float>(NextKeyFrame->Interpolation[TangentAccessIndices.LeaveTangentY]) / 127.0f
+				? VmdCore::DecodeInterpolationFactor(NextKeyFrame->Interpolation[TangentAccessIndices.LeaveTangentY])
 				: 0.0f;
 
 			TComputedKey<T> ComputedKey;
@@ -275,16 +896,9 @@ private:
 				ComputedKey.LeaveTangent = FVector2D(LeaveTangentX, LeaveTangentY);
 			}
 
-			if (CameraCutImportType != ECameraCutImportType::ImportAsIs &&
-				NextKeyFrame != nullptr && NextKeyFrame->FrameNumber - CurrentKeyFrame.FrameNumber <= 1 && GetValueFunc(*NextKeyFrame) != GetValueFunc(CurrentKeyFrame)
-			)
+			if (CameraCutImportType != ECameraCutImportType::ImportAsIs && bStartsCut)
 			{
-				// ReSharper disable once CppTooWideScopeInitStatement
-				const FVmdObject::FCameraKeyFrame* PreviousKeyFrame = 1 <= i
-					? &ReducedKeys[i - 1]
-					: nullptr;
-
-				if (PreviousKeyFrame != nullptr && CurrentKeyFrame.FrameNumber - PreviousKeyFrame->FrameNumber <= 1 && GetValueFunc(CurrentKeyFrame) != GetValueFunc(*PreviousKeyFrame))
+				if (bEndsCut)
 				{
 					ComputedKey.Time = static_cast<int32>(CurrentKeyFrame.FrameNumber) * FrameRatio;
 
@@ -296,7 +910,7 @@ private:
 						CameraCutImportType == ECameraCutImportType::OneFrameIntervalWithConstantKey)
 					{
 						// if use multiple camera, ConstantKey is not required
-						ComputedKey.InterpMode = Channels.Num() == 1
+						ComputedKey.InterpMode = ChannelCount == 1
 							? RCIM_Constant
 							: RCIM_Cubic;
 					}
@@ -326,29 +940,91 @@ private:
 				ComputedKey.InterpMode = RCIM_Cubic;
 			}
 
-			TimeComputedKeys.Push(ComputedKey);
+			TimeComputedKeys.Add(ComputedKey);
 		}
 
-		ImportComputedKeysToChannel<MovieSceneChannel>(
+		DistributeComputedKeys<MovieSceneChannel>(
 			TimeComputedKeys,
 			InCameraCuts,
-			Channels,
-			FrameRate);
+			ChannelCount,
+			FrameRate,
+			ComputedChannel);
+
+		return ComputedChannel;
+	}
+
+	/**
+	 * One key per sample of the evaluated MMD curves
+	 *
+	 * Range r covers samples RangeStarts[r] .. RangeStarts[r + 1] - 1 and goes to camera r % CameraCount.
+	 * The last key of every range is constant, so camera cuts stay hard steps.
+	 */
+	template<typename ChannelDescriptor>
+	static TVmdComputedChannel<typename ChannelDescriptor::MovieSceneChannel> BakeCameraSingleChannel(
+		const TArray<FVmdObject::FCameraKeyFrame>& CameraKeyFrames,
+		const TVmdScratchArray<float>& SampleValues,
+		const TVmdScratchArray<FFrameNumber>& SampleTimes,
+		const TVmdScratchArray<int32>& RangeStarts,
+		const FVmdCameraImportParams& Params
+	)
+	{
+		using MovieSceneChannel = typename ChannelDescriptor::MovieSceneChannel;
+		using T = typename MovieSceneChannel::CurveValueType;
+		using FMovieSceneValue = typename MovieSceneChannel::ChannelValueType;
+
+		constexpr EVmdCameraUnitMapping Mapping = ChannelDescriptor::Mapping;
+
+		TVmdComputedChannel<MovieSceneChannel> ComputedChannel;
+		ComputedChannel.DefaultValue = MapCameraValue<Mapping>(ChannelDescriptor::GetValue(CameraKeyFrames[0]), Params);
+		ComputedChannel.CameraKeys.SetNum(Params.CameraCount);
+		ComputedChannel.bAutoSetTangents = Params.CurveImportType == ECurveImportType::BakeAuto;
+
+		const float* Values = SampleValues.GetData() + static_cast<int32>(ChannelDescriptor::Source) * SampleTimes.Num();
+		const ERichCurveInterpMode InterpMode = Params.CurveImportType == ECurveImportType::BakeLinear
+			? RCIM_Linear
+			: RCIM_Cubic;
+
+		for (int32 Range = 0; Range + 1 < RangeStarts.Num(); ++Range)
+		{
+			TArray<TPair<FFrameNumber, FMovieSceneValue>>& Keys = ComputedChannel.CameraKeys[Range % Params.CameraCount];
+			Keys.Reserve(Keys.Num() + RangeStarts[Range + 1] - RangeStarts[Range]);
+
+			for (int32 i = RangeStarts[Range]; i < RangeStarts[Range + 1]; ++i)
+			{
+				FMovieSceneValue MovieSceneValueInstance;
+				{
+					MovieSceneValueInstance.Value = MapCameraValue<Mapping>(static_cast<T>(Values[i]), Params);
+					MovieSceneValueInstance.InterpMode = i + 1 == RangeStarts[Range + 1]
+						? RCIM_Constant
+						: InterpMode;
+					MovieSceneValueInstance.TangentMode = RCTM_Auto;
+				}
+
+				Keys.Add({ SampleTimes[i], MovieSceneValueInstance });
+			}
+		}
+
+		return ComputedChannel;
 	}
 
 	template<typename MovieSceneChannel>
-	static void ImportComputedKeysToChannel(
-		TArray<TComputedKey<typename MovieSceneChannel::CurveValueType>>& TimeComputedKeys,
+	static void DistributeComputedKeys(
+		const TVmdScratchArray<TComputedKey<typename MovieSceneChannel::CurveValueType>>& TimeComputedKeys,
 		const TArray<TRange<uint32>>& InCameraCuts,
-		TArray<MovieSceneChannel*>& Channels,
-		const FFrameRate FrameRate
+		const int32 ChannelCount,
+		const FFrameRate FrameRate,
+		TVmdComputedChannel<MovieSceneChannel>& OutComputedChannel
 	)
 	{
 		using T = typename MovieSceneChannel::CurveValueType;
 		using FMovieSceneValue = typename MovieSceneChannel::ChannelValueType;
 
-		TArray<TPair<FFrameNumber, FMovieSceneValue>> Keys;
-		
+		TArray<TArray<TPair<FFrameNumber, FMovieSceneValue>>>& ChannelKeys = OutComputedChannel.CameraKeys;
+		ChannelKeys.SetNum(ChannelCount);
+
+		TVmdScratchArray<TPair<FFrameNumber, FMovieSceneValue>> Keys;
+		Keys.Reserve(TimeComputedKeys.Num());
+
 		for (PTRINT i = 0; i < TimeComputedKeys.Num(); ++i)
 		{
 			const TComputedKey<T>& CurrentKey = TimeComputedKeys[i];
@@ -366,53 +1042,37 @@ private:
 			{
 				const double DecimalFrameRate = FrameRate.AsDecimal();
 
-				FVector2D ArriveTangentUniform;
-				if (PreviousKey != nullptr)
-				{
-					ArriveTangentUniform = FVector2D(
-						(CurrentKey.Time.Value - PreviousKey->Time.Value) / DecimalFrameRate,
-						CurrentKey.Value - PreviousKey->Value);
-				}
-				else
-				{
-					ArriveTangentUniform = FVector2D(1.0f / DecimalFrameRate, 0.0f);
-				}
-
-				FVector2D LeaveTangentUniform;
-				if (NextKey != nullptr)
-				{
-					LeaveTangentUniform = FVector2D(
-						(NextKey->Time.Value - CurrentKey.Time.Value) / DecimalFrameRate,
-						NextKey->Value - CurrentKey.Value);
-				}
-				else
-				{
-					LeaveTangentUniform = FVector2D(1.0f / DecimalFrameRate, 0.0f);
-				}
-
-				const FVector2D ArriveTangent = CurrentKey.ArriveTangent * ArriveTangentUniform;
-				const FVector2D LeaveTangent = CurrentKey.LeaveTangent * LeaveTangentUniform;
-
-				if (ArriveTangent.X == 0.0f)
-				{
-				    Tangent.ArriveTangent = ArriveTangent.Y < 0 ? -1.0f : 1.0f;
-				}
-				else
-				{
-					Tangent.ArriveTangent = ArriveTangent.Y / (ArriveTangent.X * DecimalFrameRate);
-				}
-
-				if (LeaveTangent.X == 0.0f)
-				{
-					Tangent.LeaveTangent = LeaveTangent.Y < 0 ? -1.0f : 1.0f;
-				}
-				else
-				{
-					Tangent.LeaveTangent = LeaveTangent.Y / (LeaveTangent.X * DecimalFrameRate);
-				}
-
-				Tangent.ArriveTangentWeight = ArriveTangent.Length();
-				Tangent.LeaveTangentWeight = LeaveTangent.Length();
+				// neighbour distance, one frame with no value change at the ends
+				const double ArriveDeltaSeconds = PreviousKey != nullptr
+					? (CurrentKey.Time.Value - PreviousKey->Time.Value) / DecimalFrameRate
+					: 1.0f / DecimalFrameRate;
+				const double ArriveDeltaValue = PreviousKey != nullptr
+					? CurrentKey.Value - PreviousKey->Value
+					: 0.0f;
+				const double LeaveDeltaSeconds = NextKey != nullptr
+					? (NextKey->Time.Value - CurrentKey.Time.Value) / DecimalFrameRate
+					: 1.0f / DecimalFrameRate;
+				const double LeaveDeltaValue = NextKey != nullptr
+					? NextKey->Value - CurrentKey.Value
+					: 0.0f;
+
+				const VmdCore::FWeightedTangent ArriveTangent = VmdCore::ComputeWeightedTangent(
+					CurrentKey.ArriveTangent.X,
+					CurrentKey.ArriveTangent.Y,
+					ArriveDeltaSeconds,
+					ArriveDeltaValue,
+					DecimalFrameRate);
+				const VmdCore::FWeightedTangent LeaveTangent = VmdCore::ComputeWeightedTangent(
+					CurrentKey.LeaveTangent.X,
+					CurrentKey.LeaveTangent.Y,
+					LeaveDeltaSeconds,
+					LeaveDeltaValue,
+					DecimalFrameRate);
+
+				Tangent.ArriveTangent = ArriveTangent.Tangent;
+				Tangent.LeaveTangent = LeaveTangent.Tangent;
+				Tangent.ArriveTangentWeight = ArriveTangent.Weight;
+				Tangent.LeaveTangentWeight = LeaveTangent.Weight;
 			}
 
 			FMovieSceneValue MovieSceneValueInstance;
@@ -428,6 +1088,37 @@ private:
 
 		const int32 FrameRatio = static_cast<int32>(FrameRate.AsDecimal() / 30.f);
 
+		// size the camera channels up front, keys of a cut range go to one camera and every cut adds a key on both sides
+		{
+			TVmdScratchArray<int32> CameraKeyCounts;
+			CameraKeyCounts.SetNumZeroed(ChannelCount);
+
+			int32 CameraCutIndex = 0;
+			for (const TPair<FFrameNumber, FMovieSceneValue>& Key : Keys)
+			{
+				while (CameraCutIndex < InCameraCuts.Num() && static_cast<int32>(InCameraCuts[CameraCutIndex].GetUpperBoundValue() * FrameRatio) <= Key.Key)
+				{
+					CameraCutIndex += 1;
+				}
+				if (CameraCutIndex == InCameraCuts.Num())
+				{
+					break;
+				}
+				CameraKeyCounts[CameraCutIndex % ChannelCount] += 1;
+			}
+
+			for (int32 i = 0; i < InCameraCuts.Num(); ++i)
+			{
+				CameraKeyCounts[i % ChannelCount] += 1;
+				CameraKeyCounts[(i + 1) % ChannelCount] += 1;
+			}
+
+			for (int32 i = 0; i < ChannelCount; ++i)
+			{
+				ChannelKeys[i].Reserve(CameraKeyCounts[i] + 1);
+			}
+		}
+
 		PTRINT CurrentCameraCutIndex = 0;
 		for (PTRINT i = 0; i < Keys.Num(); ++i)
 		{
@@ -441,8 +1132,8 @@ private:
 
 				bIsFirstFrame = true;
 
-				TMovieSceneChannelData<FMovieSceneValue> PreviousChannelData = Channels[(CurrentCameraCutIndex - 1) % Channels.Num()]->GetData();
-				TMovieSceneChannelData<FMovieSceneValue> CurrentChannelData = Channels[CurrentCameraCutIndex % Channels.Num()]->GetData();
+				TArray<TPair<FFrameNumber, FMovieSceneValue>>& PreviousChannelKeys = ChannelKeys[(CurrentCameraCutIndex - 1) % ChannelCount];
+				TArray<TPair<FFrameNumber, FMovieSceneValue>>& CurrentChannelKeys = ChannelKeys[CurrentCameraCutIndex % ChannelCount];
 				const TRange<uint32>& PreviousCameraCut = InCameraCuts[CurrentCameraCutIndex - 1];
 
 				const TPair<FFrameNumber, FMovieSceneValue>& PreviousKey = 0 <= i - 1
@@ -466,11 +1157,11 @@ private:
 				{
 					if (CurrentKey.Key != CurrentCameraCutStartFrameNumber)
 					{
-						CurrentChannelData.AddKey(CurrentCameraCutStartFrameNumber, PreviousZeroTangentValue);
+						CurrentChannelKeys.Add({ CurrentCameraCutStartFrameNumber, PreviousZeroTangentValue });
 					}
 				}
 
-				PreviousChannelData.AddKey(CurrentCameraCutStartFrameNumber, PreviousZeroTangentValue);
+				PreviousChannelKeys.Add({ CurrentCameraCutStartFrameNumber, PreviousZeroTangentValue });
 
 				if (CurrentCameraCutIndex == InCameraCuts.Num())
 				{
@@ -526,65 +1217,25 @@ private:
 				}
 			}
 
-			TMovieSceneChannelData<FMovieSceneValue> ChannelData = Channels[CurrentCameraCutIndex % Channels.Num()]->GetData();
-			ChannelData.AddKey(CurrentKey.Key, TangentValue);
+			ChannelKeys[CurrentCameraCutIndex % ChannelCount].Add({ CurrentKey.Key, TangentValue });
 		}
 
 		const TPair<FFrameNumber, FMovieSceneValue>& LastKey = Keys.Last();
 
-		for (PTRINT i = 0; i < Channels.Num() - 1; ++i)
+		for (PTRINT i = 0; i < ChannelCount - 1; ++i)
 		{
 			CurrentCameraCutIndex += 1;
-			TMovieSceneChannelData<FMovieSceneValue> ChannelData = Channels[CurrentCameraCutIndex % Channels.Num()]->GetData();
-			ChannelData.AddKey(LastKey.Key, LastKey.Value);
+			ChannelKeys[CurrentCameraCutIndex % ChannelCount].Add({ LastKey.Key, LastKey.Value });
 		}
 	}
 	
-	// T must be number
-	template<typename T>
-	static TArray<FVmdObject::FCameraKeyFrame> ReduceKeys(
-		const TArray<FVmdObject::FCameraKeyFrame>& InCameraKeyFrames,
-		const TFunction<T(const TArray<FVmdObject::FCameraKeyFrame>&, PTRINT)>& InGetValueFunc
-	)
-	{
-		TArray<FVmdObject::FCameraKeyFrame> Result;
-
-		Result.Push(InCameraKeyFrames[0]);
-
-		for (PTRINT i = 1; i < InCameraKeyFrames.Num() - 1; ++i)
-		{
-			const T PreviousValue = InGetValueFunc(InCameraKeyFrames, i - 1);
-			const T CurrentValue = InGetValueFunc(InCameraKeyFrames, i);
-			const T NextValue = InGetValueFunc(InCameraKeyFrames, i + 1);
-
-			if (PreviousValue == CurrentValue && CurrentValue == NextValue)
-			{
-				continue;
-			}
-
-			const FVmdObject::FCameraKeyFrame& Current = InCameraKeyFrames[i];
-			Result.Push(Current);
-		}
-
-		if (1 < InCameraKeyFrames.Num())
-		{
-			Result.Push(InCameraKeyFrames.Last());
-		}
-
-		return Result;
-	}
-
 private:
 	FString FilePath;
+	EVmdReadMode ReadMode = EVmdReadMode::Archive;
 	TUniquePtr<FArchive> FileReader;
-	
-	struct FTangentAccessIndices
-	{
-		PTRINT ArriveTangentX;
-		PTRINT ArriveTangentY;
-		PTRINT LeaveTangentX;
-		PTRINT LeaveTangentY;
-	};
+	TSharedPtr<FVmdMappedFile> MappedFile;
+	EVmdMapResult MapResult = EVmdMapResult::NotAttempted;
+	TOptional<FVmdSectionDirectory> SectionDirectory;
 
 	template<typename T>
 	struct TComputedKey
@@ -0,0 +1,72 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VMDImporter.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Memory mapped VMD file
+ *
+ * Every fixed size section is exposed as a view into the mapping, so nothing is copied until a caller materializes it.
+ * Views are only valid while this object is alive.
+ */
+class FVmdMappedFile
+{
+public:
+	~FVmdMappedFile();
+
+	/** @return mapped file, or nullptr if the file can't be mapped or is not a valid VMD file, OutResult tells which */
+	static TSharedPtr<FVmdMappedFile> Open(const FString& FilePath, EVmdMapResult& OutResult);
+
+	int64 GetFileSize() const;
+
+	/** whole mapped file */
+	TConstArrayView<uint8> GetBytes() const;
+
+	const FVmdSectionDirectory& GetSectionDirectory() const { return SectionDirectory; }
+
+	const FVmdObject::FHeader& GetHeader() const;
+
+	TConstArrayView<FVmdObject::FBoneKeyFrame> GetBoneKeyFrames() const { return BoneKeyFrames; }
+
+	TConstArrayView<FVmdObject::FMorphKeyFrame> GetMorphKeyFrames() const { return MorphKeyFrames; }
+
+	TConstArrayView<FVmdObject::FCameraKeyFrame> GetCameraKeyFrames() const { return CameraKeyFrames; }
+
+	TConstArrayView<FVmdObject::FLightKeyFrame> GetLightKeyFrames() const { return LightKeyFrames; }
+
+	TConstArrayView<FVmdObject::FSelfShadowKeyFrame> GetSelfShadowKeyFrames() const { return SelfShadowKeyFrames; }
+
+	uint32 GetPropertyKeyFrameCount() const { return SectionDirectory.PropertyKeyFrames.Count; }
+
+	/** property key frames are variable length(each one is followed by its ik states), so they are exposed as raw bytes */
+	TConstArrayView<uint8> GetPropertySection() const { return PropertySection; }
+
+	/** Copy a view into an owned array, use this only when the key frames have to be mutated or sorted */
+	template<typename T>
+	static TArray<T> Materialize(const TConstArrayView<T> View)
+	{
+		return TArray<T>(View.GetData(), View.Num());
+	}
+
+private:
+	FVmdMappedFile(TUniquePtr<IMappedFileHandle>&& InHandle, TUniquePtr<IMappedFileRegion>&& InRegion);
+
+	bool LocateSections();
+
+private:
+	TUniquePtr<IMappedFileHandle> Handle;
+	TUniquePtr<IMappedFileRegion> Region;
+
+	FVmdSectionDirectory SectionDirectory;
+	TConstArrayView<FVmdObject::FBoneKeyFrame> BoneKeyFrames;
+	TConstArrayView<FVmdObject::FMorphKeyFrame> MorphKeyFrames;
+	TConstArrayView<FVmdObject::FCameraKeyFrame> CameraKeyFrames;
+	TConstArrayView<FVmdObject::FLightKeyFrame> LightKeyFrames;
+	TConstArrayView<FVmdObject::FSelfShadowKeyFrame> SelfShadowKeyFrames;
+	TConstArrayView<uint8> PropertySection;
+};
@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Interned bone, morph or ik names of a VMD file
+ *
+ * Names are keyed by their raw Shift-JIS bytes up to the first NUL, so each distinct name is decoded once
+ * and key frames can be grouped by a uint16 id instead of comparing strings.
+ *
+ * FName compares case insensitively while ids are keyed on the exact bytes, so names that only differ in case
+ * get different ids but equal FNames. Group by id, not by FName.
+ */
+class FVmdNameTable
+{
+public:
+	static constexpr uint16 InvalidId = MAX_uint16;
+
+	// longest name field in the format, FVmdObject::FPropertyKeyFrame::FIkState::IkName
+	static constexpr int32 MaxFieldSize = 20;
+
+	/** @return id of the name, InvalidId if the table is full */
+	uint16 Intern(const uint8* InField, int32 InFieldSize);
+
+	/** Intern a name field of every key frame, OutIds[i] is the id of KeyFrames[i] */
+	template<typename T, int32 FieldSize>
+	void InternAll(const TArray<T>& KeyFrames, const uint8 (T::*InField)[FieldSize], TArray<uint16>& OutIds)
+	{
+		static_assert(FieldSize <= MaxFieldSize, "name field is longer than MaxFieldSize");
+
+		OutIds.SetNumUninitialized(KeyFrames.Num());
+		for (int32 i = 0; i < KeyFrames.Num(); ++i)
+		{
+			OutIds[i] = Intern(KeyFrames[i].*InField, FieldSize);
+		}
+	}
+
+	int32 Num() const { return Names.Num(); }
+
+	FName GetName(const uint16 Id) const { return Names.IsValidIndex(Id) ? Names[Id] : NAME_None; }
+
+	/** indexed by id */
+	const TArray<FName>& GetNames() const { return Names; }
+
+	void Reset();
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FKey
+	{
+		// zero padded after Length, so keys compare as a whole
+		uint8 Bytes[MaxFieldSize];
+		int32 Length;
+		uint32 Hash;
+
+		bool operator==(const FKey& Other) const
+		{
+			return Hash == Other.Hash && Length == Other.Length && FMemory::Memcmp(Bytes, Other.Bytes, MaxFieldSize) == 0;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return Key.Hash;
+		}
+	};
+
+	TMap<FKey, uint16> Ids;
+
+	TArray<FName> Names;
+
+	// the table full warning is logged once per table
+	bool bWarnedFull = false;
+};
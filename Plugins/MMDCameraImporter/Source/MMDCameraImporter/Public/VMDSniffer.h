@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VmdCore/VmdFormat.h"
+
+using EVmdFormatVersion = VmdCore::EFormatVersion;
+
+struct FVmdSniffResult
+{
+	FString FilePath;
+
+	int64 FileSize = 0;
+
+	EVmdFormatVersion Version = EVmdFormatVersion::Unknown;
+
+	FString ModelName;
+
+	// false if the file ends before the camera section
+	bool bHasCameraSection = false;
+
+	uint32 CameraKeyFrameCount = 0;
+
+	bool IsCameraMotion() const
+	{
+		return bHasCameraSection && CameraKeyFrameCount != 0;
+	}
+};
+
+/**
+ * Classifies VMD files from their first few hundred bytes, without scanning or parsing them
+ */
+class FVmdSniffer
+{
+public:
+	// enough for the header and section counts of camera motion, which has no bone or morph keys
+	static constexpr int64 PrefixSize = 256;
+
+	static FVmdSniffResult Sniff(const FString& FilePath);
+
+	/** Sniff every *.vmd file under the directory in parallel, results are sorted by path */
+	static TArray<FVmdSniffResult> ScanDirectory(const FString& Directory, bool bRecursive = true);
+};
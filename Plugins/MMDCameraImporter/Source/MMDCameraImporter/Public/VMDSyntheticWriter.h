@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Shape of a generated VMD file
+ */
+struct FVmdSyntheticSettings
+{
+	uint32 Seed = 0;
+
+	int32 BoneKeyFrameCount = 0;
+
+	int32 MorphKeyFrameCount = 0;
+
+	int32 CameraKeyFrameCount = 10000;
+
+	int32 LightKeyFrameCount = 0;
+
+	int32 SelfShadowKeyFrameCount = 0;
+
+	int32 PropertyKeyFrameCount = 0;
+
+	// ik states written after every property key frame
+	int32 IkStatesPerPropertyKeyFrame = 0;
+
+	// distinct bone, morph and ik names, key frames cycle through them
+	int32 BoneNameCount = 64;
+	int32 MorphNameCount = 32;
+	int32 IkNameCount = 8;
+
+	// probability that a camera key frame starts a camera cut, a key one frame after the previous one with different values
+	float CameraCutDensity = 0.05f;
+
+	// write key frames in random order, like files saved by some tools
+	bool bShuffleKeyFrames = false;
+};
+
+/**
+ * Deterministic VMD writer for benchmarks, the same settings always produce the same bytes
+ */
+class FVmdSyntheticWriter
+{
+public:
+	static TArray<uint8> Write(const FVmdSyntheticSettings& Settings);
+
+	static bool WriteToFile(const FVmdSyntheticSettings& Settings, const FString& FilePath);
+};
@@ -0,0 +1,207 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "VmdCore/VmdCameraMath.h"
+#include "VmdCore/VmdFormat.h"
+#include "VmdCore/VmdShiftJis.h"
+
+namespace
+{
+	using namespace VmdCore;
+
+	// keeps results alive so the measured loops aren't optimized away
+	volatile std::uint64_t GSink = 0;
+
+	/** Best of InRepeatCount runs of Run, in microseconds */
+	template<typename FuncType>
+	double Measure(const std::int32_t InRepeatCount, FuncType&& Run)
+	{
+		double Best = 0.0;
+		for (std::int32_t Repeat = 0; Repeat < InRepeatCount; ++Repeat)
+		{
+			const auto Begin = std::chrono::steady_clock::now();
+			Run();
+			const auto End = std::chrono::steady_clock::now();
+
+			const double Micros = std::chrono::duration<double, std::micro>(End - Begin).count();
+			Best = Repeat == 0 ? Micros : std::min(Best, Micros);
+		}
+		return Best;
+	}
+
+	void Report(const char* InName, const std::int32_t InCount, const double InMicros)
+	{
+		std::printf("%-32s %8d %12.1f us %10.2f ns/item\n", InName, InCount, InMicros, InMicros * 1000.0 / std::max(InCount, 1));
+	}
+
+	/** Camera motion as exported from MMD, one key per frame with runs of held values and the occasional cut */
+	std::vector<FVmdObject::FCameraKeyFrame> MakeCameraKeyFrames(const std::int32_t InCount)
+	{
+		std::mt19937 Random(1);
+		std::vector<FVmdObject::FCameraKeyFrame> KeyFrames(static_cast<std::size_t>(InCount));
+
+		FVmdObject::FCameraKeyFrame Current;
+		std::memset(&Current, 0, sizeof(Current));
+		Current.ViewAngle = 30;
+		for (std::int8_t& Interpolation : Current.Interpolation)
+		{
+			Interpolation = 20;
+		}
+
+		for (std::int32_t i = 0; i < InCount; ++i)
+		{
+			Current.FrameNumber = static_cast<std::uint32_t>(i);
+			if (Random() % 4 == 0)
+			{
+				Current.Distance += 0.1f;
+				Current.Position[Random() % 3] += 0.5f;
+				Current.Rotation[Random() % 3] += 0.01f;
+			}
+			if (Random() % 500 == 0)
+			{
+				Current.ViewAngle = 20 + Random() % 40;
+			}
+			KeyFrames[static_cast<std::size_t>(i)] = Current;
+		}
+
+		return KeyFrames;
+	}
+
+	void BenchScanSections(const std::int32_t InCount)
+	{
+		std::vector<std::uint8_t> Bytes(sizeof(FVmdObject::FHeader));
+		std::memcpy(Bytes.data(), GMagicV2, sizeof(GMagicV2) - 1);
+
+		const auto WriteCount = [&Bytes](const std::uint32_t InValue)
+		{
+			const std::uint8_t* Data = reinterpret_cast<const std::uint8_t*>(&InValue);
+			Bytes.insert(Bytes.end(), Data, Data + sizeof(InValue));
+		};
+
+		WriteCount(0);
+		WriteCount(0);
+		WriteCount(0);
+		WriteCount(0);
+		WriteCount(0);
+
+		// property key frames are the variable length part of the scan
+		WriteCount(static_cast<std::uint32_t>(InCount));
+		for (std::int32_t i = 0; i < InCount; ++i)
+		{
+			Bytes.insert(Bytes.end(), sizeof(FVmdObject::FPropertyKeyFrame), 0);
+			WriteCount(2);
+			Bytes.insert(Bytes.end(), 2 * sizeof(FVmdObject::FPropertyKeyFrame::FIkState), 0);
+		}
+
+		struct FIkRunArray
+		{
+			std::vector<FIkRun> Runs;
+
+			void Reserve(const std::int32_t InReserve) { Runs.reserve(static_cast<std::size_t>(InReserve)); }
+			void Add(const FIkRun& InRun) { Runs.push_back(InRun); }
+		};
+
+		const auto Read = [&Bytes](const std::int64_t InOffset, void* OutDest, const std::int64_t InSize)
+		{
+			std::memcpy(OutDest, Bytes.data() + InOffset, static_cast<std::size_t>(InSize));
+			return true;
+		};
+
+		const double Micros = Measure(20, [&]
+		{
+			FSectionLayout Layout;
+			FIkRunArray IkRuns;
+			ScanSections(static_cast<std::int64_t>(Bytes.size()), Read, Layout, IkRuns);
+			GSink = GSink + IkRuns.Runs.size();
+		});
+		Report("ScanSections", InCount, Micros);
+	}
+
+	void BenchCameraKernels(const std::int32_t InCount)
+	{
+		const std::vector<FVmdObject::FCameraKeyFrame> KeyFrames = MakeCameraKeyFrames(InCount);
+		std::vector<float> ChannelValues(static_cast<std::size_t>(GCameraChannelCount * InCount));
+		std::vector<std::uint64_t> KeepMasks(static_cast<std::size_t>(GCameraChannelCount * GetKeepMaskWordCount(InCount)));
+
+		Report("TransposeCameraKeyFrames", InCount, Measure(20, [&]
+		{
+			TransposeCameraKeyFrames(KeyFrames.data(), InCount, ChannelValues.data());
+			GSink = GSink + static_cast<std::uint64_t>(ChannelValues[0]);
+		}));
+
+		Report("DetectCameraCuts", InCount, Measure(20, [&]
+		{
+			std::uint64_t CutCount = 0;
+			DetectCameraCuts(KeyFrames.data(), ChannelValues.data(), InCount, FCameraCutThresholds(), [&CutCount](std::int32_t)
+			{
+				++CutCount;
+			});
+			GSink = GSink + CutCount;
+		}));
+
+		Report("IsCameraCut", InCount, Measure(20, [&]
+		{
+			std::uint64_t CutCount = 0;
+			for (std::int32_t i = 1; i < InCount; ++i)
+			{
+				CutCount += IsCameraCut(KeyFrames[static_cast<std::size_t>(i - 1)], KeyFrames[static_cast<std::size_t>(i)]) ? 1 : 0;
+			}
+			GSink = GSink + CutCount;
+		}));
+
+		Report("ComputeCameraKeepMasks", InCount, Measure(20, [&]
+		{
+			ComputeCameraKeepMasks(ChannelValues.data(), InCount, KeepMasks.data());
+			GSink = GSink + CountKeptKeys(KeepMasks.data(), InCount);
+		}));
+
+		Report("ComputeWeightedTangent", InCount, Measure(20, [&]
+		{
+			double Sum = 0.0;
+			for (std::int32_t i = 1; i < InCount; ++i)
+			{
+				const FWeightedTangent Tangent = ComputeWeightedTangent(20.0 / 127.0, 107.0 / 127.0, 1.0 / 30.0, ChannelValues[static_cast<std::size_t>(i)] - ChannelValues[static_cast<std::size_t>(i - 1)], 30.0);
+				Sum += Tangent.Tangent + Tangent.Weight;
+			}
+			GSink = GSink + static_cast<std::uint64_t>(Sum);
+		}));
+	}
+
+	void BenchDecodeShiftJis(const std::int32_t InCount)
+	{
+		// model and bone names, mostly two byte kana and kanji with some ascii
+		const std::uint8_t Name[] = { 0x83, 0x4A, 0x83, 0x81, 0x83, 0x89, 'L', 'e', 'f', 't', 0x88, 0x9F, 0x81, 0x40, 'a', 'r', 'm', '_', '0', '1' };
+
+		std::vector<std::uint8_t> Bytes;
+		Bytes.reserve(static_cast<std::size_t>(InCount) * sizeof(Name));
+		for (std::int32_t i = 0; i < InCount; ++i)
+		{
+			Bytes.insert(Bytes.end(), Name, Name + sizeof(Name));
+		}
+		std::vector<char16_t> Decoded(Bytes.size());
+
+		Report("DecodeShiftJis", static_cast<std::int32_t>(Bytes.size()), Measure(20, [&]
+		{
+			GSink = GSink + static_cast<std::uint64_t>(DecodeShiftJis(Bytes.data(), static_cast<std::int32_t>(Bytes.size()), Decoded.data()));
+		}));
+	}
+}
+
+/** Key count from the first argument, 60000 keys (about half an hour at 30 fps) by default */
+int main(int ArgCount, char** Args)
+{
+	const std::int32_t Count = ArgCount < 2 ? 60000 : std::max(std::atoi(Args[1]), 1);
+
+	BenchScanSections(Count);
+	BenchCameraKernels(Count);
+	BenchDecodeShiftJis(Count);
+	return 0;
+}
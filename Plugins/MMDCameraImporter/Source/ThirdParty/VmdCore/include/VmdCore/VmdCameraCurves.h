@@ -0,0 +1,357 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "VmdCameraMath.h"
+#include "VmdFormat.h"
+#include "VmdSimd.h"
+
+namespace VmdCore
+{
+	/** Interpolation curves of a camera key frame, the three rotation channels share one */
+	inline constexpr std::int32_t GCameraCurveCount = 6;
+
+	// fixed newton or bisection steps of the batch solver, enough to reach float precision for any control points
+	inline constexpr std::int32_t GInterpolationSolveIterations = 12;
+
+	namespace Private
+	{
+		inline void EvaluateInterpolationCurveScalar(const float X1, const float Y1, const float X2, const float Y2, const float InTime, float& OutValue)
+		{
+			if (X1 == Y1 && X2 == Y2)
+			{
+				OutValue = InTime;
+				return;
+			}
+
+			float Low = 0.0f;
+			float High = 1.0f;
+			float S = InTime;
+			for (std::int32_t Iteration = 0; Iteration < GInterpolationSolveIterations; ++Iteration)
+			{
+				const float R = 1.0f - S;
+				const float Error = 3.0f * R * R * S * X1 + 3.0f * R * S * S * X2 + S * S * S - InTime;
+				if (std::abs(Error) <= 1e-7f)
+				{
+					break;
+				}
+
+				if (Error < 0.0f)
+				{
+					Low = S;
+				}
+				else
+				{
+					High = S;
+				}
+
+				const float Derivative = 3.0f * R * R * X1 + 6.0f * R * S * (X2 - X1) + 3.0f * S * S * (1.0f - X2);
+				const float Next = Derivative > 0.0f ? S - Error / Derivative : Low;
+				S = Low < Next && Next < High ? Next : (Low + High) * 0.5f;
+			}
+
+			const float R = 1.0f - S;
+			OutValue = 3.0f * R * R * S * Y1 + 3.0f * R * S * S * Y2 + S * S * S;
+		}
+	}
+
+	/**
+	 * Batch version of EvaluateInterpolationCurve in single precision
+	 *
+	 * Sample i solves x(s) = InTimes[i] on the curve with control points (InX1[i], InY1[i]) and (InX2[i], InY2[i]) and writes y(s).
+	 * Four samples are solved at once with SSE2 or NEON, every lane runs the same bracketed newton iteration as the scalar tail.
+	 */
+	inline void EvaluateInterpolationCurves(
+		const float* InX1,
+		const float* InY1,
+		const float* InX2,
+		const float* InY2,
+		const float* InTimes,
+		const std::int32_t InCount,
+		float* OutValues
+	)
+	{
+		std::int32_t i = 0;
+
+#if VMDCORE_SSE2
+		const __m128 Zero = _mm_setzero_ps();
+		const __m128 One = _mm_set1_ps(1.0f);
+		const __m128 Half = _mm_set1_ps(0.5f);
+		const __m128 Three = _mm_set1_ps(3.0f);
+		const __m128 Six = _mm_set1_ps(6.0f);
+		const __m128 Epsilon = _mm_set1_ps(1e-7f);
+		const __m128 AbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+		const auto Select = [](const __m128 Mask, const __m128 A, const __m128 B)
+		{
+			return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B));
+		};
+
+		for (; i + 4 <= InCount; i += 4)
+		{
+			const __m128 X1 = _mm_loadu_ps(InX1 + i);
+			const __m128 Y1 = _mm_loadu_ps(InY1 + i);
+			const __m128 X2 = _mm_loadu_ps(InX2 + i);
+			const __m128 Y2 = _mm_loadu_ps(InY2 + i);
+			const __m128 Time = _mm_loadu_ps(InTimes + i);
+
+			__m128 Low = Zero;
+			__m128 High = One;
+			__m128 S = Time;
+			for (std::int32_t Iteration = 0; Iteration < GInterpolationSolveIterations; ++Iteration)
+			{
+				const __m128 R = _mm_sub_ps(One, S);
+				const __m128 ThreeRS = _mm_mul_ps(Three, _mm_mul_ps(R, S));
+				const __m128 Error = _mm_sub_ps(
+					_mm_add_ps(
+						_mm_mul_ps(ThreeRS, _mm_add_ps(_mm_mul_ps(R, X1), _mm_mul_ps(S, X2))),
+						_mm_mul_ps(S, _mm_mul_ps(S, S))),
+					Time);
+
+				// converged lanes keep their bracket and position, the loop ends once all four converged
+				const __m128 IsActive = _mm_cmpgt_ps(_mm_and_ps(Error, AbsMask), Epsilon);
+				if (_mm_movemask_ps(IsActive) == 0)
+				{
+					break;
+				}
+
+				const __m128 IsBelow = _mm_cmplt_ps(Error, Zero);
+				Low = Select(_mm_and_ps(IsActive, IsBelow), S, Low);
+				High = Select(_mm_andnot_ps(IsBelow, IsActive), S, High);
+
+				const __m128 Derivative = _mm_add_ps(
+					_mm_add_ps(
+						_mm_mul_ps(Three, _mm_mul_ps(_mm_mul_ps(R, R), X1)),
+						_mm_mul_ps(Six, _mm_mul_ps(_mm_mul_ps(R, S), _mm_sub_ps(X2, X1)))),
+					_mm_mul_ps(Three, _mm_mul_ps(_mm_mul_ps(S, S), _mm_sub_ps(One, X2))));
+
+				const __m128 HasDerivative = _mm_cmpgt_ps(Derivative, Zero);
+				const __m128 Next = _mm_sub_ps(S, _mm_div_ps(Error, Select(HasDerivative, Derivative, One)));
+				const __m128 IsNewton = _mm_and_ps(HasDerivative, _mm_and_ps(_mm_cmplt_ps(Low, Next), _mm_cmplt_ps(Next, High)));
+				const __m128 Stepped = Select(IsNewton, Next, _mm_mul_ps(_mm_add_ps(Low, High), Half));
+
+				S = Select(IsActive, Stepped, S);
+			}
+
+			const __m128 R = _mm_sub_ps(One, S);
+			const __m128 Value = _mm_add_ps(
+				_mm_mul_ps(_mm_mul_ps(Three, _mm_mul_ps(R, S)), _mm_add_ps(_mm_mul_ps(R, Y1), _mm_mul_ps(S, Y2))),
+				_mm_mul_ps(S, _mm_mul_ps(S, S)));
+
+			const __m128 IsLinear = _mm_and_ps(_mm_cmpeq_ps(X1, Y1), _mm_cmpeq_ps(X2, Y2));
+			_mm_storeu_ps(OutValues + i, Select(IsLinear, Time, Value));
+		}
+#elif VMDCORE_NEON
+		const float32x4_t Zero = vdupq_n_f32(0.0f);
+		const float32x4_t One = vdupq_n_f32(1.0f);
+		const float32x4_t Half = vdupq_n_f32(0.5f);
+		const float32x4_t Three = vdupq_n_f32(3.0f);
+		const float32x4_t Six = vdupq_n_f32(6.0f);
+		const float32x4_t Epsilon = vdupq_n_f32(1e-7f);
+
+		for (; i + 4 <= InCount; i += 4)
+		{
+			const float32x4_t X1 = vld1q_f32(InX1 + i);
+			const float32x4_t Y1 = vld1q_f32(InY1 + i);
+			const float32x4_t X2 = vld1q_f32(InX2 + i);
+			const float32x4_t Y2 = vld1q_f32(InY2 + i);
+			const float32x4_t Time = vld1q_f32(InTimes + i);
+
+			float32x4_t Low = Zero;
+			float32x4_t High = One;
+			float32x4_t S = Time;
+			for (std::int32_t Iteration = 0; Iteration < GInterpolationSolveIterations; ++Iteration)
+			{
+				const float32x4_t R = vsubq_f32(One, S);
+				const float32x4_t ThreeRS = vmulq_f32(Three, vmulq_f32(R, S));
+				const float32x4_t Error = vsubq_f32(
+					vaddq_f32(vmulq_f32(ThreeRS, vaddq_f32(vmulq_f32(R, X1), vmulq_f32(S, X2))), vmulq_f32(S, vmulq_f32(S, S))),
+					Time);
+
+				const uint32x4_t IsActive = vcgtq_f32(vabsq_f32(Error), Epsilon);
+				if (vmaxvq_u32(IsActive) == 0)
+				{
+					break;
+				}
+
+				const uint32x4_t IsBelow = vcltq_f32(Error, Zero);
+				Low = vbslq_f32(vandq_u32(IsActive, IsBelow), S, Low);
+				High = vbslq_f32(vbicq_u32(IsActive, IsBelow), S, High);
+
+				const float32x4_t Derivative = vaddq_f32(
+					vaddq_f32(
+						vmulq_f32(Three, vmulq_f32(vmulq_f32(R, R), X1)),
+						vmulq_f32(Six, vmulq_f32(vmulq_f32(R, S), vsubq_f32(X2, X1)))),
+					vmulq_f32(Three, vmulq_f32(vmulq_f32(S, S), vsubq_f32(One, X2))));
+
+				const uint32x4_t HasDerivative = vcgtq_f32(Derivative, Zero);
+				const float32x4_t Next = vsubq_f32(S, vdivq_f32(Error, vbslq_f32(HasDerivative, Derivative, One)));
+				const uint32x4_t IsNewton = vandq_u32(HasDerivative, vandq_u32(vcltq_f32(Low, Next), vcltq_f32(Next, High)));
+				const float32x4_t Stepped = vbslq_f32(IsNewton, Next, vmulq_f32(vaddq_f32(Low, High), Half));
+
+				S = vbslq_f32(IsActive, Stepped, S);
+			}
+
+			const float32x4_t R = vsubq_f32(One, S);
+			const float32x4_t Value = vaddq_f32(
+				vmulq_f32(vmulq_f32(Three, vmulq_f32(R, S)), vaddq_f32(vmulq_f32(R, Y1), vmulq_f32(S, Y2))),
+				vmulq_f32(S, vmulq_f32(S, S)));
+
+			const uint32x4_t IsLinear = vandq_u32(vceqq_f32(X1, Y1), vceqq_f32(X2, Y2));
+			vst1q_f32(OutValues + i, vbslq_f32(IsLinear, Time, Value));
+		}
+#endif
+
+		for (; i < InCount; ++i)
+		{
+			Private::EvaluateInterpolationCurveScalar(InX1[i], InY1[i], InX2[i], InY2[i], InTimes[i], OutValues[i]);
+		}
+	}
+
+	/** Floats of ScratchValues EvaluateCameraCurves needs for InFrameCount frames */
+	inline constexpr std::size_t GetCameraCurveScratchSize(const std::int32_t InFrameCount)
+	{
+		// control points, time and result of every curve
+		return static_cast<std::size_t>(6 * GCameraCurveCount) * static_cast<std::size_t>(InFrameCount);
+	}
+
+	namespace Private
+	{
+		// curves are stored in Interpolation as (x1, x2, y1, y2) quadruples in this order
+		template<ECameraChannel Channel>
+		inline constexpr std::int32_t GCameraChannelCurve =
+			static_cast<std::int32_t>(TCameraChannelDescriptor<Channel>::TangentAccessIndices.LeaveTangentX / 4);
+
+		template<ECameraChannel Channel>
+		void InterpolateCameraChannel(
+			const FVmdObject::FCameraKeyFrame* InKeys,
+			const std::int32_t* InSegments,
+			const float* InFactors,
+			const std::int32_t InFrameCount,
+			float* OutValues
+		)
+		{
+			const float* Factors = InFactors + GCameraChannelCurve<Channel> * InFrameCount;
+			float* Values = OutValues + static_cast<std::int32_t>(Channel) * InFrameCount;
+
+			for (std::int32_t i = 0; i < InFrameCount; ++i)
+			{
+				const float Begin = GetCameraChannelValue<Channel>(InKeys[InSegments[i]]);
+				const float End = GetCameraChannelValue<Channel>(InKeys[InSegments[i] + 1]);
+				Values[i] = Begin + (End - Begin) * Factors[i];
+			}
+		}
+	}
+
+	/**
+	 * Evaluate every camera channel at InFrameCount frames the way MMD does, GetFrame(Index) returns the frame of sample Index
+	 *
+	 * InKeys must be sorted by frame and the frames must not decrease, frames outside the keys hold the first or last key.
+	 * All six interpolation curves of all frames are solved in one EvaluateInterpolationCurves call.
+	 * ScratchValues holds GetCameraCurveScratchSize(InFrameCount) floats and ScratchSegments InFrameCount ints.
+	 * OutValues holds GCameraChannelCount * InFrameCount floats, channel c starts at c * InFrameCount.
+	 */
+	template<typename GetFrameFuncType>
+	void EvaluateCameraCurves(
+		const FVmdObject::FCameraKeyFrame* InKeys,
+		const std::int32_t InCount,
+		const std::int32_t InFrameCount,
+		GetFrameFuncType&& GetFrame,
+		float* ScratchValues,
+		std::int32_t* ScratchSegments,
+		float* OutValues
+	)
+	{
+		if (InCount == 0 || InFrameCount <= 0)
+		{
+			return;
+		}
+
+		const std::int32_t SampleCount = GCameraCurveCount * InFrameCount;
+		float* X1 = ScratchValues;
+		float* Y1 = X1 + SampleCount;
+		float* X2 = Y1 + SampleCount;
+		float* Y2 = X2 + SampleCount;
+		float* Times = Y2 + SampleCount;
+		float* Factors = Times + SampleCount;
+
+		// a single key is held at both ends of a zero length segment
+		const FVmdObject::FCameraKeyFrame* Keys = InKeys;
+		const FVmdObject::FCameraKeyFrame SingleKey[2] = { InKeys[0], InKeys[0] };
+		const std::int32_t Count = InCount == 1 ? 2 : InCount;
+		if (InCount == 1)
+		{
+			Keys = SingleKey;
+		}
+
+		std::int32_t Segment = 0;
+		for (std::int32_t i = 0; i < InFrameCount; ++i)
+		{
+			const double Frame = GetFrame(i);
+			while (Segment + 2 < Count && static_cast<double>(Keys[Segment + 1].FrameNumber) <= Frame)
+			{
+				++Segment;
+			}
+			ScratchSegments[i] = Segment;
+
+			const FVmdObject::FCameraKeyFrame& Begin = Keys[Segment];
+			const FVmdObject::FCameraKeyFrame& End = Keys[Segment + 1];
+			const double BeginFrame = static_cast<double>(Begin.FrameNumber);
+			const double Span = static_cast<double>(End.FrameNumber) - BeginFrame;
+
+			float Time = Span > 0.0 ? static_cast<float>((Frame - BeginFrame) / Span) : 1.0f;
+			Time = Time < 0.0f ? 0.0f : Time > 1.0f ? 1.0f : Time;
+
+			for (std::int32_t Curve = 0; Curve < GCameraCurveCount; ++Curve)
+			{
+				const std::int32_t Sample = Curve * InFrameCount + i;
+				const std::int8_t* Interpolation = End.Interpolation + Curve * 4;
+				X1[Sample] = DecodeInterpolationFactor(Interpolation[0]);
+				X2[Sample] = DecodeInterpolationFactor(Interpolation[1]);
+				Y1[Sample] = DecodeInterpolationFactor(Interpolation[2]);
+				Y2[Sample] = DecodeInterpolationFactor(Interpolation[3]);
+				Times[Sample] = Time;
+			}
+		}
+
+		EvaluateInterpolationCurves(X1, Y1, X2, Y2, Times, SampleCount, Factors);
+
+		Private::InterpolateCameraChannel<ECameraChannel::Distance>(Keys, ScratchSegments, Factors, InFrameCount, OutValues);
+		Private::InterpolateCameraChannel<ECameraChannel::PositionX>(Keys, ScratchSegments, Factors, InFrameCount, OutValues);
+		Private::InterpolateCameraChannel<ECameraChannel::PositionY>(Keys, ScratchSegments, Factors, InFrameCount, OutValues);
+		Private::InterpolateCameraChannel<ECameraChannel::PositionZ>(Keys, ScratchSegments, Factors, InFrameCount, OutValues);
+		Private::InterpolateCameraChannel<ECameraChannel::RotationX>(Keys, ScratchSegments, Factors, InFrameCount, OutValues);
+		Private::InterpolateCameraChannel<ECameraChannel::RotationY>(Keys, ScratchSegments, Factors, InFrameCount, OutValues);
+		Private::InterpolateCameraChannel<ECameraChannel::RotationZ>(Keys, ScratchSegments, Factors, InFrameCount, OutValues);
+		Private::InterpolateCameraChannel<ECameraChannel::ViewAngle>(Keys, ScratchSegments, Factors, InFrameCount, OutValues);
+	}
+
+	/** EvaluateCameraCurves at InFrameCount frames from InFirstFrame, InFrameStep apart, InFrameStep must be positive */
+	inline void EvaluateCameraCurves(
+		const FVmdObject::FCameraKeyFrame* InKeys,
+		const std::int32_t InCount,
+		const double InFirstFrame,
+		const double InFrameStep,
+		const std::int32_t InFrameCount,
+		float* ScratchValues,
+		std::int32_t* ScratchSegments,
+		float* OutValues
+	)
+	{
+		EvaluateCameraCurves(
+			InKeys,
+			InCount,
+			InFrameCount,
+			[InFirstFrame, InFrameStep](const std::int32_t Index)
+			{
+				return InFirstFrame + InFrameStep * Index;
+			},
+			ScratchValues,
+			ScratchSegments,
+			OutValues);
+	}
+}
@@ -0,0 +1,781 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "VmdFormat.h"
+#include "VmdSimd.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace VmdCore
+{
+	/**
+	 * Indices into FVmdObject::FCameraKeyFrame::Interpolation of a single channel
+	 */
+	struct FTangentAccessIndices
+	{
+		std::ptrdiff_t ArriveTangentX;
+		std::ptrdiff_t ArriveTangentY;
+		std::ptrdiff_t LeaveTangentX;
+		std::ptrdiff_t LeaveTangentY;
+	};
+
+	/** Interpolation bytes are bezier control points in 0 .. 127 */
+	inline float DecodeInterpolationFactor(const std::int8_t InValue)
+	{
+		return static_cast<float>(InValue) / 127.0f;
+	}
+
+	/**
+	 * When two neighbouring keys count as a camera cut, the defaults are the MMD convention
+	 *
+	 * Tolerances are the largest difference that still counts as unchanged in the unit of the key frame field, zero compares exactly.
+	 */
+	struct FCameraCutThresholds
+	{
+		// distance and position, MMD units
+		float PositionTolerance = 0.0f;
+
+		// rotation, radians
+		float AngleTolerance = 0.0f;
+
+		// view angle, degrees
+		float ViewAngleTolerance = 0.0f;
+
+		// largest distance in frames between the two keys of a cut
+		std::uint32_t MaxFrameGap = 1;
+	};
+
+	/** Same as Current != Previous for a zero tolerance, NaN is always changed */
+	inline bool IsChangedValue(const float Previous, const float Current, const float Tolerance)
+	{
+		return Current != Previous && !(std::abs(Current - Previous) <= Tolerance);
+	}
+
+	/**
+	 * A camera cut is a key at most MaxFrameGap frames after the previous one with different values
+	 *
+	 * Scalar reference of DetectCameraCuts, the view angle is compared as float like in the transposed key frames.
+	 */
+	inline bool IsCameraCut(
+		const FVmdObject::FCameraKeyFrame& PreviousFrame,
+		const FVmdObject::FCameraKeyFrame& CurrentFrame,
+		const FCameraCutThresholds& InThresholds = FCameraCutThresholds()
+	)
+	{
+		const float PositionTolerance = InThresholds.PositionTolerance;
+		const float AngleTolerance = InThresholds.AngleTolerance;
+
+		return (CurrentFrame.FrameNumber - PreviousFrame.FrameNumber) <= InThresholds.MaxFrameGap &&
+
+			(IsChangedValue(static_cast<float>(PreviousFrame.ViewAngle), static_cast<float>(CurrentFrame.ViewAngle), InThresholds.ViewAngleTolerance) ||
+				IsChangedValue(PreviousFrame.Distance, CurrentFrame.Distance, PositionTolerance) ||
+				IsChangedValue(PreviousFrame.Position[0], CurrentFrame.Position[0], PositionTolerance) ||
+				IsChangedValue(PreviousFrame.Position[1], CurrentFrame.Position[1], PositionTolerance) ||
+				IsChangedValue(PreviousFrame.Position[2], CurrentFrame.Position[2], PositionTolerance) ||
+				IsChangedValue(PreviousFrame.Rotation[0], CurrentFrame.Rotation[0], AngleTolerance) ||
+				IsChangedValue(PreviousFrame.Rotation[1], CurrentFrame.Rotation[1], AngleTolerance) ||
+				IsChangedValue(PreviousFrame.Rotation[2], CurrentFrame.Rotation[2], AngleTolerance));
+	}
+
+	/**
+	 * Frame ranges between camera cuts of sorted key frames
+	 *
+	 * InCutIndices are the keys that start a cut in ascending order, as found by DetectCameraCuts.
+	 * Emit(LowerBound, UpperBound) is called once per range in order, the last range ends one frame after the last key.
+	 */
+	template<typename EmitFuncType>
+	void ComputeCameraCutRanges(
+		const FVmdObject::FCameraKeyFrame* InCameraKeyFrames,
+		const std::int32_t InCount,
+		const std::int32_t* InCutIndices,
+		const std::int32_t InCutCount,
+		EmitFuncType&& Emit
+	)
+	{
+		if (InCount == 0)
+		{
+			return;
+		}
+
+		std::uint32_t RangeStart = InCameraKeyFrames[0].FrameNumber;
+
+		for (std::int32_t CutIndex = 0; CutIndex < InCutCount; ++CutIndex)
+		{
+			const std::uint32_t CutFrame = InCameraKeyFrames[InCutIndices[CutIndex]].FrameNumber;
+			Emit(RangeStart, CutFrame);
+			RangeStart = CutFrame;
+		}
+
+		Emit(RangeStart, InCameraKeyFrames[InCount - 1].FrameNumber + 1);
+	}
+
+	/**
+	 * Drop keys whose value equals both neighbours, the first and last key are always kept
+	 *
+	 * GetValue(Index) returns the channel value of a key, Emit(Index) is called for every kept key in order.
+	 */
+	template<typename GetValueFuncType, typename EmitFuncType>
+	void ReduceKeys(const std::int32_t InCount, GetValueFuncType&& GetValue, EmitFuncType&& Emit)
+	{
+		if (InCount == 0)
+		{
+			return;
+		}
+
+		Emit(0);
+
+		for (std::int32_t i = 1; i < InCount - 1; ++i)
+		{
+			const auto PreviousValue = GetValue(i - 1);
+			const auto CurrentValue = GetValue(i);
+			const auto NextValue = GetValue(i + 1);
+
+			if (PreviousValue == CurrentValue && CurrentValue == NextValue)
+			{
+				continue;
+			}
+
+			Emit(i);
+		}
+
+		if (1 < InCount)
+		{
+			Emit(InCount - 1);
+		}
+	}
+
+	/**
+	 * Camera channels in structure of arrays layout, values compare the same way as the key frame fields
+	 */
+	enum class ECameraChannel : std::uint8_t
+	{
+		Distance,
+		PositionX,
+		PositionY,
+		PositionZ,
+		RotationX,
+		RotationY,
+		RotationZ,
+		// uint32 in the file, exact as float for any real view angle
+		ViewAngle,
+	};
+
+	inline constexpr std::int32_t GCameraChannelCount = 8;
+
+	/**
+	 * Compile time layout of a camera channel in FVmdObject::FCameraKeyFrame
+	 *
+	 * FieldOffset is the byte offset of the value, the rotation channels share one interpolation curve.
+	 */
+	template<ECameraChannel Channel>
+	struct TCameraChannelDescriptor;
+
+	namespace Private
+	{
+		template<typename InValueType, std::size_t InFieldOffset, std::ptrdiff_t ArriveTangentX, std::ptrdiff_t ArriveTangentY, std::ptrdiff_t LeaveTangentX, std::ptrdiff_t LeaveTangentY>
+		struct TCameraChannelLayout
+		{
+			using ValueType = InValueType;
+
+			static constexpr std::size_t FieldOffset = InFieldOffset;
+
+			static constexpr FTangentAccessIndices TangentAccessIndices = { ArriveTangentX, ArriveTangentY, LeaveTangentX, LeaveTangentY };
+		};
+
+		inline constexpr std::size_t GPositionOffset = offsetof(FVmdObject::FCameraKeyFrame, Position);
+		inline constexpr std::size_t GRotationOffset = offsetof(FVmdObject::FCameraKeyFrame, Rotation);
+	}
+
+	template<>
+	struct TCameraChannelDescriptor<ECameraChannel::Distance> : Private::TCameraChannelLayout<float, offsetof(FVmdObject::FCameraKeyFrame, Distance), 17, 19, 16, 18> {};
+
+	template<>
+	struct TCameraChannelDescriptor<ECameraChannel::PositionX> : Private::TCameraChannelLayout<float, Private::GPositionOffset + 0 * sizeof(float), 1, 3, 0, 2> {};
+
+	template<>
+	struct TCameraChannelDescriptor<ECameraChannel::PositionY> : Private::TCameraChannelLayout<float, Private::GPositionOffset + 1 * sizeof(float), 5, 7, 4, 6> {};
+
+	template<>
+	struct TCameraChannelDescriptor<ECameraChannel::PositionZ> : Private::TCameraChannelLayout<float, Private::GPositionOffset + 2 * sizeof(float), 9, 11, 8, 10> {};
+
+	template<>
+	struct TCameraChannelDescriptor<ECameraChannel::RotationX> : Private::TCameraChannelLayout<float, Private::GRotationOffset + 0 * sizeof(float), 13, 15, 12, 14> {};
+
+	template<>
+	struct TCameraChannelDescriptor<ECameraChannel::RotationY> : Private::TCameraChannelLayout<float, Private::GRotationOffset + 1 * sizeof(float), 13, 15, 12, 14> {};
+
+	template<>
+	struct TCameraChannelDescriptor<ECameraChannel::RotationZ> : Private::TCameraChannelLayout<float, Private::GRotationOffset + 2 * sizeof(float), 13, 15, 12, 14> {};
+
+	template<>
+	struct TCameraChannelDescriptor<ECameraChannel::ViewAngle> : Private::TCameraChannelLayout<std::uint32_t, offsetof(FVmdObject::FCameraKeyFrame, ViewAngle), 21, 23, 20, 22> {};
+
+	/** Value of a channel as float, the same conversion TransposeCameraKeyFrames applies */
+	template<ECameraChannel Channel>
+	float GetCameraChannelValue(const FVmdObject::FCameraKeyFrame& InKeyFrame)
+	{
+		using FDescriptor = TCameraChannelDescriptor<Channel>;
+
+		// the record is packed, fields are not necessarily aligned
+		typename FDescriptor::ValueType Value;
+		std::memcpy(&Value, reinterpret_cast<const std::uint8_t*>(&InKeyFrame) + FDescriptor::FieldOffset, sizeof(Value));
+		return static_cast<float>(Value);
+	}
+
+	namespace Private
+	{
+		// Value must not be zero
+		inline std::int32_t CountTrailingZeros(const std::uint64_t Value)
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long Index;
+			_BitScanForward64(&Index, Value);
+			return static_cast<std::int32_t>(Index);
+#elif defined(__GNUC__) || defined(__clang__)
+			return __builtin_ctzll(Value);
+#else
+			std::int32_t Count = 0;
+			while (((Value >> Count) & 1) == 0)
+			{
+				++Count;
+			}
+			return Count;
+#endif
+		}
+	}
+
+	/** uint64 words of a keep mask for InCount keys */
+	inline constexpr std::int32_t GetKeepMaskWordCount(const std::int32_t InCount)
+	{
+		return (InCount + 63) / 64;
+	}
+
+	inline bool IsKept(const std::uint64_t* InKeepMask, const std::int32_t Index)
+	{
+		return (InKeepMask[Index >> 6] >> (Index & 63)) & 1;
+	}
+
+	/** Emit(Index) for every set bit below InCount, in order */
+	template<typename EmitFuncType>
+	void ForEachKeptKey(const std::uint64_t* InKeepMask, const std::int32_t InCount, EmitFuncType&& Emit)
+	{
+		const std::int32_t WordCount = GetKeepMaskWordCount(InCount);
+		for (std::int32_t WordIndex = 0; WordIndex < WordCount; ++WordIndex)
+		{
+			std::uint64_t Word = InKeepMask[WordIndex];
+			while (Word != 0)
+			{
+				const std::int32_t Index = WordIndex * 64 + Private::CountTrailingZeros(Word);
+				if (Index >= InCount)
+				{
+					return;
+				}
+				Emit(Index);
+
+				Word &= Word - 1;
+			}
+		}
+	}
+
+	inline void SetKept(std::uint64_t* InOutKeepMask, const std::int32_t Index)
+	{
+		InOutKeepMask[Index >> 6] |= std::uint64_t(1) << (Index & 63);
+	}
+
+	/** Number of set bits below InCount */
+	inline std::int32_t CountKeptKeys(const std::uint64_t* InKeepMask, const std::int32_t InCount)
+	{
+		std::int32_t Count = 0;
+		ForEachKeptKey(InKeepMask, InCount, [&Count](std::int32_t)
+		{
+			++Count;
+		});
+		return Count;
+	}
+
+	/**
+	 * Mask of the keys on either side of a camera cut, in a channel whose value steps at the cut
+	 *
+	 * InCutIndices are the keys that start a cut, as found by DetectCameraCuts. OutMask holds GetKeepMaskWordCount(InCount) words.
+	 * ComputeKeepMask keeps every key of the mask, a channel that holds its value through a cut gets no keys for it.
+	 */
+	inline void ComputeCameraCutKeyMask(const float* InValues, const std::int32_t* InCutIndices, const std::int32_t InCutCount, const std::int32_t InCount, std::uint64_t* OutMask)
+	{
+		const std::int32_t WordCount = GetKeepMaskWordCount(InCount);
+		for (std::int32_t WordIndex = 0; WordIndex < WordCount; ++WordIndex)
+		{
+			OutMask[WordIndex] = 0;
+		}
+
+		for (std::int32_t CutIndex = 0; CutIndex < InCutCount; ++CutIndex)
+		{
+			const std::int32_t Index = InCutIndices[CutIndex];
+			if (!(InValues[Index - 1] == InValues[Index]))
+			{
+				SetKept(OutMask, Index - 1);
+				SetKept(OutMask, Index);
+			}
+		}
+	}
+
+	/**
+	 * Transpose key frames into one contiguous float array per channel
+	 *
+	 * OutValues holds GCameraChannelCount * InCount floats, channel c starts at c * InCount.
+	 */
+	inline void TransposeCameraKeyFrames(const FVmdObject::FCameraKeyFrame* InCameraKeyFrames, const std::int32_t InCount, float* OutValues)
+	{
+		float* Distance = OutValues + static_cast<std::int32_t>(ECameraChannel::Distance) * InCount;
+		float* PositionX = OutValues + static_cast<std::int32_t>(ECameraChannel::PositionX) * InCount;
+		float* PositionY = OutValues + static_cast<std::int32_t>(ECameraChannel::PositionY) * InCount;
+		float* PositionZ = OutValues + static_cast<std::int32_t>(ECameraChannel::PositionZ) * InCount;
+		float* RotationX = OutValues + static_cast<std::int32_t>(ECameraChannel::RotationX) * InCount;
+		float* RotationY = OutValues + static_cast<std::int32_t>(ECameraChannel::RotationY) * InCount;
+		float* RotationZ = OutValues + static_cast<std::int32_t>(ECameraChannel::RotationZ) * InCount;
+		float* ViewAngle = OutValues + static_cast<std::int32_t>(ECameraChannel::ViewAngle) * InCount;
+
+		for (std::int32_t i = 0; i < InCount; ++i)
+		{
+			const FVmdObject::FCameraKeyFrame& KeyFrame = InCameraKeyFrames[i];
+			Distance[i] = KeyFrame.Distance;
+			PositionX[i] = KeyFrame.Position[0];
+			PositionY[i] = KeyFrame.Position[1];
+			PositionZ[i] = KeyFrame.Position[2];
+			RotationX[i] = KeyFrame.Rotation[0];
+			RotationY[i] = KeyFrame.Rotation[1];
+			RotationZ[i] = KeyFrame.Rotation[2];
+			ViewAngle[i] = static_cast<float>(KeyFrame.ViewAngle);
+		}
+	}
+
+	/** Tolerance of FCameraCutThresholds that applies to a channel */
+	inline float GetCameraCutTolerance(const FCameraCutThresholds& InThresholds, const std::int32_t InChannel)
+	{
+		switch (static_cast<ECameraChannel>(InChannel))
+		{
+		case ECameraChannel::RotationX:
+		case ECameraChannel::RotationY:
+		case ECameraChannel::RotationZ:
+			return InThresholds.AngleTolerance;
+		case ECameraChannel::ViewAngle:
+			return InThresholds.ViewAngleTolerance;
+		default:
+			return InThresholds.PositionTolerance;
+		}
+	}
+
+	/**
+	 * Find the camera cuts of sorted key frames in one pass over their transposition
+	 *
+	 * InChannelValues is the output of TransposeCameraKeyFrames. The frame gap is tested first, only groups of keys that are
+	 * close enough to a previous key compare their values, all eight channels at once with SSE2 or NEON.
+	 * Emit(Index) is called in ascending order for every key that starts a cut, the same keys IsCameraCut accepts.
+	 */
+	template<typename EmitFuncType>
+	void DetectCameraCuts(
+		const FVmdObject::FCameraKeyFrame* InCameraKeyFrames,
+		const float* InChannelValues,
+		const std::int32_t InCount,
+		const FCameraCutThresholds& InThresholds,
+		EmitFuncType&& Emit
+	)
+	{
+		const auto IsWithinFrameGap = [InCameraKeyFrames, &InThresholds](const std::int32_t Index)
+		{
+			return (InCameraKeyFrames[Index].FrameNumber - InCameraKeyFrames[Index - 1].FrameNumber) <= InThresholds.MaxFrameGap;
+		};
+
+		std::int32_t i = 1;
+
+#if VMDCORE_SSE2 || VMDCORE_NEON
+		for (; i + 4 <= InCount; i += 4)
+		{
+			std::uint32_t GapBits = 0;
+			for (std::int32_t Lane = 0; Lane < 4; ++Lane)
+			{
+				GapBits |= static_cast<std::uint32_t>(IsWithinFrameGap(i + Lane)) << Lane;
+			}
+			if (GapBits == 0)
+			{
+				continue;
+			}
+
+#if VMDCORE_SSE2
+			const __m128 AbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+			__m128 IsChanged = _mm_setzero_ps();
+			for (std::int32_t Channel = 0; Channel < GCameraChannelCount; ++Channel)
+			{
+				const __m128 Tolerance = _mm_set1_ps(GetCameraCutTolerance(InThresholds, Channel));
+				const float* Values = InChannelValues + Channel * InCount;
+				const __m128 Previous = _mm_loadu_ps(Values + i - 1);
+				const __m128 Current = _mm_loadu_ps(Values + i);
+				const __m128 Difference = _mm_and_ps(_mm_sub_ps(Current, Previous), AbsMask);
+
+				// not-less-equal is true for NaN, like IsChangedValue
+				IsChanged = _mm_or_ps(IsChanged, _mm_and_ps(_mm_cmpneq_ps(Current, Previous), _mm_cmpnle_ps(Difference, Tolerance)));
+			}
+			const std::uint32_t ChangedBits = static_cast<std::uint32_t>(_mm_movemask_ps(IsChanged));
+#else
+			const uint32x4_t LaneBits = { 1, 2, 4, 8 };
+
+			uint32x4_t IsChanged = vdupq_n_u32(0);
+			for (std::int32_t Channel = 0; Channel < GCameraChannelCount; ++Channel)
+			{
+				const float32x4_t Tolerance = vdupq_n_f32(GetCameraCutTolerance(InThresholds, Channel));
+				const float* Values = InChannelValues + Channel * InCount;
+				const float32x4_t Previous = vld1q_f32(Values + i - 1);
+				const float32x4_t Current = vld1q_f32(Values + i);
+
+				IsChanged = vorrq_u32(IsChanged, vandq_u32(
+					vmvnq_u32(vceqq_f32(Current, Previous)),
+					vmvnq_u32(vcleq_f32(vabdq_f32(Current, Previous), Tolerance))));
+			}
+			const std::uint32_t ChangedBits = vaddvq_u32(vandq_u32(IsChanged, LaneBits));
+#endif
+
+			const std::uint32_t CutBits = GapBits & ChangedBits;
+			for (std::int32_t Lane = 0; Lane < 4; ++Lane)
+			{
+				if ((CutBits >> Lane) & 1)
+				{
+					Emit(i + Lane);
+				}
+			}
+		}
+#endif
+
+		for (; i < InCount; ++i)
+		{
+			if (!IsWithinFrameGap(i))
+			{
+				continue;
+			}
+
+			for (std::int32_t Channel = 0; Channel < GCameraChannelCount; ++Channel)
+			{
+				const float* Values = InChannelValues + Channel * InCount;
+				if (IsChangedValue(Values[i - 1], Values[i], GetCameraCutTolerance(InThresholds, Channel)))
+				{
+					Emit(i);
+					break;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Keep mask of a single channel, bit i is set if ReduceKeys would keep key i
+	 *
+	 * OutKeepMask holds GetKeepMaskWordCount(InCount) words, bits past InCount are cleared.
+	 */
+	inline void ComputeKeepMask(const float* InValues, const std::int32_t InCount, std::uint64_t* OutKeepMask)
+	{
+		const std::int32_t WordCount = GetKeepMaskWordCount(InCount);
+		for (std::int32_t WordIndex = 0; WordIndex < WordCount; ++WordIndex)
+		{
+			OutKeepMask[WordIndex] = ~std::uint64_t(0);
+		}
+		if (InCount % 64 != 0)
+		{
+			OutKeepMask[WordCount - 1] = (std::uint64_t(1) << (InCount % 64)) - 1;
+		}
+
+		// clears the bits of redundant keys, Bits holds up to 4 keys starting at Index
+		const auto ClearBits = [OutKeepMask](const std::int32_t Index, const std::uint64_t Bits)
+		{
+			const std::int32_t Shift = Index & 63;
+			OutKeepMask[Index >> 6] &= ~(Bits << Shift);
+			if (60 < Shift)
+			{
+				OutKeepMask[(Index >> 6) + 1] &= ~(Bits >> (64 - Shift));
+			}
+		};
+
+		// a key is redundant if it equals both neighbours, the first and last key are always kept
+		std::int32_t i = 1;
+
+#if VMDCORE_SSE2
+		for (; i + 4 < InCount; i += 4)
+		{
+			const __m128 Previous = _mm_loadu_ps(InValues + i - 1);
+			const __m128 Current = _mm_loadu_ps(InValues + i);
+			const __m128 Next = _mm_loadu_ps(InValues + i + 1);
+
+			const int Redundant = _mm_movemask_ps(_mm_and_ps(_mm_cmpeq_ps(Previous, Current), _mm_cmpeq_ps(Current, Next)));
+			if (Redundant != 0)
+			{
+				ClearBits(i, static_cast<std::uint64_t>(Redundant));
+			}
+		}
+#elif VMDCORE_NEON
+		const uint32x4_t LaneBits = { 1, 2, 4, 8 };
+		for (; i + 4 < InCount; i += 4)
+		{
+			const float32x4_t Previous = vld1q_f32(InValues + i - 1);
+			const float32x4_t Current = vld1q_f32(InValues + i);
+			const float32x4_t Next = vld1q_f32(InValues + i + 1);
+
+			const uint32x4_t IsRedundant = vandq_u32(vceqq_f32(Previous, Current), vceqq_f32(Current, Next));
+			const std::uint32_t Redundant = vaddvq_u32(vandq_u32(IsRedundant, LaneBits));
+			if (Redundant != 0)
+			{
+				ClearBits(i, Redundant);
+			}
+		}
+#endif
+
+		for (; i < InCount - 1; ++i)
+		{
+			if (InValues[i - 1] == InValues[i] && InValues[i] == InValues[i + 1])
+			{
+				ClearBits(i, 1);
+			}
+		}
+	}
+
+	/**
+	 * Keep masks of every camera channel
+	 *
+	 * InChannelValues is the output of TransposeCameraKeyFrames, shared with DetectCameraCuts.
+	 * OutKeepMasks holds GCameraChannelCount * GetKeepMaskWordCount(InCount) words, channel c starts at c * GetKeepMaskWordCount(InCount).
+	 */
+	inline void ComputeCameraKeepMasks(const float* InChannelValues, const std::int32_t InCount, std::uint64_t* OutKeepMasks)
+	{
+		const std::int32_t WordCount = GetKeepMaskWordCount(InCount);
+		for (std::int32_t Channel = 0; Channel < GCameraChannelCount; ++Channel)
+		{
+			ComputeKeepMask(InChannelValues + Channel * InCount, InCount, OutKeepMasks + Channel * WordCount);
+		}
+	}
+
+	/**
+	 * Normalized MMD interpolation curve, a cubic bezier from (0, 0) to (1, 1) with control points (X1, Y1) and (X2, Y2) in 0 .. 1
+	 *
+	 * @return curve value at time fraction InTime
+	 */
+	inline double EvaluateInterpolationCurve(const double X1, const double Y1, const double X2, const double Y2, const double InTime)
+	{
+		if (X1 == Y1 && X2 == Y2)
+		{
+			return InTime;
+		}
+
+		const auto Bezier = [](const double P1, const double P2, const double S)
+		{
+			const double R = 1.0 - S;
+			return 3.0 * R * R * S * P1 + 3.0 * R * S * S * P2 + S * S * S;
+		};
+
+		// x(s) is monotonic for control points in 0 .. 1, newton steps that leave the bracket fall back to bisection
+		double Low = 0.0;
+		double High = 1.0;
+		double S = InTime;
+		for (std::int32_t Iteration = 0; Iteration < 32; ++Iteration)
+		{
+			const double Error = Bezier(X1, X2, S) - InTime;
+			if (std::abs(Error) < 1e-9)
+			{
+				break;
+			}
+
+			if (Error < 0.0)
+			{
+				Low = S;
+			}
+			else
+			{
+				High = S;
+			}
+
+			const double R = 1.0 - S;
+			const double Derivative = 3.0 * R * R * X1 + 6.0 * R * S * (X2 - X1) + 3.0 * S * S * (1.0 - X2);
+			const double Next = Derivative > 0.0 ? S - Error / Derivative : Low;
+			S = Low < Next && Next < High ? Next : (Low + High) * 0.5;
+		}
+
+		return Bezier(Y1, Y2, S);
+	}
+
+	/**
+	 * Channel value at InFrame between two keys, shaped by the interpolation bytes of InEnd the same way MMD does
+	 */
+	inline double EvaluateCameraSegment(
+		const FVmdObject::FCameraKeyFrame& InBegin,
+		const FVmdObject::FCameraKeyFrame& InEnd,
+		const double BeginValue,
+		const double EndValue,
+		const FTangentAccessIndices& InTangentAccessIndices,
+		const double InFrame
+	)
+	{
+		const double BeginFrame = static_cast<double>(InBegin.FrameNumber);
+		const double Span = static_cast<double>(InEnd.FrameNumber) - BeginFrame;
+		if (Span <= 0.0)
+		{
+			return EndValue;
+		}
+
+		const std::int8_t* Interpolation = InEnd.Interpolation;
+		const double Factor = EvaluateInterpolationCurve(
+			DecodeInterpolationFactor(Interpolation[InTangentAccessIndices.LeaveTangentX]),
+			DecodeInterpolationFactor(Interpolation[InTangentAccessIndices.LeaveTangentY]),
+			DecodeInterpolationFactor(Interpolation[InTangentAccessIndices.ArriveTangentX]),
+			DecodeInterpolationFactor(Interpolation[InTangentAccessIndices.ArriveTangentY]),
+			(InFrame - BeginFrame) / Span);
+
+		return BeginValue + (EndValue - BeginValue) * Factor;
+	}
+
+	// longest run of keys merged into one segment, bounds the cost of ComputeToleranceKeepMask
+	inline constexpr std::int32_t GToleranceMaxSpan = 64;
+
+	// most points between two keys the original curve is compared at, closer keys are compared at every frame
+	inline constexpr std::int32_t GToleranceMaxSamplesPerSegment = 16;
+
+	namespace Private
+	{
+		/** Largest difference between the original keys Begin .. End and one segment from Begin to End, stops early above InTolerance */
+		inline double ComputeMergedError(
+			const FVmdObject::FCameraKeyFrame* InKeys,
+			const double* InValues,
+			const FTangentAccessIndices& InTangentAccessIndices,
+			const std::int32_t Begin,
+			const std::int32_t End,
+			const double InTolerance
+		)
+		{
+			double MaxError = 0.0;
+
+			for (std::int32_t Key = Begin; Key < End; ++Key)
+			{
+				const double KeyFrame = static_cast<double>(InKeys[Key].FrameNumber);
+				const double Span = static_cast<double>(InKeys[Key + 1].FrameNumber) - KeyFrame;
+				const std::int32_t SampleCount = Span < GToleranceMaxSamplesPerSegment + 1 ? static_cast<std::int32_t>(Span) - 1 : GToleranceMaxSamplesPerSegment;
+
+				// the first sample of the merged segment is the begin key itself
+				for (std::int32_t Sample = Key == Begin ? 1 : 0; Sample <= SampleCount; ++Sample)
+				{
+					const double Frame = KeyFrame + Span * Sample / (SampleCount + 1);
+					const double Original = Sample == 0
+						? InValues[Key]
+						: EvaluateCameraSegment(InKeys[Key], InKeys[Key + 1], InValues[Key], InValues[Key + 1], InTangentAccessIndices, Frame);
+					const double Merged = EvaluateCameraSegment(InKeys[Begin], InKeys[End], InValues[Begin], InValues[End], InTangentAccessIndices, Frame);
+
+					const double Error = std::abs(Original - Merged);
+					if (!(Error <= InTolerance))
+					{
+						return Error;
+					}
+					MaxError = Error > MaxError ? Error : MaxError;
+				}
+			}
+
+			return MaxError;
+		}
+	}
+
+	/**
+	 * Keep mask of a single channel that drops keys as long as the merged curve stays within InTolerance of the original one
+	 *
+	 * InValues are the channel values in the unit InTolerance is given in.
+	 * The original curve is compared at every key and every frame in between, at most GToleranceMaxSamplesPerSegment points per pair of keys.
+	 * The first and last key and keys set in InPinnedMask are always kept, and no segment spans a pinned key.
+	 * OutKeepMask holds GetKeepMaskWordCount(InCount) words.
+	 *
+	 * @return largest error of the reduced curve at the compared points
+	 */
+	inline double ComputeToleranceKeepMask(
+		const FVmdObject::FCameraKeyFrame* InKeys,
+		const double* InValues,
+		const std::int32_t InCount,
+		const FTangentAccessIndices& InTangentAccessIndices,
+		const std::uint64_t* InPinnedMask,
+		const double InTolerance,
+		std::uint64_t* OutKeepMask
+	)
+	{
+		const std::int32_t WordCount = GetKeepMaskWordCount(InCount);
+		for (std::int32_t WordIndex = 0; WordIndex < WordCount; ++WordIndex)
+		{
+			OutKeepMask[WordIndex] = 0;
+		}
+
+		if (InCount == 0)
+		{
+			return 0.0;
+		}
+
+		SetKept(OutKeepMask, 0);
+
+		double MaxError = 0.0;
+		std::int32_t Begin = 0;
+		while (Begin < InCount - 1)
+		{
+			// greedily extend the segment until the next key would break the tolerance
+			std::int32_t End = Begin + 1;
+			double EndError = 0.0;
+			while (End + 1 < InCount && !IsKept(InPinnedMask, End) && End + 1 - Begin <= GToleranceMaxSpan)
+			{
+				const double Error = Private::ComputeMergedError(InKeys, InValues, InTangentAccessIndices, Begin, End + 1, InTolerance);
+				if (!(Error <= InTolerance))
+				{
+					break;
+				}
+
+				End += 1;
+				EndError = Error;
+			}
+
+			SetKept(OutKeepMask, End);
+			MaxError = EndError > MaxError ? EndError : MaxError;
+			Begin = End;
+		}
+
+		return MaxError;
+	}
+
+	struct FWeightedTangent
+	{
+		double Tangent;
+		double Weight;
+	};
+
+	/**
+	 * Weighted tangent of one side of a key
+	 *
+	 * DeltaSeconds and DeltaValue are the distance to the neighbour key, (1 / FrameRate, 0) if there is none.
+	 * FactorX and FactorY scale that distance to the bezier control point.
+	 */
+	inline FWeightedTangent ComputeWeightedTangent(
+		const double FactorX,
+		const double FactorY,
+		const double DeltaSeconds,
+		const double DeltaValue,
+		const double FrameRate
+	)
+	{
+		const double X = FactorX * DeltaSeconds;
+		const double Y = FactorY * DeltaValue;
+
+		FWeightedTangent Result;
+		if (X == 0.0)
+		{
+			Result.Tangent = Y < 0 ? -1.0 : 1.0;
+		}
+		else
+		{
+			Result.Tangent = Y / (X * FrameRate);
+		}
+		Result.Weight = std::sqrt(X * X + Y * Y);
+		return Result;
+	}
+}
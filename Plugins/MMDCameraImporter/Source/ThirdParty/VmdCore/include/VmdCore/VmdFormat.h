@@ -0,0 +1,374 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace VmdCore
+{
+	// TODO: little endian check
+
+#pragma pack (push, 1)
+	/**
+	 * Representation of raw VMD data
+	 */
+	struct FVmdObject
+	{
+		struct FHeader
+		{
+			std::uint8_t Magic[30]; // this value must be 'Vocaloid Motion Data 0002'
+			std::uint8_t ModelName[20];
+		};
+
+		// uint32 BoneKeyFrameCount; then FBoneKeyFrame[BoneKeyFrameCount]
+
+		struct FBoneKeyFrame
+		{
+			std::uint8_t BoneName[15];
+			std::uint32_t FrameNumber;
+			float Position[3];
+			float Rotation[4];
+			std::int8_t Interpolation[64];
+		};
+
+		// uint32 MorphKeyFrameCount; then FMorphKeyFrame[MorphKeyFrameCount]
+
+		struct FMorphKeyFrame
+		{
+			std::uint8_t MorphName[15];
+			std::uint32_t FrameNumber;
+			float Weight;
+		};
+
+		// uint32 CameraKeyFrameCount; then FCameraKeyFrame[CameraKeyFrameCount]
+
+		struct FCameraKeyFrame
+		{
+			std::uint32_t FrameNumber;
+			float Distance;
+			float Position[3];
+			float Rotation[3];
+			std::int8_t Interpolation[24];
+			std::uint32_t ViewAngle;
+			std::uint8_t Perspective; // this value can be reinterpret_cast to bool
+		};
+
+		// uint32 LightKeyFrameCount; then FLightKeyFrame[LightKeyFrameCount]
+
+		struct FLightKeyFrame
+		{
+			std::uint32_t FrameNumber;
+			float Color[3];
+			float Direction[3];
+		};
+
+		// uint32 SelfShadowKeyFrameCount; then FSelfShadowKeyFrame[SelfShadowKeyFrameCount]
+
+		struct FSelfShadowKeyFrame
+		{
+			std::uint32_t FrameNumber;
+			std::uint8_t Mode;
+			float Distance;
+		};
+
+		// uint32 PropertyKeyFrameCount; then FPropertyKeyFrame[PropertyKeyFrameCount]
+
+		struct FPropertyKeyFrame
+		{
+			std::uint32_t FrameNumber;
+			std::uint8_t Visible; // this value can be reinterpret_cast to bool
+
+			// uint32 IkStateCount; then FIkState[IkStateCount]
+
+			struct FIkState
+			{
+				std::uint8_t IkName[20];
+				std::uint8_t Enabled; // this value can be reinterpret_cast to bool
+			};
+		};
+	};
+#pragma pack (pop)
+
+	struct FSection
+	{
+		// offset of the first record, right after the count
+		std::int64_t Offset = 0;
+		std::uint32_t Count = 0;
+		// some VMD files end before the camera, self shadow or property section
+		bool bIsPresent = false;
+	};
+
+	// ik states that follow a single property key frame
+	struct FIkRun
+	{
+		// offset of the FVmdObject::FPropertyKeyFrame that owns this run
+		std::int64_t KeyFrameOffset = 0;
+		// offset of the first FVmdObject::FPropertyKeyFrame::FIkState
+		std::int64_t Offset = 0;
+		std::uint32_t Count = 0;
+	};
+
+	enum class EScanResult : std::uint8_t
+	{
+		Success,
+		FileTooSmall,
+		InvalidMagic,
+		BoneKeyFramesTruncated,
+		MorphKeyFramesTruncated,
+		CameraKeyFramesTruncated,
+		LightKeyFramesTruncated,
+		SelfShadowKeyFramesTruncated,
+		IkStateCountTruncated,
+		PropertyKeyFramesTruncated,
+	};
+
+	/**
+	 * Offset and count of every section, filled by ScanSections
+	 */
+	struct FSectionLayout
+	{
+		std::int64_t FileSize = 0;
+
+		FSection Header;
+
+		FSection BoneKeyFrames;
+
+		FSection MorphKeyFrames;
+
+		FSection CameraKeyFrames;
+
+		FSection LightKeyFrames;
+
+		FSection SelfShadowKeyFrames;
+
+		FSection PropertyKeyFrames;
+
+		// offset right after the last section, anything after this is additional data
+		std::int64_t EndOffset = 0;
+	};
+
+	inline constexpr char GMagicV2[] = "Vocaloid Motion Data 0002";
+
+	// legacy files written by early MikuMikuDance versions, the header is followed by a shorter model name
+	inline constexpr char GMagicV1[] = "Vocaloid Motion Data file";
+
+	enum class EFormatVersion : std::uint8_t
+	{
+		Unknown,
+		V1,
+		V2,
+	};
+
+	struct FSniffResult
+	{
+		EFormatVersion Version = EFormatVersion::Unknown;
+
+		// raw Shift-JIS model name, 10 bytes in v1 and 20 bytes in v2
+		std::uint8_t ModelName[20] = {};
+		std::int32_t ModelNameSize = 0;
+
+		// false if the file ends before the camera section or a preceding section is truncated
+		bool bHasCameraSection = false;
+		std::uint32_t CameraKeyFrameCount = 0;
+	};
+
+	/**
+	 * Classify a file from its header and section counts without scanning it
+	 *
+	 * At most four small reads, all within the first few hundred bytes for camera motion which has no bone or morph keys.
+	 * Read(Offset, Dest, Size) must read exactly Size bytes and return false on failure.
+	 */
+	template<typename ReadFuncType>
+	FSniffResult SniffFile(const std::int64_t InFileSize, ReadFuncType&& Read)
+	{
+		FSniffResult Result;
+
+		constexpr std::int64_t MagicSize = sizeof(FVmdObject::FHeader::Magic);
+
+		std::uint8_t Magic[MagicSize];
+		if (InFileSize < MagicSize || !Read(0, Magic, MagicSize))
+		{
+			return Result;
+		}
+
+		if (std::memcmp(Magic, GMagicV2, sizeof(GMagicV2) - 1) == 0)
+		{
+			Result.Version = EFormatVersion::V2;
+			Result.ModelNameSize = 20;
+		}
+		else if (std::memcmp(Magic, GMagicV1, sizeof(GMagicV1) - 1) == 0)
+		{
+			Result.Version = EFormatVersion::V1;
+			Result.ModelNameSize = 10;
+		}
+		else
+		{
+			return Result;
+		}
+
+		std::int64_t Offset = MagicSize;
+		if (InFileSize < Offset + Result.ModelNameSize || !Read(Offset, Result.ModelName, Result.ModelNameSize))
+		{
+			return Result;
+		}
+		Offset += Result.ModelNameSize;
+
+		// skips a section using its count, returns false if the section or its count is truncated
+		const auto SkipSection = [InFileSize, &Read, &Offset](const std::int64_t Stride)
+		{
+			std::uint32_t Count = 0;
+			if (InFileSize < Offset + static_cast<std::int64_t>(sizeof(std::uint32_t)) || !Read(Offset, &Count, sizeof(std::uint32_t)))
+			{
+				return false;
+			}
+			Offset += sizeof(std::uint32_t) + Stride * Count;
+			return Offset <= InFileSize;
+		};
+
+		if (!SkipSection(sizeof(FVmdObject::FBoneKeyFrame)) || !SkipSection(sizeof(FVmdObject::FMorphKeyFrame)))
+		{
+			return Result;
+		}
+
+		if (InFileSize < Offset + static_cast<std::int64_t>(sizeof(std::uint32_t)) || !Read(Offset, &Result.CameraKeyFrameCount, sizeof(std::uint32_t)))
+		{
+			return Result;
+		}
+		Result.bHasCameraSection = true;
+
+		return Result;
+	}
+
+	/**
+	 * Single scan over the section counts of a VMD file
+	 *
+	 * Read(Offset, Dest, Size) must read exactly Size bytes and return false on failure.
+	 * IkRuns receives one FIkRun per property key frame in file order, it needs Reserve(int) and Add(const FIkRun&).
+	 */
+	template<typename ReadFuncType, typename IkRunContainerType>
+	EScanResult ScanSections(const std::int64_t InFileSize, ReadFuncType&& Read, FSectionLayout& OutLayout, IkRunContainerType& OutIkRuns)
+	{
+		OutLayout = FSectionLayout();
+		OutLayout.FileSize = InFileSize;
+
+		if (InFileSize < static_cast<std::int64_t>(sizeof(FVmdObject::FHeader)))
+		{
+			return EScanResult::FileTooSmall;
+		}
+
+		std::uint8_t Magic[30];
+		if (!Read(0, Magic, sizeof(Magic)) ||
+			std::memcmp(Magic, GMagicV2, sizeof(GMagicV2) - 1) != 0)
+		{
+			return EScanResult::InvalidMagic;
+		}
+
+		OutLayout.Header.Offset = 0;
+		OutLayout.Header.Count = 1;
+		OutLayout.Header.bIsPresent = true;
+
+		std::int64_t Offset = sizeof(FVmdObject::FHeader);
+
+		const auto HasCount = [InFileSize, &Offset]
+		{
+			return Offset + static_cast<std::int64_t>(sizeof(std::uint32_t)) <= InFileSize;
+		};
+
+		// reads the count at Offset and advances Offset past the records, returns false if the records are truncated
+		const auto ScanSection = [InFileSize, &Read, &Offset, &HasCount](FSection& OutSection, const std::int64_t Stride)
+		{
+			std::uint32_t Count = 0;
+			if (!HasCount() || !Read(Offset, &Count, sizeof(std::uint32_t)))
+			{
+				return false;
+			}
+			Offset += sizeof(std::uint32_t);
+
+			OutSection.Offset = Offset;
+			OutSection.Count = Count;
+			OutSection.bIsPresent = true;
+
+			Offset += Stride * Count;
+			return Offset <= InFileSize;
+		};
+
+		if (!ScanSection(OutLayout.BoneKeyFrames, sizeof(FVmdObject::FBoneKeyFrame)))
+		{
+			return EScanResult::BoneKeyFramesTruncated;
+		}
+
+		if (!ScanSection(OutLayout.MorphKeyFrames, sizeof(FVmdObject::FMorphKeyFrame)))
+		{
+			return EScanResult::MorphKeyFramesTruncated;
+		}
+
+		// camera, light, self shadow and property sections are optional, a missing one is left with bIsPresent == false
+		if (!HasCount())
+		{
+			OutLayout.EndOffset = Offset;
+			return EScanResult::Success;
+		}
+
+		if (!ScanSection(OutLayout.CameraKeyFrames, sizeof(FVmdObject::FCameraKeyFrame)))
+		{
+			return EScanResult::CameraKeyFramesTruncated;
+		}
+
+		if (!ScanSection(OutLayout.LightKeyFrames, sizeof(FVmdObject::FLightKeyFrame)))
+		{
+			return EScanResult::LightKeyFramesTruncated;
+		}
+
+		if (!HasCount())
+		{
+			OutLayout.EndOffset = Offset;
+			return EScanResult::Success;
+		}
+
+		if (!ScanSection(OutLayout.SelfShadowKeyFrames, sizeof(FVmdObject::FSelfShadowKeyFrame)))
+		{
+			return EScanResult::SelfShadowKeyFramesTruncated;
+		}
+
+		if (!HasCount())
+		{
+			OutLayout.EndOffset = Offset;
+			return EScanResult::Success;
+		}
+
+		// property key frames are variable length, the stride is accumulated per ik run below
+		ScanSection(OutLayout.PropertyKeyFrames, 0);
+
+		// every property key frame takes at least its record and ik state count, don't trust a corrupt count for the reservation
+		constexpr std::int64_t MinPropertyKeyFrameSize = sizeof(FVmdObject::FPropertyKeyFrame) + sizeof(std::uint32_t);
+		OutIkRuns.Reserve(static_cast<std::int32_t>(std::min<std::int64_t>(OutLayout.PropertyKeyFrames.Count, (InFileSize - Offset) / MinPropertyKeyFrameSize)));
+
+		for (std::uint32_t i = 0; i < OutLayout.PropertyKeyFrames.Count; ++i)
+		{
+			FIkRun IkRun;
+			IkRun.KeyFrameOffset = Offset;
+			Offset += sizeof(FVmdObject::FPropertyKeyFrame);
+
+			if (!HasCount() || !Read(Offset, &IkRun.Count, sizeof(std::uint32_t)))
+			{
+				return EScanResult::IkStateCountTruncated;
+			}
+			Offset += sizeof(std::uint32_t);
+
+			IkRun.Offset = Offset;
+			Offset += sizeof(FVmdObject::FPropertyKeyFrame::FIkState) * static_cast<std::int64_t>(IkRun.Count);
+
+			OutIkRuns.Add(IkRun);
+		}
+
+		if (InFileSize < Offset)
+		{
+			return EScanResult::PropertyKeyFramesTruncated;
+		}
+
+		OutLayout.EndOffset = Offset;
+		return EScanResult::Success;
+	}
+}
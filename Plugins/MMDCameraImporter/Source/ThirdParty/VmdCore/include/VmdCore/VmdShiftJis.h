@@ -0,0 +1,194 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "ShiftJisConvertTable.h"
+#include "VmdSimd.h"
+
+namespace VmdCore
+{
+	namespace Private
+	{
+		/**
+		 * Bytes in 0x20 .. 0x7D except 0x5C decode to themselves,
+		 * 0x5C is yen, 0x7E is overline and control characters are left to GShiftJisSingleByteTable
+		 */
+		inline bool IsPlainAscii(const std::uint8_t InValue)
+		{
+			return 0x20 <= InValue && InValue <= 0x7D && InValue != 0x5C;
+		}
+
+		// true if all 8 bytes are plain ascii
+		inline bool IsPlainAsciiWord(const std::uint64_t InWord)
+		{
+			constexpr std::uint64_t Ones = 0x0101010101010101ull;
+			constexpr std::uint64_t HighBits = 0x8080808080808080ull;
+
+			// the range tests are exact for bytes below 0x80, anything else is rejected by HasHighBit
+			const std::uint64_t HasHighBit = InWord & HighBits;
+			const std::uint64_t HasLess = (InWord - Ones * 0x20) & ~InWord & HighBits;
+			const std::uint64_t HasMore = ((InWord + Ones * (0x7F - 0x7D)) | InWord) & HighBits;
+			const std::uint64_t Yen = InWord ^ (Ones * 0x5C);
+			const std::uint64_t HasYen = (Yen - Ones) & ~Yen & HighBits;
+
+			return (HasHighBit | HasLess | HasMore | HasYen) == 0;
+		}
+
+		/**
+		 * Widen the run of plain ascii at the start of InBuffer, 16 bytes at a time with SSE2 or NEON and 8 bytes at a time otherwise
+		 *
+		 * Must be called on a character boundary, trail bytes of double byte characters overlap the ascii range.
+		 *
+		 * @return number of bytes consumed, the same number of code units is written
+		 */
+		template<typename CharType>
+		std::int32_t WidenAsciiRun(const std::uint8_t* InBuffer, const std::int32_t InSize, CharType* OutBuffer)
+		{
+			std::int32_t Index = 0;
+
+#if VMDCORE_SSE2
+			if constexpr (sizeof(CharType) == 2)
+			{
+				const __m128i Lower = _mm_set1_epi8(0x20 - 1);
+				const __m128i Upper = _mm_set1_epi8(0x7D + 1);
+				const __m128i Yen = _mm_set1_epi8(0x5C);
+				const __m128i Zero = _mm_setzero_si128();
+
+				while (Index + 16 <= InSize)
+				{
+					const __m128i Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(InBuffer + Index));
+
+					// signed compare, bytes of 0x80 and above are negative and fail the lower bound
+					const __m128i IsPlain = _mm_andnot_si128(
+						_mm_cmpeq_epi8(Bytes, Yen),
+						_mm_and_si128(_mm_cmpgt_epi8(Bytes, Lower), _mm_cmplt_epi8(Bytes, Upper)));
+
+					if (_mm_movemask_epi8(IsPlain) != 0xFFFF)
+					{
+						break;
+					}
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(OutBuffer + Index), _mm_unpacklo_epi8(Bytes, Zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(OutBuffer + Index + 8), _mm_unpackhi_epi8(Bytes, Zero));
+					Index += 16;
+				}
+			}
+#elif VMDCORE_NEON
+			if constexpr (sizeof(CharType) == 2)
+			{
+				const uint8x16_t Lower = vdupq_n_u8(0x20);
+				const uint8x16_t Upper = vdupq_n_u8(0x7D);
+				const uint8x16_t Yen = vdupq_n_u8(0x5C);
+
+				while (Index + 16 <= InSize)
+				{
+					const uint8x16_t Bytes = vld1q_u8(InBuffer + Index);
+
+					const uint8x16_t IsPlain = vbicq_u8(
+						vandq_u8(vcgeq_u8(Bytes, Lower), vcleq_u8(Bytes, Upper)),
+						vceqq_u8(Bytes, Yen));
+
+					if (vminvq_u8(IsPlain) != 0xFF)
+					{
+						break;
+					}
+
+					vst1q_u16(reinterpret_cast<std::uint16_t*>(OutBuffer + Index), vmovl_u8(vget_low_u8(Bytes)));
+					vst1q_u16(reinterpret_cast<std::uint16_t*>(OutBuffer + Index + 8), vmovl_u8(vget_high_u8(Bytes)));
+					Index += 16;
+				}
+			}
+#endif
+
+			while (Index + 8 <= InSize)
+			{
+				std::uint64_t Word;
+				std::memcpy(&Word, InBuffer + Index, sizeof(Word));
+
+				if (!IsPlainAsciiWord(Word))
+				{
+					break;
+				}
+
+				for (std::int32_t i = 0; i < 8; ++i)
+				{
+					OutBuffer[Index + i] = static_cast<CharType>(InBuffer[Index + i]);
+				}
+				Index += 8;
+			}
+
+			return Index;
+		}
+	}
+
+	/**
+	 * Decode Shift-JIS (CP932) into UTF-16
+	 *
+	 * Every input byte produces at most one code unit, so OutBuffer must hold InSize code units.
+	 * Decoding stops at the first NUL, the padding of fixed width name fields is not decoded.
+	 * A lead byte at the end of the input or before the NUL is dropped.
+	 *
+	 * @return number of code units written
+	 */
+	template<typename CharType>
+	std::int32_t DecodeShiftJis(const std::uint8_t* InBuffer, const std::int32_t InSize, CharType* OutBuffer)
+	{
+		std::int32_t OutSize = 0;
+		std::int32_t IndexInput = 0;
+
+		while (IndexInput < InSize)
+		{
+			// ascii runs bypass the table, the loop head is always on a character boundary
+			if (Private::IsPlainAscii(InBuffer[IndexInput]))
+			{
+				const std::int32_t RunLength = Private::WidenAsciiRun(InBuffer + IndexInput, InSize - IndexInput, OutBuffer + OutSize);
+				IndexInput += RunLength;
+				OutSize += RunLength;
+
+				if (IndexInput >= InSize) break;
+			}
+
+			const std::uint8_t Lead = InBuffer[IndexInput];
+			if (Lead == 0) break;
+
+			const char16_t* Page = GShiftJisLeadPages.Pages[Lead];
+
+			char16_t UnicodeValue;
+			if (Page == nullptr)
+			{
+				UnicodeValue = GShiftJisSingleByteTable[Lead];
+				IndexInput += 1;
+			}
+			else
+			{
+				if (IndexInput + 1 >= InSize || InBuffer[IndexInput + 1] == 0) break;
+
+				// bytes below GShiftJisTrailBegin wrap around and fail the bound check
+				const std::uint32_t TrailIndex = static_cast<std::uint32_t>(InBuffer[IndexInput + 1]) - static_cast<std::uint32_t>(GShiftJisTrailBegin);
+				UnicodeValue = TrailIndex < static_cast<std::uint32_t>(GShiftJisPageSize) ? Page[TrailIndex] : char16_t(0x0020);
+				IndexInput += 2;
+			}
+
+			if (UnicodeValue != 0)
+			{
+				OutBuffer[OutSize] = static_cast<CharType>(UnicodeValue);
+				OutSize += 1;
+			}
+		}
+
+		return OutSize;
+	}
+
+	/** Length of a fixed width name field up to the first NUL */
+	inline std::int32_t GetFixedStringLength(const std::uint8_t* InBuffer, const std::int32_t InFieldSize)
+	{
+		const void* Terminator = std::memchr(InBuffer, 0, static_cast<std::size_t>(InFieldSize));
+		return Terminator != nullptr
+			? static_cast<std::int32_t>(static_cast<const std::uint8_t*>(Terminator) - InBuffer)
+			: InFieldSize;
+	}
+}
@@ -0,0 +1,542 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "VmdCore/VmdCameraMath.h"
+#include "VmdCore/VmdFormat.h"
+#include "VmdCore/VmdShiftJis.h"
+
+#include "Cp932ExtensionTable.h"
+#include "LegacyShiftJisConvertTable.h"
+
+namespace
+{
+	using namespace VmdCore;
+
+	std::int32_t GFailureCount = 0;
+
+#define VMDCORE_CHECK(Expression) \
+	do \
+	{ \
+		if (!(Expression)) \
+		{ \
+			std::fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #Expression); \
+			++GFailureCount; \
+		} \
+	} while (false)
+
+	/** Minimal IkRunContainerType for ScanSections */
+	struct FIkRunArray
+	{
+		std::vector<FIkRun> Runs;
+
+		void Reserve(const std::int32_t InCount) { Runs.reserve(static_cast<std::size_t>(InCount)); }
+		void Add(const FIkRun& InRun) { Runs.push_back(InRun); }
+	};
+
+	/** In-memory VMD file built section by section */
+	struct FVmdWriter
+	{
+		std::vector<std::uint8_t> Bytes;
+
+		void Write(const void* InData, const std::size_t InSize)
+		{
+			const std::uint8_t* Data = static_cast<const std::uint8_t*>(InData);
+			Bytes.insert(Bytes.end(), Data, Data + InSize);
+		}
+
+		void WriteHeader()
+		{
+			FVmdObject::FHeader Header = {};
+			std::memcpy(Header.Magic, GMagicV2, sizeof(GMagicV2) - 1);
+			Write(&Header, sizeof(Header));
+		}
+
+		void WriteCount(const std::uint32_t InCount)
+		{
+			Write(&InCount, sizeof(InCount));
+		}
+
+		template<typename KeyFrameType>
+		void WriteSection(const std::uint32_t InCount)
+		{
+			WriteCount(InCount);
+			const KeyFrameType KeyFrame = {};
+			for (std::uint32_t i = 0; i < InCount; ++i)
+			{
+				Write(&KeyFrame, sizeof(KeyFrame));
+			}
+		}
+
+		EScanResult Scan(FSectionLayout& OutLayout, FIkRunArray& OutIkRuns) const
+		{
+			const auto Read = [this](const std::int64_t InOffset, void* OutDest, const std::int64_t InSize)
+			{
+				if (InOffset < 0 || static_cast<std::int64_t>(Bytes.size()) < InOffset + InSize)
+				{
+					return false;
+				}
+				std::memcpy(OutDest, Bytes.data() + InOffset, static_cast<std::size_t>(InSize));
+				return true;
+			};
+			return ScanSections(static_cast<std::int64_t>(Bytes.size()), Read, OutLayout, OutIkRuns);
+		}
+	};
+
+	/** Camera keys with long static runs, repeated values and frame gaps, the shape key reduction and cut detection see in practice */
+	std::vector<FVmdObject::FCameraKeyFrame> MakeCameraKeyFrames(std::mt19937& Random, const std::int32_t InCount)
+	{
+		std::vector<FVmdObject::FCameraKeyFrame> KeyFrames(static_cast<std::size_t>(InCount));
+
+		std::uint32_t FrameNumber = 0;
+		for (std::int32_t i = 0; i < InCount; ++i)
+		{
+			FVmdObject::FCameraKeyFrame& KeyFrame = KeyFrames[static_cast<std::size_t>(i)];
+			std::memset(&KeyFrame, 0, sizeof(KeyFrame));
+
+			FrameNumber += i == 0 ? 0 : Random() % 4;
+			KeyFrame.FrameNumber = FrameNumber;
+
+			const float Base = static_cast<float>(Random() % 3) * 0.01f;
+			KeyFrame.Distance = Random() % 2 ? Base : 0.0f;
+			KeyFrame.Position[0] = Random() % 5 == 0 ? Base * 2.0f : 0.0f;
+			KeyFrame.Position[1] = Random() % 3 == 0 ? Base : 0.0f;
+			KeyFrame.Rotation[1] = Random() % 4 == 0 ? Base * 3.0f : 0.0f;
+			KeyFrame.Rotation[2] = Random() % 7 == 0 ? std::numeric_limits<float>::quiet_NaN() : 0.0f;
+			KeyFrame.ViewAngle = 30 + (Random() % 4 == 0 ? 1 : 0);
+		}
+
+		return KeyFrames;
+	}
+
+	void TestScanSections()
+	{
+		// complete file, two property key frames with one and zero ik states
+		{
+			FVmdWriter Writer;
+			Writer.WriteHeader();
+			Writer.WriteSection<FVmdObject::FBoneKeyFrame>(2);
+			Writer.WriteSection<FVmdObject::FMorphKeyFrame>(1);
+			Writer.WriteSection<FVmdObject::FCameraKeyFrame>(3);
+			Writer.WriteSection<FVmdObject::FLightKeyFrame>(1);
+			Writer.WriteSection<FVmdObject::FSelfShadowKeyFrame>(0);
+			Writer.WriteCount(2);
+			const FVmdObject::FPropertyKeyFrame PropertyKeyFrame = {};
+			const FVmdObject::FPropertyKeyFrame::FIkState IkState = {};
+			Writer.Write(&PropertyKeyFrame, sizeof(PropertyKeyFrame));
+			Writer.WriteCount(1);
+			Writer.Write(&IkState, sizeof(IkState));
+			Writer.Write(&PropertyKeyFrame, sizeof(PropertyKeyFrame));
+			Writer.WriteCount(0);
+
+			FSectionLayout Layout;
+			FIkRunArray IkRuns;
+			VMDCORE_CHECK(Writer.Scan(Layout, IkRuns) == EScanResult::Success);
+
+			const std::int64_t BoneOffset = sizeof(FVmdObject::FHeader) + sizeof(std::uint32_t);
+			const std::int64_t MorphOffset = BoneOffset + 2 * sizeof(FVmdObject::FBoneKeyFrame) + sizeof(std::uint32_t);
+			const std::int64_t CameraOffset = MorphOffset + sizeof(FVmdObject::FMorphKeyFrame) + sizeof(std::uint32_t);
+
+			VMDCORE_CHECK(Layout.BoneKeyFrames.Offset == BoneOffset && Layout.BoneKeyFrames.Count == 2);
+			VMDCORE_CHECK(Layout.MorphKeyFrames.Offset == MorphOffset && Layout.MorphKeyFrames.Count == 1);
+			VMDCORE_CHECK(Layout.CameraKeyFrames.bIsPresent && Layout.CameraKeyFrames.Offset == CameraOffset && Layout.CameraKeyFrames.Count == 3);
+			VMDCORE_CHECK(Layout.LightKeyFrames.Count == 1);
+			VMDCORE_CHECK(Layout.SelfShadowKeyFrames.bIsPresent && Layout.SelfShadowKeyFrames.Count == 0);
+			VMDCORE_CHECK(Layout.PropertyKeyFrames.Count == 2);
+			VMDCORE_CHECK(Layout.EndOffset == static_cast<std::int64_t>(Writer.Bytes.size()));
+
+			VMDCORE_CHECK(IkRuns.Runs.size() == 2);
+			if (IkRuns.Runs.size() == 2)
+			{
+				VMDCORE_CHECK(IkRuns.Runs[0].KeyFrameOffset == Layout.PropertyKeyFrames.Offset && IkRuns.Runs[0].Count == 1);
+				VMDCORE_CHECK(IkRuns.Runs[1].Offset == IkRuns.Runs[0].Offset + static_cast<std::int64_t>(sizeof(IkState)) + 4 + static_cast<std::int64_t>(sizeof(PropertyKeyFrame)));
+				VMDCORE_CHECK(IkRuns.Runs[1].Count == 0);
+			}
+		}
+
+		// motion files may end right after the morph section
+		{
+			FVmdWriter Writer;
+			Writer.WriteHeader();
+			Writer.WriteSection<FVmdObject::FBoneKeyFrame>(0);
+			Writer.WriteSection<FVmdObject::FMorphKeyFrame>(0);
+
+			FSectionLayout Layout;
+			FIkRunArray IkRuns;
+			VMDCORE_CHECK(Writer.Scan(Layout, IkRuns) == EScanResult::Success);
+			VMDCORE_CHECK(!Layout.CameraKeyFrames.bIsPresent);
+			VMDCORE_CHECK(Layout.EndOffset == static_cast<std::int64_t>(Writer.Bytes.size()));
+		}
+
+		// a count past the end of the file
+		{
+			FVmdWriter Writer;
+			Writer.WriteHeader();
+			Writer.WriteSection<FVmdObject::FBoneKeyFrame>(0);
+			Writer.WriteSection<FVmdObject::FMorphKeyFrame>(0);
+			Writer.WriteSection<FVmdObject::FCameraKeyFrame>(2);
+			Writer.Bytes.resize(Writer.Bytes.size() - 1);
+
+			FSectionLayout Layout;
+			FIkRunArray IkRuns;
+			VMDCORE_CHECK(Writer.Scan(Layout, IkRuns) == EScanResult::CameraKeyFramesTruncated);
+		}
+
+		{
+			FVmdWriter Writer;
+			Writer.WriteHeader();
+			Writer.Bytes[0] = 'X';
+
+			FSectionLayout Layout;
+			FIkRunArray IkRuns;
+			VMDCORE_CHECK(Writer.Scan(Layout, IkRuns) == EScanResult::InvalidMagic);
+
+			Writer.Bytes.resize(10);
+			VMDCORE_CHECK(Writer.Scan(Layout, IkRuns) == EScanResult::FileTooSmall);
+		}
+	}
+
+	void TestDetectCameraCuts()
+	{
+		std::mt19937 Random(1);
+
+		for (std::int32_t Trial = 0; Trial < 2000; ++Trial)
+		{
+			const std::int32_t Count = static_cast<std::int32_t>(Random() % 200);
+			const std::vector<FVmdObject::FCameraKeyFrame> KeyFrames = MakeCameraKeyFrames(Random, Count);
+
+			FCameraCutThresholds Thresholds;
+			Thresholds.PositionTolerance = static_cast<float>(Trial % 3) * 0.015f;
+			Thresholds.AngleTolerance = static_cast<float>(Trial % 5) * 0.01f;
+			Thresholds.ViewAngleTolerance = static_cast<float>(Trial % 2) * 1.5f;
+			Thresholds.MaxFrameGap = Trial % 4 == 3 ? 5 : 1 + Trial % 4;
+
+			// tolerances larger than most steps of the generated motion
+			if (Trial % 7 == 0)
+			{
+				Thresholds.PositionTolerance = 10.0f;
+				Thresholds.AngleTolerance = 10.0f;
+				Thresholds.ViewAngleTolerance = 10.0f;
+			}
+
+			std::vector<float> ChannelValues(static_cast<std::size_t>(GCameraChannelCount * Count));
+			TransposeCameraKeyFrames(KeyFrames.data(), Count, ChannelValues.data());
+
+			std::vector<std::int32_t> Detected;
+			DetectCameraCuts(KeyFrames.data(), ChannelValues.data(), Count, Thresholds, [&Detected](const std::int32_t Index)
+			{
+				Detected.push_back(Index);
+			});
+
+			std::vector<std::int32_t> Expected;
+			for (std::int32_t i = 1; i < Count; ++i)
+			{
+				if (IsCameraCut(KeyFrames[static_cast<std::size_t>(i - 1)], KeyFrames[static_cast<std::size_t>(i)], Thresholds))
+				{
+					Expected.push_back(i);
+				}
+			}
+
+			VMDCORE_CHECK(Detected == Expected);
+		}
+	}
+
+	void TestComputeKeepMask()
+	{
+		std::mt19937 Random(2);
+
+		for (std::int32_t Count = 0; Count < 300; ++Count)
+		{
+			std::vector<float> Values(static_cast<std::size_t>(Count));
+			for (float& Value : Values)
+			{
+				const std::uint32_t Kind = Random() % 8;
+				Value = Kind == 0 ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(Kind / 3);
+			}
+
+			const std::int32_t WordCount = GetKeepMaskWordCount(Count);
+			std::vector<std::uint64_t> KeepMask(static_cast<std::size_t>(WordCount) + 1, 0xA5A5A5A5A5A5A5A5ull);
+			ComputeKeepMask(Values.data(), Count, KeepMask.data());
+
+			// first and last key are kept, everything else only if it differs from a neighbour, NaN never equals
+			for (std::int32_t i = 0; i < Count; ++i)
+			{
+				const bool bExpected = i == 0 || i == Count - 1 || !(Values[i - 1] == Values[i] && Values[i] == Values[i + 1]);
+				VMDCORE_CHECK(IsKept(KeepMask.data(), i) == bExpected);
+			}
+
+			for (std::int32_t i = Count; i < WordCount * 64; ++i)
+			{
+				VMDCORE_CHECK(!IsKept(KeepMask.data(), i));
+			}
+			VMDCORE_CHECK(KeepMask[static_cast<std::size_t>(WordCount)] == 0xA5A5A5A5A5A5A5A5ull);
+
+			// the keys of a cut are only pinned where the value steps, which the keep mask already keeps
+			std::vector<std::int32_t> CutIndices;
+			for (std::int32_t i = 1; i < Count; ++i)
+			{
+				if (Random() % 4 == 0)
+				{
+					CutIndices.push_back(i);
+				}
+			}
+
+			std::vector<std::uint64_t> CutKeyMask(static_cast<std::size_t>(WordCount));
+			ComputeCameraCutKeyMask(Values.data(), CutIndices.data(), static_cast<std::int32_t>(CutIndices.size()), Count, CutKeyMask.data());
+
+			std::vector<bool> ExpectedPinned(static_cast<std::size_t>(Count));
+			for (const std::int32_t Index : CutIndices)
+			{
+				if (!(Values[static_cast<std::size_t>(Index - 1)] == Values[static_cast<std::size_t>(Index)]))
+				{
+					ExpectedPinned[static_cast<std::size_t>(Index - 1)] = true;
+					ExpectedPinned[static_cast<std::size_t>(Index)] = true;
+				}
+			}
+
+			for (std::int32_t i = 0; i < Count; ++i)
+			{
+				VMDCORE_CHECK(IsKept(CutKeyMask.data(), i) == ExpectedPinned[static_cast<std::size_t>(i)]);
+				VMDCORE_CHECK(!IsKept(CutKeyMask.data(), i) || IsKept(KeepMask.data(), i));
+			}
+		}
+	}
+
+	void TestComputeWeightedTangent()
+	{
+		constexpr double FrameRate = 30.0;
+
+		// linear segment, the default interpolation 20/20 scaled to 0 .. 1
+		{
+			const FWeightedTangent Tangent = ComputeWeightedTangent(20.0 / 127.0, 20.0 / 127.0, 1.0, 60.0, FrameRate);
+			VMDCORE_CHECK(std::abs(Tangent.Tangent - 2.0) < 1e-12);
+			const double X = 20.0 / 127.0;
+			const double Y = 20.0 / 127.0 * 60.0;
+			VMDCORE_CHECK(std::abs(Tangent.Weight - std::sqrt(X * X + Y * Y)) < 1e-12);
+		}
+
+		// a zero time factor gives a vertical tangent with the sign of the value change
+		{
+			VMDCORE_CHECK(ComputeWeightedTangent(0.0, 0.5, 1.0, -4.0, FrameRate).Tangent == -1.0);
+			VMDCORE_CHECK(ComputeWeightedTangent(0.0, 0.5, 1.0, 4.0, FrameRate).Tangent == 1.0);
+			VMDCORE_CHECK(ComputeWeightedTangent(0.0, 0.5, 1.0, 4.0, FrameRate).Weight == 2.0);
+		}
+
+		// no neighbour key, a flat tangent one frame long
+		{
+			const FWeightedTangent Tangent = ComputeWeightedTangent(0.25, 0.25, 1.0 / FrameRate, 0.0, FrameRate);
+			VMDCORE_CHECK(Tangent.Tangent == 0.0);
+			VMDCORE_CHECK(std::abs(Tangent.Weight - 0.25 / FrameRate) < 1e-15);
+		}
+	}
+
+	/** Decodes InBytes and returns the code units */
+	std::vector<char16_t> Decode(const std::vector<std::uint8_t>& InBytes)
+	{
+		std::vector<char16_t> Result(InBytes.size());
+		Result.resize(static_cast<std::size_t>(DecodeShiftJis(InBytes.data(), static_cast<std::int32_t>(InBytes.size()), Result.data())));
+		return Result;
+	}
+
+	void TestDecodeShiftJis()
+	{
+		// long enough for the ascii run fast path, 0x5C and 0x7E are not plain ascii
+		VMDCORE_CHECK(Decode({ 'c', 'a', 'm', 'e', 'r', 'a', '_', '0', '1', '2', '3', 0x5C, 0x7E }) == std::vector<char16_t>({ u'c', u'a', u'm', u'e', u'r', u'a', u'_', u'0', u'1', u'2', u'3', 0x00A5, 0x203E }));
+
+		// "カメラ" and half width katakana
+		VMDCORE_CHECK(Decode({ 0x83, 0x4A, 0x83, 0x81, 0x83, 0x89 }) == std::vector<char16_t>({ 0x30AB, 0x30E1, 0x30E9 }));
+		VMDCORE_CHECK(Decode({ 0xB6, 0xD2, 0xD7 }) == std::vector<char16_t>({ 0xFF76, 0xFF92, 0xFF97 }));
+
+		// kanji from both lead byte ranges
+		VMDCORE_CHECK(Decode({ 0x88, 0x9F, 0xE8, 0x40 }) == std::vector<char16_t>({ 0x4E9C, 0x9319 }));
+
+		// a trailing lead byte is dropped
+		VMDCORE_CHECK(Decode({ 'A', 'B', 0x83 }) == std::vector<char16_t>({ u'A', u'B' }));
+
+		// decoding stops at the first NUL, a lead byte before it is dropped
+		VMDCORE_CHECK(Decode({ 'A', 0x00, 'B', 0x83 }) == std::vector<char16_t>({ u'A' }));
+		VMDCORE_CHECK(Decode({ 'A', 0x83, 0x00, 0x83, 0x4A }) == std::vector<char16_t>({ u'A' }));
+		VMDCORE_CHECK(Decode({ 'c', 'a', 'm', 'e', 'r', 'a', '_', '0', 0x00, 'x', 'x', 'x', 'x', 'x', 'x', 'x', 'x' }) == std::vector<char16_t>({ u'c', u'a', u'm', u'e', u'r', u'a', u'_', u'0' }));
+
+		// a trail byte out of range decodes to a space and is consumed
+		VMDCORE_CHECK(Decode({ 0x83, 0x20, 'A' }) == std::vector<char16_t>({ 0x0020, u'A' }));
+
+		const std::uint8_t Name[20] = { 'C', 'a', 'm', 0x00, 'x' };
+		VMDCORE_CHECK(GetFixedStringLength(Name, 20) == 3);
+		VMDCORE_CHECK(GetFixedStringLength(Name, 3) == 3);
+	}
+
+	/** DecodeShiftJis as it was with GLegacyShiftJisConvertTable, without the ascii fast path which decodes the same */
+	std::vector<char16_t> DecodeLegacy(const std::vector<std::uint8_t>& InBytes)
+	{
+		std::vector<char16_t> Result;
+
+		std::size_t IndexInput = 0;
+		while (IndexInput < InBytes.size())
+		{
+			const std::uint8_t ArraySection = InBytes[IndexInput] >> 4;
+
+			std::int32_t ArrayOffset;
+			if (ArraySection == 0x8) ArrayOffset = 0x100;
+			else if (ArraySection == 0x9) ArrayOffset = 0x1100;
+			else if (ArraySection == 0xE) ArrayOffset = 0x2100;
+			else ArrayOffset = 0;
+
+			if (ArrayOffset)
+			{
+				ArrayOffset += (InBytes[IndexInput] & 0xf) << 8;
+				IndexInput += 1;
+				if (IndexInput >= InBytes.size()) break;
+			}
+			ArrayOffset += InBytes[IndexInput];
+			IndexInput += 1;
+			ArrayOffset <<= 1;
+
+			const char16_t UnicodeValue = static_cast<char16_t>((GLegacyShiftJisConvertTable[ArrayOffset] << 8) | GLegacyShiftJisConvertTable[ArrayOffset + 1]);
+			if (UnicodeValue != 0)
+			{
+				Result.push_back(UnicodeValue);
+			}
+		}
+
+		return Result;
+	}
+
+	/** The bytes before the first NUL, where DecodeShiftJis stops */
+	std::vector<std::uint8_t> TruncateAtNul(const std::vector<std::uint8_t>& InBytes)
+	{
+		return std::vector<std::uint8_t>(InBytes.begin(), std::find(InBytes.begin(), InBytes.end(), std::uint8_t(0)));
+	}
+
+	/** Code unit CP932 assigns to a lead byte the legacy table has no characters for, InTrail in 0x40 .. 0xFC */
+	char16_t GetCp932ExtensionCodePoint(const std::uint8_t InLead, const std::uint8_t InTrail)
+	{
+		// user defined area, 188 characters per lead byte, trail byte 0x7F is unassigned
+		if (0xF0 <= InLead && InLead <= 0xF9)
+		{
+			if (InTrail == 0x7F)
+			{
+				return 0x0020;
+			}
+			const std::int32_t TrailIndex = InTrail - 0x40 - (InTrail > 0x7F ? 1 : 0);
+			return static_cast<char16_t>(0xE000 + (InLead - 0xF0) * 188 + TrailIndex);
+		}
+
+		for (const FCp932ExtensionRow& Row : GCp932ExtensionRows)
+		{
+			if (Row.Lead == InLead)
+			{
+				return Row.CodePoints[InTrail - 0x40];
+			}
+		}
+		return 0;
+	}
+
+	bool IsCp932ExtensionLead(const std::uint8_t InLead)
+	{
+		return InLead == 0x87 || InLead == 0xED || InLead == 0xEE || (0xF0 <= InLead && InLead <= 0xFC);
+	}
+
+	/**
+	 * Every byte pair decodes as it did with the legacy table, except for the CP932 rows the legacy table lacked.
+	 * Those decode to the expected CP932 code point, and lead bytes 0xF0 .. 0xFC now consume their trail byte.
+	 * The legacy decoder skipped NUL and went on, the input it is given ends before the NUL instead.
+	 */
+	void TestDecodeShiftJisLegacyTable()
+	{
+		for (std::int32_t Lead = 0; Lead < 256; ++Lead)
+		{
+			const std::uint8_t LeadByte = static_cast<std::uint8_t>(Lead);
+
+			// a lone lead byte at the end of the input is dropped, F0 .. FC used to decode as single bytes
+			if (0xF0 <= Lead && Lead <= 0xFC)
+			{
+				VMDCORE_CHECK(Decode({ LeadByte }).empty());
+			}
+			else
+			{
+				VMDCORE_CHECK(Decode({ LeadByte }) == DecodeLegacy({ LeadByte }));
+			}
+
+			for (std::int32_t Trail = 0; Trail < 256; ++Trail)
+			{
+				const std::vector<std::uint8_t> Bytes = { LeadByte, static_cast<std::uint8_t>(Trail) };
+				const std::vector<char16_t> Decoded = Decode(Bytes);
+
+				if (!IsCp932ExtensionLead(LeadByte))
+				{
+					// a single byte code followed by one of the new lead bytes, which is now dropped as a lone lead byte
+					const bool bLegacyLead = (Lead >> 4) == 0x8 || (Lead >> 4) == 0x9 || (Lead >> 4) == 0xE;
+					const bool bTrailIsNewLead = 0xF0 <= Trail && Trail <= 0xFC;
+					VMDCORE_CHECK(Decoded == DecodeLegacy(TruncateAtNul(!bLegacyLead && bTrailIsNewLead ? std::vector<std::uint8_t>({ LeadByte }) : Bytes)));
+				}
+				else if (Trail == 0)
+				{
+					VMDCORE_CHECK(Decoded.empty());
+				}
+				else if (Trail < 0x40 || 0xFC < Trail)
+				{
+					VMDCORE_CHECK(Decoded == std::vector<char16_t>({ 0x0020 }));
+				}
+				else
+				{
+					VMDCORE_CHECK(Decoded == std::vector<char16_t>({ GetCp932ExtensionCodePoint(LeadByte, static_cast<std::uint8_t>(Trail)) }));
+				}
+			}
+		}
+
+		// spot checks of the expected rows against well known characters
+		VMDCORE_CHECK(GetCp932ExtensionCodePoint(0x87, 0x40) == 0x2460);
+		VMDCORE_CHECK(GetCp932ExtensionCodePoint(0xED, 0x40) == 0x7E8A);
+		VMDCORE_CHECK(GetCp932ExtensionCodePoint(0xF0, 0x40) == 0xE000);
+		VMDCORE_CHECK(GetCp932ExtensionCodePoint(0xF9, 0xFC) == 0xE757);
+		VMDCORE_CHECK(GetCp932ExtensionCodePoint(0xFA, 0x40) == 0x2170);
+		VMDCORE_CHECK(GetCp932ExtensionCodePoint(0xFC, 0x4B) == 0x9ED1);
+	}
+
+	struct FTestCase
+	{
+		const char* Name;
+		void (*Run)();
+	};
+
+	constexpr FTestCase GTestCases[] =
+	{
+		{ "ScanSections", TestScanSections },
+		{ "DetectCameraCuts", TestDetectCameraCuts },
+		{ "ComputeKeepMask", TestComputeKeepMask },
+		{ "ComputeWeightedTangent", TestComputeWeightedTangent },
+		{ "DecodeShiftJis", TestDecodeShiftJis },
+		{ "DecodeShiftJisLegacyTable", TestDecodeShiftJisLegacyTable },
+	};
+}
+
+/** Runs the test named by the first argument, or every test without one */
+int main(int ArgCount, char** Args)
+{
+	bool bFound = false;
+	for (const FTestCase& TestCase : GTestCases)
+	{
+		if (ArgCount < 2 || std::strcmp(Args[1], TestCase.Name) == 0)
+		{
+			bFound = true;
+			const std::int32_t FailuresBefore = GFailureCount;
+			TestCase.Run();
+			std::printf("%s: %s\n", TestCase.Name, GFailureCount == FailuresBefore ? "passed" : "FAILED");
+		}
+	}
+
+	if (!bFound)
+	{
+		std::fprintf(stderr, "unknown test %s\n", Args[1]);
+		return 2;
+	}
+	return GFailureCount == 0 ? 0 : 1;
+}